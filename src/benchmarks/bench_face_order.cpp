@@ -0,0 +1,198 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+// Effect of the face order on a neighbour-heavy kernel. The kernel gathers several variables from the 3 face neighbours,
+// like PBSM3D's assembly or snow_slide's redistribution, from columns laid out in face order as the face variables are.
+// The terrain is a synthetic n x n grid, two triangles per grid cell. The mesher's order is stood in for by a random
+// shuffle, which is the worst case; a row-major order is also shown as it is what a structured mesher would give.
+//
+// Usage: bench_face_order [n] [sweeps] [nvar]
+
+#include "math/space_filling_curve.hpp"
+#include "logger.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+struct face_mesh
+{
+    std::vector<double> x, y;                   // centroids
+    std::vector<std::array<int, 3>> neighbors;  // -1 for none
+};
+
+static face_mesh make_grid(size_t n)
+{
+    face_mesh m;
+    m.x.resize(2 * n * n);
+    m.y.resize(2 * n * n);
+    m.neighbors.resize(2 * n * n);
+
+    // cell (i,j) holds triangle a (lower right, 2*(i*n+j)) and b (upper left, 2*(i*n+j)+1)
+    auto id = [n](size_t i, size_t j, int t) { return static_cast<int>(2 * (i * n + j) + t); };
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            int a = id(i, j, 0);
+            int b = id(i, j, 1);
+            m.x[a] = i + 2.0 / 3;
+            m.y[a] = j + 1.0 / 3;
+            m.x[b] = i + 1.0 / 3;
+            m.y[b] = j + 2.0 / 3;
+
+            m.neighbors[a] = {b, j > 0 ? id(i, j - 1, 1) : -1, i + 1 < n ? id(i + 1, j, 1) : -1};
+            m.neighbors[b] = {a, j + 1 < n ? id(i, j + 1, 0) : -1, i > 0 ? id(i - 1, j, 0) : -1};
+        }
+    }
+    return m;
+}
+
+// renumber the mesh so that new face k is old face permutation[k], as triangulation::reorder_faces
+static face_mesh permute(const face_mesh& m, const std::vector<size_t>& permutation)
+{
+    std::vector<int> new_id(permutation.size());
+    for (size_t k = 0; k < permutation.size(); ++k)
+        new_id[permutation[k]] = static_cast<int>(k);
+
+    face_mesh p;
+    p.x.resize(m.x.size());
+    p.y.resize(m.y.size());
+    p.neighbors.resize(m.neighbors.size());
+    for (size_t k = 0; k < permutation.size(); ++k)
+    {
+        size_t old = permutation[k];
+        p.x[k] = m.x[old];
+        p.y[k] = m.y[old];
+        for (int j = 0; j < 3; ++j)
+            p.neighbors[k][j] = m.neighbors[old][j] < 0 ? -1 : new_id[m.neighbors[old][j]];
+    }
+    return p;
+}
+
+// mean |face - neighbour| index distance, i.e., how far apart in memory neighbouring faces are
+static double mean_stride(const face_mesh& m)
+{
+    double sum = 0;
+    size_t count = 0;
+    for (size_t i = 0; i < m.neighbors.size(); ++i)
+    {
+        for (auto n : m.neighbors[i])
+        {
+            if (n < 0)
+                continue;
+            sum += std::abs(static_cast<double>(n) - static_cast<double>(i));
+            ++count;
+        }
+    }
+    return count > 0 ? sum / count : 0;
+}
+
+// each sweep relaxes every variable toward its neighbour mean, writing into a second set of columns
+static double run(const face_mesh& m, size_t sweeps, size_t nvar, double& checksum)
+{
+    const size_t nface = m.neighbors.size();
+    std::vector<double> in(nvar * nface), out(nvar * nface);
+    for (size_t v = 0; v < nvar; ++v)
+        for (size_t i = 0; i < nface; ++i)
+            in[v * nface + i] = std::sin(0.01 * m.x[i] * (v + 1)) + std::cos(0.013 * m.y[i]);
+
+    timer c;
+    c.tic();
+    for (size_t s = 0; s < sweeps; ++s)
+    {
+#pragma omp parallel for
+        for (size_t i = 0; i < nface; ++i)
+        {
+            for (size_t v = 0; v < nvar; ++v)
+            {
+                const double* col = &in[v * nface];
+                double sum = 0;
+                int count = 0;
+                for (auto n : m.neighbors[i])
+                {
+                    if (n < 0)
+                        continue;
+                    sum += col[n];
+                    ++count;
+                }
+                out[v * nface + i] = 0.5 * col[i] + 0.5 * sum / count;
+            }
+        }
+        in.swap(out);
+    }
+    double t = c.toc<ms>();
+
+    // order independent so the runs can be compared
+    checksum = std::accumulate(in.begin(), in.end(), 0.0);
+    return t;
+}
+
+int main(int argc, char** argv)
+{
+    logging::core::get()->set_logging_enabled(false);
+
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t sweeps = argc > 2 ? std::stoul(argv[2]) : 20;
+    size_t nvar = argc > 3 ? std::stoul(argv[3]) : 4;
+
+    auto grid = make_grid(n);
+    const size_t nface = grid.neighbors.size();
+
+    std::vector<size_t> shuffled(nface);
+    std::iota(shuffled.begin(), shuffled.end(), 0);
+    std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+    auto mesher = permute(grid, shuffled);
+
+    std::cout << "nface=" << nface << " sweeps=" << sweeps << " nvar=" << nvar << std::endl;
+
+    double checksum_base = 0;
+    double t_base = run(mesher, sweeps, nvar, checksum_base);
+    std::cout << "shuffled  : " << t_base << " ms, mean neighbour stride " << mean_stride(mesher) << std::endl;
+
+    double checksum = 0;
+    double t = run(grid, sweeps, nvar, checksum);
+    std::cout << "row-major : " << t << " ms, mean neighbour stride " << mean_stride(grid) << " (" << t_base / t << "x)"
+              << std::endl;
+
+    for (auto c : {math::space_filling_curve::curve::morton, math::space_filling_curve::curve::hilbert})
+    {
+        auto ordered = permute(mesher, math::space_filling_curve::ordering(mesher.x, mesher.y, c));
+        t = run(ordered, sweeps, nvar, checksum);
+
+        std::cout << (c == math::space_filling_curve::curve::hilbert ? "hilbert   : " : "morton    : ") << t
+                  << " ms, mean neighbour stride " << mean_stride(ordered) << " (" << t_base / t << "x)";
+        if (std::abs(checksum - checksum_base) > 1e-6 * std::abs(checksum_base))
+            std::cout << " checksum mismatch!";
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
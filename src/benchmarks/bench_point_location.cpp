@@ -0,0 +1,216 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+// Point location query rate of the CGAL kd-tree over face centres, which find_closest_face used to search, against the
+// grid index (locate, nearest_centroid) and the walk from a hint face. Queries are either uniform random points or the
+// ray-marching pattern of fast_shadow/fetchr/Winstral, where each point is one step further along a ray.
+// The terrain is a synthetic n x n grid of jittered vertices, two triangles per grid cell, stretched so the triangles
+// are skinny and the closest centre is often not the containing triangle.
+//
+// Usage: bench_point_location [n] [nquery]
+
+#include "math/point_location.hpp"
+#include "logger.hpp"
+#include "timer.hpp"
+
+#include <CGAL/Simple_cartesian.h>
+#include <CGAL/Kd_tree.h>
+#include <CGAL/Search_traits_2.h>
+#include <CGAL/Search_traits_adapter.h>
+#include <CGAL/Orthogonal_k_neighbor_search.h>
+#include <CGAL/property_map.h>
+#include <boost/iterator/zip_iterator.hpp>
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+typedef CGAL::Simple_cartesian<double> K;
+typedef K::Point_2 Point_2;
+typedef boost::tuple<Point_2, int> Point_and_id;
+typedef CGAL::Search_traits_adapter<Point_and_id, CGAL::Nth_of_tuple_property_map<0, Point_and_id>,
+                                    CGAL::Search_traits_2<K>> Traits;
+typedef CGAL::Sliding_midpoint<Traits> Splitter;
+typedef CGAL::Kd_tree<Traits, Splitter> Tree;
+typedef CGAL::Orthogonal_k_neighbor_search<
+    Traits, typename CGAL::internal::Spatial_searching_default_distance<Traits>::type, Splitter> K_neighbor_search;
+
+using math::point_location::grid_index;
+
+struct tri_mesh
+{
+    std::vector<grid_index::triangle> tri;
+    std::vector<std::array<int, 3>> neighbors; // neighbour j is opposite vertex j, -1 for none
+    double width, height;
+};
+
+static tri_mesh make_grid(size_t n)
+{
+    const double dx = 10, dy = 1;
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+
+    std::vector<double> vx((n + 1) * (n + 1)), vy((n + 1) * (n + 1));
+    for (size_t i = 0; i <= n; ++i)
+    {
+        for (size_t j = 0; j <= n; ++j)
+        {
+            bool edge = i == 0 || j == 0 || i == n || j == n;
+            vx[i * (n + 1) + j] = dx * (i + (edge ? 0 : jitter(gen)));
+            vy[i * (n + 1) + j] = dy * (j + (edge ? 0 : jitter(gen)));
+        }
+    }
+
+    tri_mesh m;
+    m.width = dx * n;
+    m.height = dy * n;
+    m.tri.resize(2 * n * n);
+    m.neighbors.resize(2 * n * n);
+
+    auto v = [n](size_t i, size_t j) { return i * (n + 1) + j; };
+    auto id = [n](size_t i, size_t j, int t) { return static_cast<int>(2 * (i * n + j) + t); };
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            size_t p00 = v(i, j), p10 = v(i + 1, j), p11 = v(i + 1, j + 1), p01 = v(i, j + 1);
+            m.tri[id(i, j, 0)] = {vx[p00], vy[p00], vx[p10], vy[p10], vx[p11], vy[p11]};
+            m.tri[id(i, j, 1)] = {vx[p00], vy[p00], vx[p11], vy[p11], vx[p01], vy[p01]};
+
+            m.neighbors[id(i, j, 0)] = {i + 1 < n ? id(i + 1, j, 1) : -1, id(i, j, 1), j > 0 ? id(i, j - 1, 1) : -1};
+            m.neighbors[id(i, j, 1)] = {j + 1 < n ? id(i, j + 1, 0) : -1, i > 0 ? id(i - 1, j, 0) : -1, id(i, j, 0)};
+        }
+    }
+    return m;
+}
+
+static void report(const std::string& name, size_t nquery, double ms, size_t found)
+{
+    std::cout << name << ": " << nquery / (ms / 1000.) << " queries/s (" << ms << " ms), " << found
+              << " containing" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    logging::core::get()->set_logging_enabled(false);
+
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000;
+    size_t nquery = argc > 2 ? std::stoul(argv[2]) : 2000000;
+
+    auto m = make_grid(n);
+    const size_t ntri = m.tri.size();
+    std::cout << "ntri=" << ntri << " nquery=" << nquery << std::endl;
+
+    timer c;
+
+    c.tic();
+    std::vector<Point_2> centres(ntri);
+    std::vector<int> ids(ntri);
+    for (size_t t = 0; t < ntri; ++t)
+    {
+        auto& v = m.tri[t];
+        centres[t] = Point_2((v[0] + v[2] + v[4]) / 3.0, (v[1] + v[3] + v[5]) / 3.0);
+        ids[t] = static_cast<int>(t);
+    }
+    Tree tree(boost::make_zip_iterator(boost::make_tuple(centres.begin(), ids.begin())),
+              boost::make_zip_iterator(boost::make_tuple(centres.end(), ids.end())));
+    tree.build();
+    std::cout << "kd-tree build    : " << c.toc<ms>() << " ms" << std::endl;
+
+    c.tic();
+    grid_index index;
+    index.build(m.tri, m.neighbors);
+    std::cout << "grid index build : " << c.toc<ms>() << " ms" << std::endl;
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> ux(0, m.width), uy(0, m.height);
+    std::vector<std::array<double, 2>> random(nquery);
+    for (auto& q : random)
+        q = {ux(gen), uy(gen)};
+
+    // rays of 50 steps of one grid spacing from random start points in random directions
+    const size_t steps = 50;
+    std::uniform_real_distribution<double> angle(0, 2 * M_PI);
+    std::vector<std::array<double, 2>> rays(nquery);
+    for (size_t r = 0; r < nquery / steps; ++r)
+    {
+        double x0 = ux(gen), y0 = uy(gen), a = angle(gen);
+        for (size_t j = 0; j < steps; ++j)
+            rays[r * steps + j] = {x0 + j * 10 * std::cos(a), y0 + j * std::sin(a)};
+    }
+
+    for (auto* set : {&random, &rays})
+    {
+        std::cout << (set == &random ? "-- random points" : "-- points along rays") << std::endl;
+        const auto& q = *set;
+
+        size_t found = 0;
+        c.tic();
+        for (auto& p : q)
+        {
+            K_neighbor_search search(tree, Point_2(p[0], p[1]), 1);
+            int t = boost::get<1>(search.begin()->first);
+            found += index.contains(t, p[0], p[1]);
+        }
+        report("kd-tree closest centre  ", q.size(), c.toc<ms>(), found);
+
+        found = 0;
+        c.tic();
+        for (auto& p : q)
+        {
+            int t = index.nearest_centroid(p[0], p[1]);
+            found += index.contains(t, p[0], p[1]);
+        }
+        report("grid closest centre     ", q.size(), c.toc<ms>(), found);
+
+        found = 0;
+        c.tic();
+        for (auto& p : q)
+            found += index.locate(p[0], p[1]) >= 0;
+        report("grid containing         ", q.size(), c.toc<ms>(), found);
+
+        // walking is only useful when consecutive queries are close
+        if (set == &random)
+            continue;
+
+        found = 0;
+        int hint = -1;
+        c.tic();
+        for (size_t k = 0; k < q.size(); ++k)
+        {
+            // a new ray has no useful hint
+            if (k % steps == 0)
+                hint = -1;
+            hint = index.walk(q[k][0], q[k][1], hint);
+            found += hint >= 0;
+        }
+        report("grid walk from last face", q.size(), c.toc<ms>(), found);
+    }
+
+    return 0;
+}
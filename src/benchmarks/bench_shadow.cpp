@@ -0,0 +1,201 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+// Compares the zbuffer shadow engine against the pairwise, binned comparison used by Marsh_shading_iswr's aabb method.
+// The reference below is the same algorithm as Marsh_shading_iswr::run_aabb (rotate into the sun frame, bin triangles
+// by vertex, sort each bin by depth, test each pair for overlap) on plain arrays so no mesh file is needed.
+// The terrain is a synthetic n x n grid of hills, two triangles per grid cell.
+//
+// Usage: bench_shadow [n] [azimuth] [elevation] [nbins] [cell_size]
+
+#include "math/zbuffer.hpp"
+#include "logger.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <string>
+#include <vector>
+
+// strict point in triangle, as face::contains
+static bool contains(const double* t, double x, double y)
+{
+    double d0 = (t[3] - t[0]) * (y - t[1]) - (t[4] - t[1]) * (x - t[0]);
+    double d1 = (t[6] - t[3]) * (y - t[4]) - (t[7] - t[4]) * (x - t[3]);
+    double d2 = (t[0] - t[6]) * (y - t[7]) - (t[1] - t[7]) * (x - t[6]);
+
+    return (d0 > 0 && d1 > 0 && d2 > 0) || (d0 < 0 && d1 < 0 && d2 < 0);
+}
+
+static std::vector<int> reference(const std::vector<double>& xyz, double azimuth, double elevation, size_t nbins)
+{
+    size_t ntri = xyz.size() / 9;
+
+    double z0 = M_PI - azimuth * M_PI / 180.0;
+    double q0 = M_PI / 2.0 - elevation * M_PI / 180.0;
+    const double K[3][3] = {{cos(z0), sin(z0), 0},
+                            {-cos(q0) * sin(z0), cos(q0) * cos(z0), sin(q0)},
+                            {sin(q0) * sin(z0), -cos(z0) * sin(q0), cos(q0)}};
+
+    std::vector<double> rot(xyz.size());
+    std::vector<double> z_prime(ntri);
+
+#pragma omp parallel for
+    for (size_t i = 0; i < xyz.size(); i += 3)
+    {
+        for (size_t r = 0; r < 3; ++r)
+            rot[i + r] = K[r][0] * xyz[i] + K[r][1] * xyz[i + 1] + K[r][2] * xyz[i + 2];
+    }
+    for (size_t t = 0; t < ntri; ++t)
+        z_prime[t] = (rot[9 * t + 2] + rot[9 * t + 5] + rot[9 * t + 8]) / 3.0;
+
+    double xmin = 1e300, xmax = -1e300, ymin = 1e300, ymax = -1e300;
+    for (size_t i = 0; i < rot.size(); i += 3)
+    {
+        xmin = std::min(xmin, rot[i]);
+        xmax = std::max(xmax, rot[i]);
+        ymin = std::min(ymin, rot[i + 1]);
+        ymax = std::max(ymax, rot[i + 1]);
+    }
+    double bw = (xmax - xmin) / nbins * (1 + 1e-9);
+    double bh = (ymax - ymin) / nbins * (1 + 1e-9);
+
+    // a triangle goes in every bin one of its vertices is in
+    std::vector<std::vector<size_t>> bins(nbins * nbins);
+    for (size_t t = 0; t < ntri; ++t)
+    {
+        size_t last = bins.size();
+        for (size_t v = 0; v < 3; ++v)
+        {
+            size_t b = size_t((rot[9 * t + 3 * v + 1] - ymin) / bh) * nbins + size_t((rot[9 * t + 3 * v] - xmin) / bw);
+            if (b != last)
+                bins[b].push_back(t);
+            last = b;
+        }
+    }
+
+    std::vector<int> shadow(ntri, 0);
+
+#pragma omp parallel for schedule(dynamic)
+    for (size_t b = 0; b < bins.size(); ++b)
+    {
+        auto& tri = bins[b];
+        std::sort(tri.begin(), tri.end(), [&](size_t a, size_t c) { return z_prime[a] > z_prime[c]; });
+
+        std::vector<char> local(tri.size(), 0);
+        for (size_t j = 0; j < tri.size(); ++j)
+        {
+            const double* tj = &rot[9 * tri[j]];
+            double jx0 = std::min({tj[0], tj[3], tj[6]}), jx1 = std::max({tj[0], tj[3], tj[6]});
+            double jy0 = std::min({tj[1], tj[4], tj[7]}), jy1 = std::max({tj[1], tj[4], tj[7]});
+
+            for (size_t k = j + 1; k < tri.size(); ++k)
+            {
+                if (local[k] || z_prime[tri[j]] <= z_prime[tri[k]])
+                    continue;
+
+                const double* tk = &rot[9 * tri[k]];
+                if (std::max({tk[0], tk[3], tk[6]}) < jx0 || std::min({tk[0], tk[3], tk[6]}) > jx1 ||
+                    std::max({tk[1], tk[4], tk[7]}) < jy0 || std::min({tk[1], tk[4], tk[7]}) > jy1)
+                    continue;
+
+                if (contains(tj, (tk[0] + tk[3] + tk[6]) / 3.0, (tk[1] + tk[4] + tk[7]) / 3.0) ||
+                    contains(tj, tk[0], tk[1]) || contains(tj, tk[3], tk[4]) || contains(tj, tk[6], tk[7]))
+                    local[k] = 1;
+            }
+        }
+
+#pragma omp critical
+        for (size_t j = 0; j < tri.size(); ++j)
+            shadow[tri[j]] |= local[j];
+    }
+
+    return shadow;
+}
+
+int main(int argc, char** argv)
+{
+    logging::core::get()->set_logging_enabled(false);
+
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 300;
+    double azimuth = argc > 2 ? std::stod(argv[2]) : 135;
+    double elevation = argc > 3 ? std::stod(argv[3]) : 20;
+    size_t nbins = argc > 4 ? std::stoul(argv[4]) : 10;
+    double cell_size = argc > 5 ? std::stod(argv[5]) : 0;
+
+    // 10 m grid of ~1 km relief hills, in UTM-like coordinates
+    const double dx = 10;
+    auto z = [](double x, double y)
+    {
+        return 500 * (std::sin(x / 700.0) * std::cos(y / 900.0) + 1) + 100 * std::sin((x + y) / 230.0);
+    };
+
+    std::vector<double> xyz;
+    xyz.reserve(n * n * 18);
+    for (size_t i = 0; i < n; ++i)
+    {
+        for (size_t j = 0; j < n; ++j)
+        {
+            double x0 = 500000 + i * dx, y0 = 5600000 + j * dx;
+            double x1 = x0 + dx, y1 = y0 + dx;
+
+            double a[] = {x0, y0, z(x0, y0), x1, y0, z(x1, y0), x1, y1, z(x1, y1)};
+            double b[] = {x0, y0, z(x0, y0), x1, y1, z(x1, y1), x0, y1, z(x0, y1)};
+            xyz.insert(xyz.end(), a, a + 9);
+            xyz.insert(xyz.end(), b, b + 9);
+        }
+    }
+    size_t ntri = xyz.size() / 9;
+
+    timer c;
+
+    c.tic();
+    auto ref = reference(xyz, azimuth, elevation, nbins);
+    double t_ref = c.toc<ms>();
+
+    math::shading::zbuffer zb;
+    zb.set_cell_size(cell_size);
+    std::vector<int> shadow;
+    std::vector<double> z_prime;
+
+    c.tic();
+    zb.compute(xyz, azimuth, elevation, shadow, z_prime);
+    double t_zb = c.toc<ms>();
+
+    size_t n_ref = std::accumulate(ref.begin(), ref.end(), size_t(0));
+    size_t n_zb = std::accumulate(shadow.begin(), shadow.end(), size_t(0));
+    size_t agree = 0;
+    for (size_t t = 0; t < ntri; ++t)
+        agree += ref[t] == shadow[t];
+
+    std::cout << "ntri=" << ntri << " azimuth=" << azimuth << " elevation=" << elevation << std::endl;
+    std::cout << "aabb (" << nbins << "x" << nbins << " bins) : " << t_ref << " ms, " << n_ref << " shadowed" << std::endl;
+    std::cout << "zbuffer (" << zb.nx() << "x" << zb.ny() << " cells of " << zb.cell_size() << ") : " << t_zb << " ms, "
+              << n_zb << " shadowed (" << t_ref / t_zb << "x)" << std::endl;
+    std::cout << "agreement : " << 100.0 * agree / ntri << "%" << std::endl;
+
+    return 0;
+}
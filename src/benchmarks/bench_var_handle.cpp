@@ -0,0 +1,112 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+// Compares the per-face cost of the hashed variable lookup, (*face)["var"_s], against a var_handle resolved once
+// at init, face->get(h), and against a plain loop over the raw column.
+// The face variable storage is a columnstorage over all faces, so a synthetic 1M-face storage with a realistic
+// number of variables exercises exactly the same access path without needing a mesh on disk.
+//
+// Usage: bench_var_handle [nfaces] [nreps]
+
+#include "columnstorage.hpp"
+#include "timer.hpp"
+
+#include <iostream>
+#include <string>
+#include <set>
+
+int main(int argc, char** argv)
+{
+    logging::core::get()->set_logging_enabled(false);
+
+    size_t nfaces = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t nreps = argc > 2 ? std::stoul(argv[2]) : 10;
+
+    // a typical full snow model run provides on the order of 100 variables
+    std::set<std::string> variables = {"t", "rh", "U_2m_above_srf", "p", "swe", "snowdepthavg"};
+    for (size_t i = 0; i < 100; ++i)
+    {
+        variables.insert("var" + std::to_string(i));
+    }
+
+    columnstorage<double> store;
+    store.init(variables, nfaces);
+
+    timer c;
+    double sink = 0;
+
+    // current path: hash lookup (or string hash if SAFE_CHECKS) + hash compare per access
+    c.tic();
+    for (size_t r = 0; r < nreps; ++r)
+    {
+        #pragma omp parallel for
+        for (size_t i = 0; i < nfaces; ++i)
+        {
+            store.at("swe"_s, i) = store.at("t"_s, i) + store.at("p"_s, i);
+        }
+    }
+    double hashed = c.toc<ms>();
+
+    // handle path: resolved once, per access is an indexed load
+    auto swe = store.handle("swe");
+    auto t = store.handle("t");
+    auto p = store.handle("p");
+
+    c.tic();
+    for (size_t r = 0; r < nreps; ++r)
+    {
+        #pragma omp parallel for
+        for (size_t i = 0; i < nfaces; ++i)
+        {
+            store(swe, i) = store(t, i) + store(p, i);
+        }
+    }
+    double handle = c.toc<ms>();
+
+    // whole column loop, as a vectorized module or output would use
+    auto swe_col = store.column(swe);
+    auto t_col = store.column(t);
+    auto p_col = store.column(p);
+
+    c.tic();
+    for (size_t r = 0; r < nreps; ++r)
+    {
+        #pragma omp parallel for simd
+        for (size_t i = 0; i < nfaces; ++i)
+        {
+            swe_col[i] = t_col[i] + p_col[i];
+        }
+    }
+    double column = c.toc<ms>();
+
+    for (size_t i = 0; i < nfaces; ++i)
+        sink += swe_col[i];
+
+    std::cout << "nfaces=" << nfaces << " nvariables=" << store.size() << " nreps=" << nreps << std::endl;
+    std::cout << "hashed lookup  : " << hashed / nreps << " ms/sweep" << std::endl;
+    std::cout << "var_handle     : " << handle / nreps << " ms/sweep (" << hashed / handle << "x)" << std::endl;
+    std::cout << "column loop    : " << column / nreps << " ms/sweep (" << hashed / column << "x)" << std::endl;
+    std::cout << "(checksum " << sink << ")" << std::endl;
+
+    return 0;
+}
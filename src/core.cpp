@@ -58,6 +58,10 @@ core::~core()
         itr.first.reset();
     }
 
+    // the mesh outlives _mpi_env, so its cached ghost exchange plans must free their MPI requests now
+    if(_mesh)
+        _mesh->clear_ghost_exchanges();
+
 }
 
 void core::config_options( pt::ptree &value)
@@ -337,6 +341,20 @@ void core::config_checkpoint( pt::ptree& value)
             CHM_THROW_EXCEPTION(config_error, "Checkpointing is enabled but checkpoint.frequency or checkpoint.on_last are not specified.");
         }
 
+        _checkpoint_opts.deflate_level = value.get("compression_level",0);
+        _checkpoint_opts.chunk_size = value.get("chunk_size",0);
+
+        if(_checkpoint_opts.deflate_level < 0 || _checkpoint_opts.deflate_level > 9)
+        {
+            CHM_THROW_EXCEPTION(config_error, "checkpoint.compression_level must be on [0,9].");
+        }
+
+        _checkpoint_opts.async = value.get("async",false);
+        if(_checkpoint_opts.async)
+        {
+            LOG_DEBUG << "Checkpoint files are written on a background thread";
+        }
+
     }
 
     auto file = value.get_optional<std::string>("load_checkpoint_path");
@@ -623,9 +641,25 @@ bool core::config_meshes( pt::ptree &value)
     _mesh_path = value.get<std::string>("mesh");
     LOG_DEBUG << "Found mesh:" << _mesh_path;
     _mesh_path = (cwd_dir / _mesh_path).string();
+    _global->_mesh_path = _mesh_path;
 
     auto mesh_file_extension = boost::filesystem::path(_mesh_path).extension().string();
 
+    // Optionally order the faces of a json mesh along a space-filling curve. h5 meshes and partitions keep the
+    // order they were written with, as their parameters are read by offset, so there it has to be done by the
+    // partition tool
+    auto face_ordering = value.get<std::string>("face_ordering", "none");
+    if (!math::space_filling_curve::from_string(face_ordering, _mesh->_face_ordering))
+    {
+        CHM_THROW_EXCEPTION(config_error, "Unknown face_ordering " + face_ordering + ". Must be one of none, hilbert, morton.");
+    }
+    if (_mesh->_face_ordering != math::space_filling_curve::curve::none &&
+        (mesh_file_extension == ".h5" || mesh_file_extension == ".partition"))
+    {
+        LOG_WARNING << "face_ordering only applies to json meshes and is ignored for " << mesh_file_extension
+                    << ". Use the partition tool's --face-ordering when converting the mesh instead.";
+    }
+
     bool is_partition = false;
     // only need to look for param + ic if we aren't loading a partition
     std::vector<std::string> param_file_paths;
@@ -811,6 +845,20 @@ void core::config_output(pt::ptree &value)
 
 
     auto output_dir = value.get<std::string>("output_dir","output");
+
+    // memory used by the timeseries outputs is # points x # variables x batch size x (queue depth + 1)
+    int batch_size = value.get("timeseries_batch_size", 100);
+    int queue_depth = value.get("timeseries_queue_depth", 2);
+    if (batch_size <= 0)
+    {
+        CHM_THROW_EXCEPTION(config_error, "timeseries_batch_size must be > 0");
+    }
+    if (queue_depth < 0)
+    {
+        CHM_THROW_EXCEPTION(config_error, "timeseries_queue_depth must be >= 0");
+    }
+    _ts_batch_size = static_cast<size_t>(batch_size);
+    _ts_queue_depth = static_cast<size_t>(queue_depth);
     o_path = cwd_dir / output_dir;
     boost::filesystem::create_directories(o_path);
 
@@ -831,6 +879,11 @@ void core::config_output(pt::ptree &value)
             continue;
         }
 
+        if (out_type == "timeseries_batch_size" || out_type == "timeseries_queue_depth") // handled above
+        {
+            continue;
+        }
+
         if ((out_type != "mesh"))  // anything else *should* be a time series*......
         {
             out.type = output_info::time_series;
@@ -848,6 +901,12 @@ void core::config_output(pt::ptree &value)
             auto f = pts_path / fname;
             out.fname = f.string();
 
+            auto format = itr.second.get<std::string>("format", "csv");
+            if (!timeseries_writer::format_from_string(format, out.ts_format))
+            {
+                CHM_THROW_EXCEPTION(config_error, "Output " + out.name + " has an unknown format " + format + ". Must be csv or netcdf.");
+            }
+
             try
             {
                 out.longitude = itr.second.get<double>("longitude");
@@ -928,6 +987,11 @@ void core::config_output(pt::ptree &value)
 	    // Set option for writing ghost neighbor data, defaults to not
             _mesh->write_ghost_neighbors_to_vtu( itr.second.get("write_ghost_neighbors",false) ) ;
 
+            // raw binary appended data is the fastest to write; compression trades write time for disk
+            _mesh->vtu_format(itr.second.get<std::string>("data_mode", "appended"),
+                              itr.second.get<std::string>("compression", "none"),
+                              itr.second.get("compression_level", 5));
+
             try
             {
                 for (auto &jtr: itr.second.get_child("variables"))
@@ -951,6 +1015,9 @@ void core::config_output(pt::ptree &value)
                 LOG_WARNING << "Only only_last_n output option will be used";
             }
 
+            // each queued output holds a copy of the output variables, so this bounds the extra memory used
+            out.queue_depth = itr.second.get("queue_depth", 2);
+
             out.mesh_output_formats.push_back(output_info::mesh_outputs::vtu);
 
         } else
@@ -1528,16 +1595,6 @@ void core::init(int argc, char **argv)
     _global->interp_algorithm = _interpolation_method;
 
 
-    //setup output timeseries sinks
-
-    for (auto &itr : _outputs)
-    {
-        if (itr.type == output_info::output_type::time_series)
-        {
-            itr.ts.init(_provided_var_module, _metdata->start_time(), _metdata->end_time(), _metdata->dt());
-        }
-    }
-
     if(point_mode.enable)
     {
         for(auto itr:_chunked_modules)
@@ -1562,21 +1619,33 @@ void core::init(int argc, char **argv)
         module_list.insert(itr.first->ID);
     }
 
-    // only init on the faces we are going to compute on
-    // seemed like a good idea but module init has no way to know that it shouldn't run on part of the mesh
-    // todo: revisit only init on parts of the mesh
+    // In point mode only the faces of the output points are active. The mesh is pruned to them so that module init,
+    // the timestep loop, and every domain->face(i) loop in a module only ever see the active faces.
     if(point_mode.enable)
     {
         LOG_DEBUG<< "Initialzing faces for point_mode only";
         std::vector<mesh_elem> faces_to_init;
+        std::unordered_set<size_t> active; // by cell_global_id, as several outputs may share a face
 
         for (auto &itr : _outputs)
         {
             if (itr.type == output_info::output_type::time_series)
             {
-                faces_to_init.push_back(itr.face);
+                if (itr.face == nullptr)
+                {
+                    CHM_THROW_EXCEPTION(model_init_error, "Output " + itr.name + " is not on the mesh. In point mode every output must be on the mesh.");
+                }
+
+                if (active.insert(itr.face->cell_global_id).second)
+                    faces_to_init.push_back(itr.face);
             }
         }
+
+        if (faces_to_init.empty())
+        {
+            CHM_THROW_EXCEPTION(model_init_error, "Point mode requires at least one timeseries output.");
+        }
+
         _mesh->prune_faces(faces_to_init);
         LOG_DEBUG << "Mesh now has #faces=" << _mesh->size_faces();
     }
@@ -2019,6 +2088,29 @@ void core::_determine_module_dep()
     s = ss.str();
     LOG_DEBUG << "_modules order after sort: " << s.substr(0, s.length() - 2);
 
+    // Now that the full set of module provided variables is known, resolve every module's variables to their column
+    // in the face variable storage. init_face_data allocates that storage from this same set, so the layout matches.
+    for (auto &itr : _modules)
+    {
+        auto& m = itr.first;
+
+        for (auto &v : *(m->provides()))
+        {
+            m->set_var_handle(v.name, columnstorage<double>::layout_handle(_provided_var_module, v.name));
+        }
+
+        for (auto &v : *(m->depends()))
+        {
+            m->set_var_handle(v.name, columnstorage<double>::layout_handle(_provided_var_module, v.name));
+        }
+
+        for (auto &v : *(m->optionals()))
+        {
+            if (m->has_optional(v))
+                m->set_var_handle(v, columnstorage<double>::layout_handle(_provided_var_module, v));
+        }
+    }
+
     // Parallel compilation ordering
 //    std::vector<int> time(size, 0);
 //    for (auto i = make_order.begin(); i != make_order.end(); ++i)
@@ -2094,10 +2186,39 @@ void core::run()
     timer c;
 
 
-    //setup a XML writer for the PVD paraview format
-    pt::ptree pvd;
-    pvd.add("VTKFile.<xmlattr>.type", "Collection");
-    pvd.add("VTKFile.<xmlattr>.version", "0.1");
+    // Mesh output is snapshotted in the timestep loop and written by a background thread. Every mesh output shares
+    // the one internal vtk mesh, filled with the first mesh output's variables, and the first mesh output's .pvd
+    std::unique_ptr<vtu_writer> mesh_writer;
+    std::vector<std::string> mesh_variables;
+    for (auto &itr : _outputs)
+    {
+        if (itr.type == output_info::output_type::mesh)
+        {
+            mesh_variables.assign(itr.variables.begin(), itr.variables.end()); //convert to list to match internal lists
+
+            std::string pvd_file = itr.fname + ".pvd";
+#ifdef USE_MPI
+            // rank 0 maintains the collection for all the ranks
+            if (_comm_world.rank() != 0)
+                pvd_file = "";
+#endif
+            mesh_writer.reset(new vtu_writer(*_mesh, itr.queue_depth, pvd_file));
+            break;
+        }
+    }
+
+    // all the timeseries outputs share one writer, which streams them to disk in batches
+    std::unique_ptr<timeseries_writer> ts_writer;
+    std::vector<timeseries_writer::point> ts_points;
+    for (auto &itr : _outputs)
+    {
+        if (itr.type == output_info::output_type::time_series)
+        {
+            ts_points.push_back({itr.name, itr.fname, itr.ts_format, itr.face, itr.longitude, itr.latitude});
+        }
+    }
+    if (!ts_points.empty())
+        ts_writer.reset(new timeseries_writer(*_mesh, _provided_var_module, std::move(ts_points), _ts_batch_size, _ts_queue_depth));
 
 
     LOG_DEBUG << "Loading first timestep's met data";
@@ -2142,8 +2263,6 @@ void core::run()
                         for (size_t i = 0; i < _mesh->size_faces(); i++)
                         {
                             auto face = _mesh->face(i);
-                            if (point_mode.enable && face->_debug_name != _outputs[0].name)
-                                continue;
 
                              //module calls
                              for (auto &jtr : itr)
@@ -2195,25 +2314,15 @@ void core::run()
                 done = true;
             }
 
-            //check that we actually need a mesh output.
-            for (auto &itr : _outputs)
-            {
-                if(itr.type == output_info::output_type::mesh)
-                {
-                    std::vector<std::string> output;
-                    output.assign(itr.variables.begin(),itr.variables.end()); //convert to list to match internal lists
-
-                    _mesh->update_vtk_data(output); //update the internal vtk mesh
-                    break; // we're done as soon as we've called update once. No need to do it multiple times.
-                }
-            }
-
             // save the current state
             if(_checkpoint_opts.should_checkpoint(current_ts, (max_ts-1) == current_ts)) // -1 because current_ts is 0 indexed
             {
                 LOG_DEBUG << "Checkpointing...";
 
-                netcdf savestate; //file to save to when checkpointing.
+                // back-pressure: only one checkpoint may be in flight
+                finish_checkpoint();
+
+                auto savestate = std::make_shared<netcdf>(); //file to save to when checkpointing.
 
                 auto timestamp = _global->posix_time() + boost::posix_time::seconds(_global->_dt);
                 //also write it out in seconds because netcdf is struggling with the string
@@ -2233,7 +2342,10 @@ void core::run()
                 //this parses both the input and the output paths for the checkpoint.
                 auto fname = ("chkp"+timestr + "_" + std::to_string(rank) + ".nc");
                 auto f = dirpath / fname;
-                savestate.create( f.string());
+                savestate->set_compression(_checkpoint_opts.deflate_level, _checkpoint_opts.chunk_size);
+
+                // modules serialize into memory, the file is written afterwards, possibly on another thread
+                savestate->stage();
 
                 c.tic();
                 for (auto &itr : _chunked_modules)
@@ -2241,20 +2353,22 @@ void core::run()
                     //module calls
                     for (auto &jtr : itr)
                     {
-                        jtr->checkpoint(_mesh, savestate);
+                        jtr->checkpoint(_mesh, *savestate);
                     }
                 }
 
                 auto& ids = _mesh->get_global_IDs();
-                savestate.create_variable1D("global_id",ids.size());
+                savestate->put_column("global_id", ids.size(), [&](size_t i) { return ids[i]; });
 
-                for (size_t i = 0; i < ids.size(); i++)
+                auto write = [savestate, f, timestamp, ts_sec]()
                 {
-                    savestate.put_var1D("global_id", i, ids[i]);
-                }
+                    savestate->write_staged(f.string());
 
-                savestate.get_ncfile().putAtt("restart_time",boost::posix_time::to_simple_string(timestamp));
-                savestate.get_ncfile().putAtt("restart_time_sec", netCDF::ncUint64,ts_sec);
+                    std::lock_guard<std::recursive_mutex> lock(netcdf::lib_mutex());
+                    savestate->get_ncfile().putAtt("restart_time",boost::posix_time::to_simple_string(timestamp));
+                    savestate->get_ncfile().putAtt("restart_time_sec", netCDF::ncUint64,ts_sec);
+                    savestate->get_ncfile().close();
+                };
 
                 pt::ptree tree;
 
@@ -2279,19 +2393,25 @@ void core::run()
                 }
                 tree.add_child("files", tmp_files);
 
+                _checkpoint_opts.pending_manifest = tree;
+                _checkpoint_opts.pending_manifest_path =
+                    _checkpoint_opts.ckpt_path / ("checkpoint_" + timestr + ".np" + std::to_string(nranks) + ".json");
+                _checkpoint_opts.has_pending = true;
 
-                if(rank == 0)
+                if(_checkpoint_opts.async)
                 {
-                    pt::write_json(
-                        (_checkpoint_opts.ckpt_path / ("checkpoint_" + timestr + ".np" + std::to_string(nranks) + ".json")).string(),
-                        tree);
+                    _checkpoint_opts.pending_write = std::async(std::launch::async, write);
+                    LOG_DEBUG << "Checkpoint staged [ " << c.toc<s>() << "s], writing in the background";
+                }
+                else
+                {
+                    write();
+                    finish_checkpoint();
+                    LOG_DEBUG << "Done checkpoint [ " << c.toc<s>() << "s]";
                 }
-
-
-
-                LOG_DEBUG << "Done checkpoint [ " << c.toc<s>() << "s]";
             }
 
+            bool vtk_updated = false;
             for (auto &itr : _outputs)
             {
                 if (itr.type == output_info::output_type::mesh)
@@ -2315,53 +2435,37 @@ void core::run()
 
                     if(should_output)
                     {
+                        // only fill the internal vtk mesh on timesteps that are written, and only once
+                        if(!vtk_updated)
+                        {
+                            _mesh->update_vtk_data(mesh_variables);
+                            vtk_updated = true;
+                        }
 
-                        #pragma omp parallel
+                        for (auto jtr : itr.mesh_output_formats)
                         {
-                            #pragma omp single
+                            if (jtr == output_info::mesh_outputs::vtu)
                             {
-                                for (auto jtr : itr.mesh_output_formats)
-                                {
-                                    #pragma omp task
-                                    {
-                                        std::string base_name = itr.fname + std::to_string(_global->posix_time_int());
-                                        boost::filesystem::path p(base_name);
-
-                                        if (jtr == output_info::mesh_outputs::vtu  )
-                                        {
+                                std::string base_name = itr.fname + std::to_string(_global->posix_time_int());
 
-                                            // this really only works if we let rank0 handle the io.
-                                            // If we let each process do it, they walk all over each other's output
-#ifdef USE_MPI
-                                            if(_comm_world.rank() == 0)
-                                            {
-                                                for(int rank = 0; rank < _comm_world.size(); rank++)
-                                                {
-#else
-                                                    int rank = 0;
-#endif
-                                                    pt::ptree &dataset = pvd.add("VTKFile.Collection.DataSet", "");
-                                                    dataset.add("<xmlattr>.timestep", _global->posix_time_int());
-                                                    dataset.add("<xmlattr>.group", "");
-                                                    dataset.add("<xmlattr>.part", rank);
-                                                    dataset.add("<xmlattr>.file", p.filename().string()+"_"+std::to_string(rank) + ".vtu");
-#ifdef USE_MPI
-                                                }
-                                            }
-#endif
-
-                                            //because a full path can be provided for the base_name, we need to strip this off
-                                            //to make it a relative path in the xml file.
+                                //because a full path can be provided for the base_name, we need to strip this off
+                                //to make it a relative path in the xml file.
+                                boost::filesystem::path p(base_name);
 
+                                std::vector<vtu_writer::pvd_entry> pvd;
+                                int nranks = 1;
+                                int rank = 0;
 #ifdef USE_MPI
-                                            _mesh->write_vtu(base_name + "_"+std::to_string(_comm_world.rank() )+ ".vtu");
-#else
-                                            _mesh->write_vtu(base_name + "_"+std::to_string(rank)+ ".vtu");
+                                nranks = _comm_world.size();
+                                rank = _comm_world.rank();
 #endif
-
-                                        }
-                                    }
+                                for (int r = 0; r < nranks; r++)
+                                {
+                                    pvd.push_back({static_cast<size_t>(_global->posix_time_int()), r,
+                                                   p.filename().string() + "_" + std::to_string(r) + ".vtu"});
                                 }
+
+                                mesh_writer->submit(base_name + "_" + std::to_string(rank) + ".vtu", pvd);
                             }
                         }
                     }
@@ -2370,18 +2474,8 @@ void core::run()
 
             //If we are output a timeseries at specific triangles, we do that here
             //Each output knows what face it corresponds to
-            for (auto &itr : _outputs)
-            {
-                //only update the full timeseries
-                if (itr.type == output_info::output_type::time_series)
-                {
-                    for (auto v : _provided_var_module)
-                    {
-                        auto data = (*itr.face)[v];
-                        itr.ts.at(v, current_ts) = data;
-                    }
-                }
-            }
+            if (ts_writer)
+                ts_writer->record(_global->posix_time());
 
             if(!_metdata->next())
                 done = true;
@@ -2416,52 +2510,56 @@ void core::run()
 
 
         }
+        // the last checkpoint may still be writing
+        finish_checkpoint();
+
+        // as may the last mesh outputs
+        if (mesh_writer)
+            mesh_writer->finish();
+
+        // and the partial last batch of the timeseries
+        if (ts_writer)
+            ts_writer->finish();
+
         double elapsed = c.toc<s>();
         LOG_DEBUG << "Total runtime was " << elapsed << "s";
 
 
 
-    std::string base_name="";
-
-    for (auto &itr : _outputs)
+    if(_notification_script != "")
     {
-        if (itr.type == output_info::output_type::mesh)
-        {
-
-#ifdef USE_MPI
-            if(_comm_world.rank() == 0)
-            {
-#endif
-#if (BOOST_VERSION / 100 % 1000) < 56
-                pt::write_xml(base_name + ".pvd",
-                              pvd, std::locale(), pt::xml_writer_make_settings<char>(' ', 4));
-#else
-                pt::write_xml(itr.fname + ".pvd",
-                              pvd, std::locale(), pt::xml_writer_settings<std::string>(' ', 4));
-                break;
-#endif
-#ifdef USE_MPI
-            }
-#endif
-        }
+        LOG_DEBUG << "Calling notification script";
+        int ierr = std::system(_notification_script.c_str()); CHK_SYSTEM_ERR(ierr);
     }
+}
 
-    for (auto &itr : _outputs)
+void core::finish_checkpoint()
+{
+    if(!_checkpoint_opts.has_pending)
+        return;
+
+    if(_checkpoint_opts.pending_write.valid())
     {
-        //save the full timeseries
-        if (itr.type == output_info::output_type::time_series)
-        {
-            itr.ts.subset(*_start_ts,*_end_ts); // in the event of an exception, _end_ts will be reset to have the esception timestep so-as to no write massive amounts of nan values
-            itr.ts.to_file(itr.fname);
-        }
+        timer c;
+        c.tic();
+        _checkpoint_opts.pending_write.get();
+        LOG_DEBUG << "Waited " << c.toc<ms>() << "ms for the previous checkpoint write";
     }
 
-
-    if(_notification_script != "")
+    // every rank's file must be closed before the manifest points at them
+#ifdef USE_MPI
+    _comm_world.barrier();
+    if(_comm_world.rank() == 0)
+#endif
     {
-        LOG_DEBUG << "Calling notification script";
-        int ierr = std::system(_notification_script.c_str()); CHK_SYSTEM_ERR(ierr);
+        // write then rename so a partially written manifest is never seen
+        auto tmp = _checkpoint_opts.pending_manifest_path;
+        tmp += ".tmp";
+        pt::write_json(tmp.string(), _checkpoint_opts.pending_manifest);
+        boost::filesystem::rename(tmp, _checkpoint_opts.pending_manifest_path);
     }
+
+    _checkpoint_opts.has_pending = false;
 }
 
 void core::end(const bool abort)
@@ -47,6 +47,7 @@
 #include <algorithm>
 #include <memory> //unique ptr
 #include <cstdlib>
+#include <future>
 
 //boost includes
 #include <boost/graph/graph_traits.hpp>
@@ -78,6 +79,8 @@ namespace po = boost::program_options;
 #include "logger.hpp"
 #include "exception.hpp"
 #include "triangulation.hpp"
+#include "vtu_writer.hpp"
+#include "timeseries/timeseries_writer.hpp"
 #include "filter_base.hpp"
 #include "module_base.hpp"
 #include "station.hpp"
@@ -192,6 +195,12 @@ public:
     void config_global( pt::ptree& value);
     void config_checkpoint( pt::ptree& value);
 
+    /**
+     * Waits for the in-flight checkpoint write, if any, to finish on every rank and then has rank 0
+     * atomically write that checkpoint's json manifest. Rethrows any exception from the write.
+     */
+    void finish_checkpoint();
+
     /**
      * Determines what the start end times should be, and ensures consistency from a check pointed file
      */
@@ -343,6 +352,8 @@ protected:
             face = nullptr;
             name = "";
             only_last_n = -1;
+            queue_depth = 2;
+            ts_format = timeseries_writer::format::csv;
         }
         enum output_type
         {
@@ -372,16 +383,24 @@ protected:
 
         std::set<std::string> variables;
         mesh_elem face;
-        timeseries ts;
+        timeseries_writer::format ts_format;
         size_t frequency;
 
         //Only output the last n timesteps. -1 = all
         size_t only_last_n;
 
+        // # of mesh outputs that may be waiting to be written by the background writer. 0 = write inline
+        size_t queue_depth;
+
     };
 
     std::vector<output_info> _outputs;
 
+    // timeseries outputs are buffered for this many timesteps before being written
+    size_t _ts_batch_size;
+    // # of full timeseries batches that may be waiting to be written. 0 = write inline
+    size_t _ts_queue_depth;
+
     // Checkpointing options
     class chkptOp
     {
@@ -389,7 +408,11 @@ protected:
         chkptOp():
                     do_checkpoint{false},
                     load_from_checkpoint{false},
-                    on_last{false}{  }
+                    on_last{false},
+                    deflate_level{0},
+                    chunk_size{0},
+                    async{false},
+                    has_pending{false}{  }
 
         boost::filesystem::path ckpt_path; // root path to chckpoint folder
         netcdf in_savestate; // if we are loading from checkpoint
@@ -399,6 +422,16 @@ protected:
         boost::optional<bool> on_last; //only checkpoint on the last timestep
         boost::optional<size_t> frequency; // frequency of checkpoints
 
+        int deflate_level; // netCDF compression of the checkpoint variables, 0 = off
+        size_t chunk_size; // netCDF chunk size of the checkpoint variables, 0 = library default
+
+        bool async; // snapshot module state in memory and write the file on a background thread
+
+        std::future<void> pending_write; // in-flight checkpoint file write
+        pt::ptree pending_manifest; // json manifest for the in-flight checkpoint
+        boost::filesystem::path pending_manifest_path;
+        bool has_pending; // pending_manifest still needs to be written
+
         /**
          * Should checkpointing occur
          * @param current_ts
@@ -32,6 +32,11 @@ global::global()
     _from_checkpoint = false;
 }
 
+std::string global::mesh_path()
+{
+    return _mesh_path;
+}
+
 bool global::is_geographic()
 {
     return _is_geographic;
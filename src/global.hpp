@@ -64,6 +64,7 @@ private:
     bool _is_geographic;
     bool _is_point_mode;
     bool _from_checkpoint;
+    std::string _mesh_path;
 
 
 public:
@@ -99,6 +100,12 @@ public:
      */
     bool from_checkpoint();
 
+    /**
+     * Full path to the mesh file the domain was loaded from. Allows modules to store derived data next to the mesh.
+     * @return
+     */
+    std::string mesh_path();
+
 
     pt::ptree parameters;
 
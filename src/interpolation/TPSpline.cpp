@@ -29,6 +29,9 @@
 #include <func/func.hpp>
 #include "TPSBasis.hpp"
 
+#include <map>
+#include <mutex>
+
 // Build FunC lookup table for -(log(x)+gamma+gsl_sf_expint_E1(x))
 
 // hardcoded error of 1e-8
@@ -44,144 +47,205 @@ static func::FailureProofTable<func::NonUniformEqSpaceInterpTable<3,double>,doub
 //} counter;
 
 
-double thin_plate_spline::operator()(std::vector< boost::tuple<double,double,double> >& sample_points, boost::tuple<double,double,double>& query_point)
+namespace
 {
-    //func::Timer t;
-    //see if we can reuse our
-    if(sample_points.size() + 1 != size)
-    {
-        size = sample_points.size();
-        size++; // need to make room for the physics
-        A = MatrixXXd::Zero(size,size);
-        b = VectorXd::Zero(size);
-        x = VectorXd::Zero(size);
-    }
+    // factorizations shared by all splines, keyed on the ordered sample locations.
+    std::mutex factorization_mutex;
+    std::map<std::vector<double>, std::shared_ptr<const thin_plate_spline::factorization>> factorization_cache;
 
-    if(uninit_lu_decomp)
+    // Splines built on per-face neighbours (e.g., smoothing) never share a factorization, so don't let those grow the
+    // cache without bound. Splines hold onto their own factorization so clearing this is always safe.
+    const size_t max_cached_factorizations = 4096;
+
+    bool same_locations(const std::vector<double>& xy, const std::vector< boost::tuple<double,double,double> >& sample_points)
     {
-        //build the LU decomp
-        for (unsigned int i = 0; i < size - 1; i++)
-        {
-            double sxi = sample_points.at(i).get<0>(); //x
-            double syi = sample_points.at(i).get<1>(); //y
+        if(xy.size() != 2 * sample_points.size())
+            return false;
 
-            for (unsigned int j = i; j < size - 1; j++)
-            {
-                double sxj = sample_points.at(j).get<0>(); //x
-                double syj = sample_points.at(j).get<1>(); //y
+        for(size_t i = 0; i < sample_points.size(); i++)
+        {
+            if( xy[2*i] != sample_points[i].get<0>() || xy[2*i+1] != sample_points[i].get<1>())
+                return false;
+        }
+        return true;
+    }
+}
 
-                double xdiff = (sxi - sxj);
-                double ydiff = (syi - syj);
+double thin_plate_spline::basis(double xdiff, double ydiff)
+{
+    double dij = sqrt(xdiff * xdiff + ydiff * ydiff); //distance between this set of observation points
 
-                //don't add in a duplicate point, otherwise we get nan
-                if (xdiff == 0. && ydiff == 0.)
-                    continue;
+    //none of the books and papers, despite citing Helena Mitášová, Lubos Mitáš seem to agree on the exact formula
+    //so I am following http://link.springer.com/article/10.1007/BF00893171#page-1
+    // eqn 10
 
-                double Rd = 0.;
-                if (j == i) // diagonal
-                {
-                    Rd = 0.0;
-                } else
-                {
-                    double dij = sqrt(xdiff * xdiff + ydiff * ydiff); //distance between this set of observation points
+    dij = (dij * weight / 2.0) * (dij * weight / 2.0);
 
-                    //none of the books and papers, despite citing Helena Mitášová, Lubos Mitáš seem to agree on the exact formula
-                    //so I am following http://link.springer.com/article/10.1007/BF00893171#page-1
-                    // eqn 10
+    //Chang 4th edition 2008 uses bessel_k0
+    //gsl_sf_bessel_K0
+    // and has a -0.5 weight out fron
+//     Rd = -0.5/(pi*weight*weight)*( log(dij*weight/2.0) + c + gsl_sf_bessel_K0(dij*weight));
 
-                    dij = (dij * weight / 2.0) * (dij * weight / 2.0);
+    //And Hengl and Evans in geomorphometry p.52 do not, but have some undefined omega_0/omega_1 weights
+    //it is all rather confusing. But this follows Mitášová exactly, and produces essentially the same answer
+    //as the worked example in box 16.2 in Chang
+    // set Rd = -(log(dij) + c + gsl_sf_expint_E1(dij))
+    return TPSBasis_LUT(dij);
+}
 
-                    //Chang 4th edition 2008 uses bessel_k0
-                    //gsl_sf_bessel_K0
-                    // and has a -0.5 weight out fron
-//                     Rd = -0.5/(pi*weight*weight)*( log(dij*weight/2.0) + c + gsl_sf_bessel_K0(dij*weight));
+std::shared_ptr<const thin_plate_spline::factorization> thin_plate_spline::build_factorization(const std::vector< boost::tuple<double,double,double> >& sample_points)
+{
+    size_t size = sample_points.size() + 1; // need to make room for the physics
 
-                    //And Hengl and Evans in geomorphometry p.52 do not, but have some undefined omega_0/omega_1 weights
-                    //it is all rather confusing. But this follows Mitášová exactly, and produces essentially the same answer
-                    //as the worked example in box 16.2 in Chang
-                    // set Rd = -(log(dij) + c + gsl_sf_expint_E1(dij))
-                    Rd = TPSBasis_LUT(dij);
-                }
+    auto f = std::make_shared<factorization>();
+    f->xy.resize(2 * sample_points.size());
 
-                A(i, j + 1) = Rd;
-                A(j, i + 1) = Rd;
+    MatrixXXd A = MatrixXXd::Zero(size,size);
 
-            }
-        }
+    for (unsigned int i = 0; i < size - 1; i++)
+    {
+        double sxi = sample_points.at(i).get<0>(); //x
+        double syi = sample_points.at(i).get<1>(); //y
 
+        f->xy[2*i] = sxi;
+        f->xy[2*i+1] = syi;
 
-        //set physics and build b values
-        for (unsigned int i = 0; i < size; i++)
+        // diagonal is 0
+        for (unsigned int j = i + 1; j < size - 1; j++)
         {
-            A(i, 0) = 1;
-            A(size - 1, i) = 1;
+            double sxj = sample_points.at(j).get<0>(); //x
+            double syj = sample_points.at(j).get<1>(); //y
+
+            double xdiff = (sxi - sxj);
+            double ydiff = (syi - syj);
+
+            //don't add in a duplicate point, otherwise we get nan
+            if (xdiff == 0. && ydiff == 0.)
+                continue;
+
+            double Rd = basis(xdiff, ydiff);
+
+            A(i, j + 1) = Rd;
+            A(j, i + 1) = Rd;
         }
-        A(size - 1, 0) = 0;
-        lu.compute(A);
     }
 
+    //set physics
+    for (unsigned int i = 0; i < size; i++)
+    {
+        A(i, 0) = 1;
+        A(size - 1, i) = 1;
+    }
+    A(size - 1, 0) = 0;
+
+    f->lu.compute(A);
 
-    //this will skip the above computation of the lu decomp next time this is called
-    if(reuse_LU)
-        uninit_lu_decomp = false;
+    return f;
+}
+
+std::shared_ptr<const thin_plate_spline::factorization> thin_plate_spline::get_factorization(const std::vector< boost::tuple<double,double,double> >& sample_points)
+{
+    std::vector<double> key(2 * sample_points.size());
+    for(size_t i = 0; i < sample_points.size(); i++)
+    {
+        key[2*i] = sample_points[i].get<0>();
+        key[2*i+1] = sample_points[i].get<1>();
+    }
 
-    for(size_t i=0;i<size-1;i++)
     {
-        b(i) = sample_points.at(i).get<2>() ;
+        std::lock_guard<std::mutex> lock(factorization_mutex);
+        auto itr = factorization_cache.find(key);
+        if(itr != factorization_cache.end())
+            return itr->second;
     }
 
-    b(size-1) = 0.0; //constant
+    // factorize outside of the lock, if two threads race on the same key they produce the same result
+    auto f = build_factorization(sample_points);
 
-    //solve equation
-    int s				= 0;
+    std::lock_guard<std::mutex> lock(factorization_mutex);
+    if(factorization_cache.size() >= max_cached_factorizations)
+        factorization_cache.clear();
 
-    x =  lu.solve(b) ; //ldlt.solve(b);
+    factorization_cache.insert(std::make_pair(std::move(key), f));
 
+    return f;
+}
 
-    double z0 = x(0);//little a
+void thin_plate_spline::compute_weights(query_weights& qw, double qx, double qy)
+{
+    // The interpolant is z0 = a + sum x_i R_i with [a, x_1 ... x_n] = A^-1 b. Writing q = [1, R_1 ... R_n] this is
+    // z0 = q^T A^-1 b = (A^-T q)^T b, so the weights only depend on the geometry.
+    size_t n = qw.fact->xy.size() / 2;
 
-    //skip x[0] we already pulled off above
-    double ex = query_point.get<0>();
-    double ey =  query_point.get<1>();
+    VectorXd q = VectorXd::Zero(n + 1);
+    q(0) = 1;
 
-    for (unsigned int i = 1; i < x.size() ;i++)
+    for (size_t i = 0; i < n; i++)
     {
-        double sx = sample_points.at(i-1).get<0>(); //x
-        double sy = sample_points.at(i-1).get<1>(); //y
-
-        double xdiff = (sx  - ex);
-        double ydiff = (sy  - ey);
-        double dij = sqrt(xdiff*xdiff + ydiff*ydiff);
-        dij = (dij * weight/2.0) * (dij * weight/2.0);
-        // set Rd equal to -(log(dij) + c + gsl_sf_expint_E1(dij))
-         
-        double Rd = TPSBasis_LUT(dij);
-
-        z0 = z0 + x(i)*Rd;
+        double xdiff = (qw.fact->xy[2*i]  - qx);
+        double ydiff = (qw.fact->xy[2*i+1]  - qy);
+
+        q(i + 1) = basis(xdiff, ydiff);
+    }
+
+    // A^-T q is indexed like b = [v_1 ... v_n, 0]
+    qw.w = qw.fact->lu.transpose().solve(q);
+    qw.qx = qx;
+    qw.qy = qy;
+}
+
+double thin_plate_spline::operator()(std::vector< boost::tuple<double,double,double> >& sample_points, boost::tuple<double,double,double>& query_point)
+{
+    double qx = query_point.get<0>();
+    double qy = query_point.get<1>();
+
+    query_weights* qw = nullptr;
+
+    if(reuse_LU)
+    {
+        for(auto& itr : _weights)
+        {
+            if(itr.fact && itr.qx == qx && itr.qy == qy && same_locations(itr.fact->xy, sample_points))
+            {
+                qw = &itr;
+                break;
+            }
+        }
+
+        if(!qw)
+        {
+            qw = &_weights[_next_weights];
+            _next_weights = (_next_weights + 1) % 2;
+
+            qw->fact = get_factorization(sample_points);
+            compute_weights(*qw, qx, qy);
+        }
+    }
+    else
+    {
+        qw = &_weights[0];
+        qw->fact = build_factorization(sample_points);
+        compute_weights(*qw, qx, qy);
+    }
+
+    // b(size-1) is the constant 0 so its weight doesn't contribute
+    double z0 = 0;
+    for(size_t i = 0; i < sample_points.size(); i++)
+    {
+        z0 += qw->w(i) * sample_points[i].get<2>();
     }
 
-    //t.stop();
-    //counter.total += t.duration();
     return z0;
 }
 
 thin_plate_spline::thin_plate_spline(size_t sz, std::map<std::string,std::string> config )
 : thin_plate_spline()
 {
-    size = sz;
-    size++; // need to make room for the physics
-
-    A = MatrixXXd::Zero(size,size);
-    b = VectorXd::Zero(size);
-    x = VectorXd::Zero(size);
-
     auto itr = config.find("reuse_LU");
     if(itr != config.end())
     {
-        if(config["reuse_LU"] == "true")
-            reuse_LU = true;
+        reuse_LU = itr->second == "true";
     }
-    reuse_LU = false;
 }
 
 thin_plate_spline::thin_plate_spline()
@@ -189,10 +253,9 @@ thin_plate_spline::thin_plate_spline()
     pi          = 3.14159;
     c           = 0.577215; //euler constant
     weight      = 0.01;
-    size        = 0;
 
-    reuse_LU    = false;
-    uninit_lu_decomp = true;
+    reuse_LU    = true;
+    _next_weights = 0;
 }
 
 thin_plate_spline::~thin_plate_spline(){}
@@ -32,6 +32,8 @@
 #include <boost/throw_exception.hpp>
 #include <exception.hpp>
 #include <iostream>
+#include <memory>
+#include <vector>
 #include "interp_base.hpp"
 #include "logger.hpp"
 
@@ -39,6 +41,11 @@
 * \class thin_plate_spline
 *
 * Thin plate spline with tensions interpolation
+*
+* The station geometry is fixed for a run, so the factorization of the spline system only depends on the ordered set
+* of sample locations. Factorizations are shared between every spline that sees the same set of locations, and each
+* spline keeps the weights for its query point so that an interpolation is a dot product with the sample values.
+* A station dropping out (e.g., NaN) changes the set of locations and so picks a different factorization.
 */
 class thin_plate_spline : public interp_base
 {
@@ -47,8 +54,9 @@ public:
     ~thin_plate_spline();
 
     /**
-     * Allocating A,b,x, and p every time this is called adds up.
-     * So the sz can be pre-set to pre allocate all the arrays.
+     * sz is the expected number of sample points.
+     * config:
+     *  - reuse_LU: "true" (default) caches the factorization and query weights, "false" rebuilds them every call.
      */
     thin_plate_spline(size_t sz,std::map<std::string,std::string> config = std::map<std::string,std::string>());
 
@@ -61,18 +69,49 @@ public:
     double operator()(std::vector< boost::tuple<double,double,double> >& sample_points, boost::tuple<double,double,double>& query_point);
 
     bool reuse_LU;
-private:
+
     typedef Eigen::Matrix<double,Eigen::Dynamic,1> VectorXd;
     typedef Eigen::Matrix<double,Eigen::Dynamic, Eigen::Dynamic> MatrixXXd;
 
-    MatrixXXd A ;
-    VectorXd b; // known values - constant value of 0 goes in b[size-1]
-    VectorXd x;
+    /**
+     * LU factorization of the spline system for one ordered set of sample locations
+     */
+    struct factorization
+    {
+        std::vector<double> xy; // x0,y0,x1,y1,... of the sample points, in order
+        Eigen::FullPivLU<MatrixXXd> lu;
+    };
+
+private:
+
+    /**
+     * Weights for a query point against a factorization, such that z = sum w_i * value_i
+     */
+    struct query_weights
+    {
+        std::shared_ptr<const factorization> fact;
+        double qx, qy;
+        VectorXd w;
+    };
+
+    // Builds and factorizes the (n+1)x(n+1) system
+    std::shared_ptr<const factorization> build_factorization(const std::vector< boost::tuple<double,double,double> >& sample_points);
+
+    // Returns the shared factorization for these sample locations, building it if needed
+    std::shared_ptr<const factorization> get_factorization(const std::vector< boost::tuple<double,double,double> >& sample_points);
+
+    // Solves for the weights of the query point
+    void compute_weights(query_weights& qw, double qx, double qy);
+
+    // Basis function between two points
+    double basis(double xdiff, double ydiff);
+
+    // The same spline is often called with alternating station sets (e.g., values and elevations with different NaNs),
+    // so a couple are kept
+    query_weights _weights[2];
+    size_t _next_weights;
 
-    Eigen::FullPivLU< Eigen::Matrix<double,Eigen::Dynamic, Eigen::Dynamic> > lu;
     double pi;
     double c; //euler constant
     double weight;
-    bool uninit_lu_decomp;
-    size_t size;
-};
+};
\ No newline at end of file
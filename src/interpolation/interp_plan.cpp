@@ -0,0 +1,250 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "interp_plan.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+
+const size_t interp_plan::no_coincident;
+
+interp_plan::interp_plan()
+{
+    _is_init = false;
+}
+
+interp_plan::~interp_plan()
+{
+
+}
+
+bool interp_plan::supported(interp_alg ia)
+{
+    return ia == interp_alg::idw || ia == interp_alg::nearest_sta;
+}
+
+bool interp_plan::is_init() const
+{
+    return _is_init;
+}
+
+size_t interp_plan::nfaces() const
+{
+    return _row_ptr.empty() ? 0 : _row_ptr.size() - 1;
+}
+
+size_t interp_plan::nstations() const
+{
+    return _stations.size();
+}
+
+void interp_plan::init(interp_alg ia, mesh& domain)
+{
+    if(!supported(ia))
+    {
+        BOOST_THROW_EXCEPTION(interp_unknown_type() << errstr_info("Interpolation type cannot be precomputed."));
+    }
+
+    _stations.clear();
+    _col_idx.clear();
+    _weights.clear();
+    _coincident.clear();
+    _row_ptr.assign(1, 0);
+
+    // station -> column
+    std::unordered_map<station*, size_t> columns;
+    auto column = [&](const std::shared_ptr<station>& s)
+    {
+        auto itr = columns.find(s.get());
+        if(itr != columns.end())
+            return itr->second;
+
+        size_t c = _stations.size();
+        columns[s.get()] = c;
+        _stations.push_back(s);
+        return c;
+    };
+
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+
+        _coincident.push_back(no_coincident);
+
+        if(ia == interp_alg::nearest_sta)
+        {
+            _col_idx.push_back(column(face->nearest_station()));
+            _weights.push_back(1.0);
+        }
+        else
+        {
+            auto& stations = face->stations();
+            if (stations.empty())
+            {
+                BOOST_THROW_EXCEPTION( interpolation_error()
+                                           << errstr_info("IDW requires >=1 stations"));
+            }
+
+            size_t row_start = _col_idx.size();
+            double denominator = 0;
+
+            for (auto& s : stations)
+            {
+                double xdiff = s->x() - face->get_x();
+                double ydiff = s->y() - face->get_y();
+                double di = xdiff * xdiff + ydiff * ydiff;
+
+                // a station on top of the face is used as is, the others are only kept for when it is missing
+                if (di == 0 && _coincident.back() == no_coincident)
+                {
+                    _coincident.back() = _col_idx.size();
+                    _col_idx.push_back(column(s));
+                    _weights.push_back(0.0);
+                    continue;
+                }
+
+                _col_idx.push_back(column(s));
+                _weights.push_back(di == 0 ? 0.0 : 1.0 / di);
+                denominator += di == 0 ? 0.0 : 1.0 / di;
+            }
+
+            if(denominator > 0)
+            {
+                for (size_t j = row_start; j < _weights.size(); j++)
+                    _weights[j] /= denominator;
+            }
+        }
+
+        _row_ptr.push_back(_col_idx.size());
+    }
+
+    _is_init = true;
+}
+
+double interp_plan::apply_row(size_t row, const double* values, bool has_nan) const
+{
+    size_t start = _row_ptr[row];
+    size_t end = _row_ptr[row + 1];
+
+    size_t coincident = _coincident[row];
+    if (coincident != no_coincident)
+    {
+        double v = values[_col_idx[coincident]];
+        if (!std::isnan(v))
+            return v;
+        has_nan = true;
+    }
+
+    double z = 0;
+
+    if(!has_nan)
+    {
+        #pragma omp simd reduction(+:z)
+        for (size_t j = start; j < end; j++)
+        {
+            z += _weights[j] * values[_col_idx[j]];
+        }
+        return z;
+    }
+
+    // drop the missing stations and renormalize over the rest
+    double wsum = 0;
+    for (size_t j = start; j < end; j++)
+    {
+        double v = values[_col_idx[j]];
+        if (std::isnan(v))
+            continue;
+
+        z += _weights[j] * v;
+        wsum += _weights[j];
+    }
+
+    // every station is missing
+    if(wsum == 0)
+        return std::nan("nan");
+
+    return z / wsum;
+}
+
+void interp_plan::throw_no_stations(size_t row) const
+{
+    BOOST_THROW_EXCEPTION(interpolation_error() << errstr_info("All of the stations of face " + std::to_string(row) +
+                                                              " are missing a value. IDW requires >=1 stations"));
+}
+
+void interp_plan::apply(const std::vector<double>& values, double* out) const
+{
+    if(values.size() != _stations.size())
+    {
+        BOOST_THROW_EXCEPTION(interpolation_error() << errstr_info("Interpolation plan expected " +
+                                  std::to_string(_stations.size()) + " station values, got " + std::to_string(values.size())));
+    }
+
+    bool has_nan = std::any_of(values.begin(), values.end(), [](double v) { return std::isnan(v); });
+
+    const double* v = values.data();
+    size_t n = nfaces();
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < n; i++)
+    {
+        out[i] = apply_row(i, v, has_nan);
+    }
+
+    // can't throw from inside the parallel region. A row is only NaN if all of its stations are
+    if(has_nan)
+    {
+        for (size_t i = 0; i < n; i++)
+        {
+            if(std::isnan(out[i]))
+                throw_no_stations(i);
+        }
+    }
+}
+
+double interp_plan::apply(size_t face, const std::vector<double>& values) const
+{
+    if(values.size() != _stations.size())
+    {
+        BOOST_THROW_EXCEPTION(interpolation_error() << errstr_info("Interpolation plan expected " +
+                                  std::to_string(_stations.size()) + " station values, got " + std::to_string(values.size())));
+    }
+
+    // only this row's stations matter
+    bool has_nan = false;
+    for (size_t j = _row_ptr[face]; j < _row_ptr[face + 1]; j++)
+    {
+        if(std::isnan(values[_col_idx[j]]))
+        {
+            has_nan = true;
+            break;
+        }
+    }
+
+    double z = apply_row(face, values.data(), has_nan);
+    if(std::isnan(z))
+        throw_no_stations(face);
+
+    return z;
+}
@@ -0,0 +1,131 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <limits>
+
+#include "triangulation.hpp"
+#include "station.hpp"
+#include "interpolation.hpp"
+
+/**
+* \class interp_plan
+* Precomputed interpolation from the stations to every face of the mesh.
+*
+* For IDW and nearest the weights only depend on the station and face geometry, so they are built once as a sparse
+* face x station matrix in CSR form. Interpolating a variable to all the faces is then one sparse mat-vec over the
+* station values.
+*
+* Missing (NaN) station values are treated as the interp_met modules do when they skip those stations before calling
+* inv_dist. Only the rows that use them are renormalized over their remaining stations, and a face with no remaining
+* stations throws an interpolation_error.
+*
+* A station exactly at a face's centre gives that face its value, or if it is missing, the face falls back to IDW over
+* its other stations. This differs from inv_dist, whose result in that case depends on the order of the stations; the
+* two only agree if the coincident station is the last one.
+*
+* Rows are in domain->face(i) order, which is also the order of the faces in a face variable column.
+* Thin plate splines are not linear in the station values in this way, so check supported() before using a plan.
+*/
+class interp_plan
+{
+public:
+    interp_plan();
+    ~interp_plan();
+
+    /**
+     * If the interpolation algorithm can be represented as a plan
+     * @param ia
+     * @return
+     */
+    static bool supported(interp_alg ia);
+
+    /**
+     * Builds the weights from each face's station list.
+     * @param ia Must be supported()
+     * @param domain
+     */
+    void init(interp_alg ia, mesh& domain);
+
+    bool is_init() const;
+
+    /**
+     * Evaluates f for each station in the plan, in the order apply expects.
+     * f has signature double(station&)
+     * @param f
+     * @return
+     */
+    template<typename F>
+    std::vector<double> station_values(F f) const
+    {
+        std::vector<double> values(_stations.size());
+        for (size_t i = 0; i < _stations.size(); i++)
+        {
+            values[i] = f(*_stations[i]);
+        }
+        return values;
+    }
+
+    /**
+     * Interpolates the station values to all faces. Throws if a face has no station with a value.
+     * @param values From station_values()
+     * @param out nfaces() long, e.g., a face variable column
+     */
+    void apply(const std::vector<double>& values, double* out) const;
+
+    /**
+     * Interpolates the station values to a single face. Throws if it has no station with a value.
+     * @param face Face index, as in domain->face(face)
+     * @param values From station_values()
+     * @return
+     */
+    double apply(size_t face, const std::vector<double>& values) const;
+
+    size_t nfaces() const;
+    size_t nstations() const;
+
+private:
+
+    // NaN if every station of the row is missing
+    double apply_row(size_t row, const double* values, bool has_nan) const;
+    void throw_no_stations(size_t row) const;
+
+    // stations referenced by any face, these are the columns
+    std::vector<std::shared_ptr<station>> _stations;
+
+    // CSR face x station weights
+    std::vector<size_t> _row_ptr;
+    std::vector<size_t> _col_idx;
+    std::vector<double> _weights;
+
+    // per row, the entry of a station at the face centre, whose weight is 0 so the row's IDW weights are kept for when
+    // it is missing. no_coincident if there is none
+    static const size_t no_coincident = std::numeric_limits<size_t>::max();
+    std::vector<size_t> _coincident;
+
+    bool _is_init;
+};
@@ -22,14 +22,20 @@
 //
 
 #include "LinearAlgebra.hpp"
+#include "timer.hpp"
+
+#include <algorithm>
+#include <cmath>
 
 namespace math
 {
   namespace LinearAlgebra
   {
 
-    NearestNeighborProblem::NearestNeighborProblem(mesh& domain, int nLayer) :
-      m_domain(domain), m_nLayer(nLayer)
+    NearestNeighborProblem::NearestNeighborProblem(mesh& domain, int nLayer, const SolverOptions& options) :
+      m_domain(domain), m_nLayer(nLayer), m_options(options),
+      m_solves_since_compute(0), m_norm_at_compute(0), m_preconditioner_computed(false),
+      m_have_previous(false), m_ntri(domain->size_faces()), m_values(nullptr), m_rhs_values(nullptr)
     {
 
       // TODO Accept a communicator on construction
@@ -151,58 +157,319 @@ namespace math
       // Create a Tpetra::Matrix using the Map, with a static allocation
       // dictated by NumNz.  (We know exactly how many elements there will
       // be in each row, so we use static profile for efficiency.)
-      m_matrix = rcp (new crs_matrix_type (m_graph));
-      m_matrix->fillComplete();
+      if (!m_options.matrix_free)
+      {
+	m_matrix = rcp (new crs_matrix_type (m_graph));
+	m_matrix->fillComplete();
+      }
+      buildStencil(n_global_tri);
+
       m_rhs = rcp(new MV(m_map, 1));
       m_solution = rcp(new MV(m_map, m_rhs->getNumVectors()));
 
+      m_previous = rcp(new MV(m_map, m_rhs->getNumVectors()));
+
       /*
-	Belos solver and Ifpack2 preconditioner setup
-	- TODO add optional input to set these params
+	Belos solver and preconditioner setup
       */
       // Create Belos iterative linear solver.
       RCP<ParameterList> solverParams(new ParameterList()); // solve parameters go in here
-      solverParams->set( "Block Size", 1 );
-      solverParams->set( "Num Blocks", 30 );
-      solverParams->set( "Maximum Iterations", 1000 );
-      solverParams->set( "Convergence Tolerance", 1e-8 );
+      std::transform(m_options.solver.begin(), m_options.solver.end(), m_options.solver.begin(), ::toupper);
+      if (m_options.solver == "GMRES")
+      {
+	solverParams->set( "Block Size", 1 );
+	solverParams->set( "Num Blocks", m_options.num_blocks );
+      }
+      solverParams->set( "Maximum Iterations", m_options.max_iterations );
+      solverParams->set( "Convergence Tolerance", m_options.tolerance );
+      try
       {
         Belos::SolverFactory<scalar_type, MV, OP> belosFactory;
-        m_solver = belosFactory.create("GMRES", solverParams);
+        m_solver = belosFactory.create(m_options.solver, solverParams);
+      }
+      catch(const std::exception& e)
+      {
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("Unable to create Belos solver " + m_options.solver + ": " + e.what()));
       }
       if (m_solver.is_null())
 	{
 	  BOOST_THROW_EXCEPTION(module_error() << errstr_info("PBSM3D failed to create solver"));
 	}
 
-      m_preconditioner = Ifpack2::Factory::create<row_matrix_type>("ILUT", m_matrix);
+      // Specify the problem
+      if (m_options.matrix_free)
+	m_problem = rcp (new problem_type (m_operator, m_solution, m_rhs));
+      else
+	m_problem = rcp (new problem_type (m_matrix, m_solution, m_rhs));
+
+      setupPreconditioner();
+
+      m_problem->setProblem ();
+      m_solver->setProblem (m_problem);
+
+    } // end constructor
+
+    void NearestNeighborProblem::buildStencil(size_t n_global_tri)
+    {
+      auto col_map = m_graph->getColMap();
+      auto row_ptrs = m_graph->getLocalRowPtrsHost();
+
+      m_stencil.resize(m_ntri * m_nLayer);
+      std::vector<local_ordinal_type> cols; // only needed matrix-free
+      if (m_options.matrix_free)
+	cols.resize(m_ntri * m_nLayer * stencil_size);
+
+      // Serial, as above for the graph construction
+      for (size_t i = 0; i < m_ntri; ++i)
+      {
+	auto face = m_domain->face(i);
+
+	for (int layer = 0; layer < m_nLayer; ++layer)
+	{
+	  auto& stencil = m_stencil.at(localRow(face->cell_local_id, layer));
+
+	  // global index of each stencil entry, -1 if it doesn't exist for this row
+	  global_ordinal_type gid[stencil_size];
+	  for (int f = 0; f < 3; ++f)
+	  {
+	    auto neighbor = face->neighbor(f);
+	    gid[f] = neighbor != nullptr ? n_global_tri * layer + neighbor->cell_global_id : -1;
+	  }
+	  gid[above] = layer < m_nLayer - 1 ? n_global_tri * (layer + 1) + face->cell_global_id : -1;
+	  gid[below] = layer > 0 ? n_global_tri * (layer - 1) + face->cell_global_id : -1;
+	  gid[self] = n_global_tri * layer + face->cell_global_id;
+
+	  stencil.row = m_map->getLocalElement(gid[self]);
+
+	  graph_type::local_inds_host_view_type row_cols;
+	  m_graph->getLocalRowView(stencil.row, row_cols);
+
+	  for (int slot = 0; slot < stencil_size; ++slot)
+	  {
+	    stencil.offset[slot] = invalid_offset;
+	    if (gid[slot] < 0)
+	      continue;
+
+	    auto lcol = col_map->getLocalElement(gid[slot]);
+	    for (size_t k = 0; k < row_cols.extent(0); ++k)
+	    {
+	      if (row_cols(k) != lcol)
+		continue;
+
+	      if (m_options.matrix_free)
+	      {
+		stencil.offset[slot] = stencil.row * stencil_size + slot;
+		cols[stencil.offset[slot]] = lcol;
+	      }
+	      else
+	      {
+		stencil.offset[slot] = row_ptrs(stencil.row) + k;
+	      }
+	      break;
+	    }
+	  }
+
+	  // unused matrix-free entries stay 0, point them at a valid column
+	  if (m_options.matrix_free)
+	  {
+	    for (int slot = 0; slot < stencil_size; ++slot)
+	    {
+	      if (stencil.offset[slot] == invalid_offset)
+		cols[stencil.row * stencil_size + slot] = col_map->getLocalElement(gid[self]);
+	    }
+	  }
+	}
+      }
+
+      if (m_options.matrix_free)
+	m_operator = rcp(new StencilOperator(m_map, col_map, m_graph->getImporter(), std::move(cols)));
+    }
+
+    StencilOperator::StencilOperator(RCP<const map_type> map, RCP<const map_type> col_map, RCP<const Tpetra::Import<>> importer,
+				     std::vector<local_ordinal_type> cols) :
+      m_map(map), m_col_map(col_map), m_importer(importer), m_cols(std::move(cols))
+    {
+      coefficients.assign(m_cols.size(), 0.0);
+    }
+
+    void StencilOperator::apply(const MV& X, MV& Y, Teuchos::ETransp mode, scalar_type alpha, scalar_type beta) const
+    {
+      if (mode != Teuchos::NO_TRANS)
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("StencilOperator only supports NO_TRANS"));
+
+      // Bring the ghost values of X into column-map ordering
+      const MV* x_col = &X;
+      if (!m_importer.is_null())
+      {
+	if (m_x_col.is_null() || m_x_col->getNumVectors() != X.getNumVectors())
+	  m_x_col = rcp(new MV(m_col_map, X.getNumVectors()));
+	m_x_col->doImport(X, *m_importer, Tpetra::INSERT);
+	x_col = m_x_col.get();
+      }
+
+      const size_t nrows = m_cols.size() / stencil_size;
+      for (size_t k = 0; k < X.getNumVectors(); ++k)
+      {
+	auto x = x_col->getData(k);
+	auto y = Y.getDataNonConst(k);
+
+#pragma omp parallel for
+	for (size_t row = 0; row < nrows; ++row)
+	{
+	  const double* c = &coefficients[row * stencil_size];
+	  const local_ordinal_type* col = &m_cols[row * stencil_size];
+
+	  double sum = 0;
+	  for (int slot = 0; slot < stencil_size; ++slot)
+	    sum += c[slot] * x[col[slot]];
+
+	  // beta == 0 must ignore Y, it may be uninitialized
+	  y[row] = beta == 0 ? alpha * sum : alpha * sum + beta * y[row];
+	}
+      }
+    }
+
+    void NearestNeighborProblem::setupPreconditioner()
+    {
+      std::string type = m_options.preconditioner;
+      std::transform(type.begin(), type.end(), type.begin(), ::toupper);
+      m_options.preconditioner = type;
+
+      if (type == "NONE")
+	return;
+
+      if (m_options.matrix_free)
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("The matrix-free operator can only be used without a preconditioner"));
+
+      if (type == "MUELU")
+      {
+#ifdef CHM_HAVE_MUELU
+	// MueLu builds its hierarchy from the matrix values, so creation is deferred to computePreconditioner
+	return;
+#else
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("Preconditioner MueLu requested but Trilinos was built without MueLu"));
+#endif
+      }
+
+      ParameterList precondOptions;
+      if (type == "ILUT")
+      {
+	precondOptions.set("fact: drop tolerance", m_options.ilut_drop_tolerance);
+	precondOptions.set("fact: ilut level-of-fill", m_options.ilut_fill); // Note this is different from num_entries_per_row: https://docs.trilinos.org/dev/packages/ifpack2/doc/html/classIfpack2_1_1ILUT.html#aee2011b313e3070ee43b2cfc2d183634
+	m_preconditioner = Ifpack2::Factory::create<row_matrix_type>("ILUT", m_matrix);
+      }
+      else if (type == "RILUK")
+      {
+	precondOptions.set("fact: iluk level-of-fill", m_options.riluk_level);
+	m_preconditioner = Ifpack2::Factory::create<row_matrix_type>("RILUK", m_matrix);
+      }
+      else if (type == "JACOBI")
+      {
+	precondOptions.set("relaxation: type", "Jacobi");
+	precondOptions.set("relaxation: sweeps", 1);
+	m_preconditioner = Ifpack2::Factory::create<row_matrix_type>("RELAXATION", m_matrix);
+      }
+      else
+      {
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("Unknown preconditioner " + type + ". Valid options are ILUT, RILUK, JACOBI, MUELU, NONE"));
+      }
+
       if (m_preconditioner.is_null())
 	{
 	  BOOST_THROW_EXCEPTION(module_error() << errstr_info("PBSM3D failed to create preconditioner"));
 	}
-      ParameterList precondOptions;
-      precondOptions.set("fact: drop tolerance", 1e-4);
-      precondOptions.set("fact: ilut level-of-fill", 3.0); // Note this is different from num_entries_per_row: https://docs.trilinos.org/dev/packages/ifpack2/doc/html/classIfpack2_1_1ILUT.html#aee2011b313e3070ee43b2cfc2d183634
       m_preconditioner->setParameters(precondOptions);
       m_preconditioner->initialize();
+      m_problem->setRightPrec (m_preconditioner);
+    }
+
+    bool NearestNeighborProblem::computePreconditioner()
+    {
+      if (m_options.preconditioner == "NONE")
+	return false;
+
+      bool recompute = !m_preconditioner_computed || m_solves_since_compute >= m_options.recompute_every;
 
-      // Specify the deposition problem
-      m_problem = rcp (new problem_type (m_matrix, m_solution, m_rhs));
-      if (! m_preconditioner.is_null ()) {
-	m_problem->setRightPrec (m_preconditioner);
+      // The norm check costs a global reduction, so only do it when it could change the decision
+      double norm = 0;
+      if (!recompute && m_options.recompute_threshold > 0)
+      {
+	norm = m_matrix->getFrobeniusNorm();
+	double change = std::fabs(norm - m_norm_at_compute) / std::max(m_norm_at_compute, 1e-300);
+	recompute = change > m_options.recompute_threshold;
       }
-      m_problem->setProblem ();
-      m_solver->setProblem (m_problem);
 
-    } // end constructor
+      if (!recompute)
+	return false;
+
+      if (m_options.recompute_threshold > 0 && norm == 0)
+	norm = m_matrix->getFrobeniusNorm();
+
+#ifdef CHM_HAVE_MUELU
+      if (m_options.preconditioner == "MUELU")
+      {
+	if (m_muelu.is_null())
+	{
+	  ParameterList mueluOptions;
+	  mueluOptions.set("verbosity", "none");
+	  RCP<OP> A = m_matrix;
+	  m_muelu = MueLu::CreateTpetraPreconditioner(A, mueluOptions);
+	  m_problem->setRightPrec (m_muelu);
+	  m_problem->setProblem ();
+	}
+	else
+	{
+	  // keeps the aggregates, rebuilds the smoothers and coarse operators
+	  MueLu::ReuseTpetraPreconditioner(m_matrix, *m_muelu);
+	}
+      }
+      else
+#endif
+      {
+	m_preconditioner->compute();
+      }
+
+      m_preconditioner_computed = true;
+      m_solves_since_compute = 0;
+      m_norm_at_compute = norm;
+      return true;
+    }
 
     void NearestNeighborProblem::zeroSystem()
     {
-      m_matrix->resumeFill();
+      // a previous assembly that was never solved may still hold the views
+      releaseViews();
+
       // Zero out suspension system
-      m_matrix->setAllToScalar(0.0);
+      if (m_options.matrix_free)
+      {
+	std::fill(m_operator->coefficients.begin(), m_operator->coefficients.end(), 0.0);
+	m_values = m_operator->coefficients.data();
+      }
+      else
+      {
+	m_matrix->resumeFill();
+	m_matrix->setAllToScalar(0.0);
+
+	m_values_view = m_matrix->getLocalValuesHost(Tpetra::Access::ReadWrite);
+	m_values = m_values_view.data();
+      }
       m_rhs->putScalar(0.0);
       m_solution->putScalar(0.0);
+
+      m_rhs_view = m_rhs->getLocalViewHost(Tpetra::Access::ReadWrite);
+      m_rhs_values = m_rhs_view.data();
+    }
+
+    void NearestNeighborProblem::releaseViews()
+    {
+      // the matrix-free coefficients are ours, so m_values stays valid
+      if (!m_options.matrix_free)
+	m_values = nullptr;
+      m_rhs_values = nullptr;
+
+      m_values_view = decltype(m_values_view)();
+      m_rhs_view = decltype(m_rhs_view)();
     }
 
     void NearestNeighborProblem::matrixReplaceGlobalValues(global_ordinal_type global_row_idx, global_ordinal_type global_col_idx, double val)
@@ -227,10 +494,26 @@ namespace math
 
     SolveConverge NearestNeighborProblem::Solve()
     {
-      m_matrix->fillComplete();
-      m_preconditioner->compute();
+      SolveConverge tmp;
+      timer c;
+
+      // hands the values back to Tpetra so they can be synced wherever the solve runs
+      releaseViews();
+
+      if (!m_options.matrix_free)
+	m_matrix->fillComplete();
+
+      c.tic();
+      tmp.preconditioner_recomputed = computePreconditioner();
+      tmp.setup_time = c.toc<ns>() * 1e-9;
+      ++m_solves_since_compute;
+
+      // zeroSystem leaves the solution at 0, otherwise start from the last solution
+      if (m_options.warm_start && m_have_previous)
+	m_solution->assign(*m_previous);
 
       // Solve the linear system.
+      c.tic();
       m_solver->reset(Belos::Problem);
       {        Belos::ReturnType solveResult = m_solver->solve();
         if (solveResult != Belos::Converged)
@@ -243,8 +526,15 @@ namespace math
 	  }
       }
 
+      tmp.solve_time = c.toc<ns>() * 1e-9;
+
+      if (m_options.warm_start)
+      {
+	m_previous->assign(*m_solution);
+	m_have_previous = true;
+      }
+
       // Get (and return) convergence info
-      SolveConverge tmp;
       tmp.numIters = m_solver->getNumIters();
       tmp.residual = m_solver->achievedTol();
       return tmp;
@@ -276,6 +566,9 @@ namespace math
 
     void NearestNeighborProblem::writeSystemMatrixMarket(std::string file_prefix)
     {
+      if (m_options.matrix_free)
+	BOOST_THROW_EXCEPTION(module_error() << errstr_info("No assembled matrix to write in matrix-free mode"));
+
       std::string matrix_file = file_prefix + "_matrix.mm";
       std::string matrix_name = file_prefix + " system matrix";
     Tpetra::MatrixMarket::Writer<crs_matrix_type>::writeSparseFile( matrix_file, m_matrix, matrix_name, matrix_name );
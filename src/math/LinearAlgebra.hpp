@@ -33,6 +33,18 @@
 #include <Tpetra_Core.hpp>
 #include <Tpetra_CrsMatrix.hpp>
 
+// MueLu is an optional Trilinos package; only offer the AMG preconditioner if it was built
+#if __has_include(<MueLu_CreateTpetraPreconditioner.hpp>)
+#include <MueLu_CreateTpetraPreconditioner.hpp>
+#define CHM_HAVE_MUELU
+#endif
+
+#include <array>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "triangulation.hpp"
 
 namespace math
@@ -68,6 +80,81 @@ namespace math
       {
 	int numIters;
 	double residual;
+	double setup_time;  // preconditioner compute, s
+	double solve_time;  // Krylov solve, s
+	bool preconditioner_recomputed;
+      };
+
+      /*
+	Solver and preconditioner selection for a NearestNeighborProblem.
+	The defaults reproduce the original fixed GMRES + ILUT setup, recomputing
+	the preconditioner on every solve.
+      */
+      struct SolverOptions
+      {
+	std::string solver = "GMRES";         // any Belos solver name, e.g., GMRES, BICGSTAB
+	std::string preconditioner = "ILUT";  // ILUT, RILUK, JACOBI, MUELU, NONE
+	int max_iterations = 1000;
+	double tolerance = 1e-8;
+	int num_blocks = 30;                  // GMRES restart length
+
+	// Preconditioner reuse. The preconditioner is recomputed once it has been used for
+	// recompute_every solves, or when the relative change in the matrix Frobenius norm
+	// since it was last computed exceeds recompute_threshold (if > 0).
+	int recompute_every = 1;
+	double recompute_threshold = 0;
+
+	// Use the previous solution as the initial guess
+	bool warm_start = false;
+
+	// Experimental: don't assemble a CrsMatrix, apply the stencil directly. Only usable without a preconditioner.
+	bool matrix_free = false;
+
+	double ilut_drop_tolerance = 1e-4;
+	double ilut_fill = 3.0;
+	int riluk_level = 0;
+      };
+
+      /*
+	Entries of one row of the nearest neighbor stencil. The lateral neighbors follow
+	face->neighbor(f), above and below are the prism top and bottom.
+      */
+      enum StencilSlot
+      {
+	neighbor0 = 0,
+	neighbor1,
+	neighbor2,
+	above,
+	below,
+	self,
+	stencil_size
+      };
+
+      /*
+	Matrix-free operator for the nearest neighbor system. Holds stencil_size coefficients
+	per local row and applies them to the column-map (owned + ghost) values of X.
+      */
+      class StencilOperator : public OP
+      {
+	RCP<const map_type> m_map;
+	RCP<const map_type> m_col_map;
+	RCP<const Tpetra::Import<>> m_importer; // null if no off-rank columns
+
+	std::vector<local_ordinal_type> m_cols; // column-map local index of each coefficient
+	mutable RCP<MV> m_x_col;
+
+      public:
+	std::vector<double> coefficients;
+
+	StencilOperator(RCP<const map_type> map, RCP<const map_type> col_map, RCP<const Tpetra::Import<>> importer,
+			std::vector<local_ordinal_type> cols);
+
+	RCP<const map_type> getDomainMap() const override { return m_map; }
+	RCP<const map_type> getRangeMap() const override { return m_map; }
+
+	void apply(const MV& X, MV& Y, Teuchos::ETransp mode = Teuchos::NO_TRANS,
+		   scalar_type alpha = Teuchos::ScalarTraits<scalar_type>::one(),
+		   scalar_type beta = Teuchos::ScalarTraits<scalar_type>::zero()) const override;
       };
 
       class NearestNeighborProblem
@@ -90,10 +177,52 @@ namespace math
 	// - needed for factories
 	RCP<solver_type> m_solver;
 	RCP<prec_type> m_preconditioner;
+#ifdef CHM_HAVE_MUELU
+	RCP<MueLu::TpetraOperator<>> m_muelu;
+#endif
 	RCP<problem_type> m_problem;
 
+	SolverOptions m_options;
+
+	// Preconditioner reuse state
+	int m_solves_since_compute;
+	double m_norm_at_compute;
+	bool m_preconditioner_computed;
+
+	// Last solution, used as the initial guess if warm_start is set
+	RCP<MV> m_previous;
+	bool m_have_previous;
+
+	// Cached stencil. For each (layer, face) the local row and the offset of every stencil
+	// entry into the local values array, so assembly needs no global index lookups.
+	struct RowStencil
+	{
+	  local_ordinal_type row;
+	  size_t offset[stencil_size];
+	};
+	static constexpr size_t invalid_offset = std::numeric_limits<size_t>::max();
+	size_t m_ntri;
+	std::vector<RowStencil> m_stencil;
+
+	// Local matrix values (or matrix-free coefficients) and rhs, valid from zeroSystem to Solve
+	double* m_values;
+	double* m_rhs_values;
+
+	// Host views m_values and m_rhs_values point into. Tpetra only guarantees the pointers while the views
+	// are alive, so they are held for the whole assembly and released before fillComplete
+	decltype(std::declval<crs_matrix_type&>().getLocalValuesHost(Tpetra::Access::ReadWrite)) m_values_view;
+	decltype(std::declval<MV&>().getLocalViewHost(Tpetra::Access::ReadWrite)) m_rhs_view;
+	void releaseViews();
+
+	RCP<StencilOperator> m_operator;
+
+	void buildStencil(size_t n_global_tri);
+
+	void setupPreconditioner();
+	bool computePreconditioner();
+
       public:
-	NearestNeighborProblem(mesh& domain, int nLayer=1);
+	NearestNeighborProblem(mesh& domain, int nLayer=1, const SolverOptions& options = SolverOptions());
 	~NearestNeighborProblem();
 
 	void zeroSystem();
@@ -106,6 +235,44 @@ namespace math
 
 	void rhsSumIntoGlobalValue(global_ordinal_type global_idx, double val);
 
+	/*
+	  Cached-stencil assembly. Rows are addressed by (face->cell_local_id, layer) and each row
+	  may only be written by one thread, so no locking is needed.
+	  Only valid between zeroSystem and Solve.
+	*/
+	size_t localRow(size_t face_local_id, int layer = 0) const
+	{
+	  return layer * m_ntri + face_local_id;
+	}
+
+	void matrixSumIntoLocalRow(size_t local_row, StencilSlot slot, double val)
+	{
+	  m_values[stencilOffset(local_row, slot)] += val;
+	}
+
+	void matrixReplaceLocalRow(size_t local_row, StencilSlot slot, double val)
+	{
+	  m_values[stencilOffset(local_row, slot)] = val;
+	}
+
+	void rhsSumIntoLocalRow(size_t local_row, double val)
+	{
+	  m_rhs_values[m_stencil[local_row].row] += val;
+	}
+
+	size_t stencilOffset(size_t local_row, StencilSlot slot) const
+	{
+#ifdef SAFE_CHECKS
+	  size_t offset = m_stencil.at(local_row).offset[slot];
+#else
+	  size_t offset = m_stencil[local_row].offset[slot];
+#endif
+	  // e.g., a lateral neighbour of an edge face. Writing through it would corrupt another row
+	  if (offset == invalid_offset)
+	    BOOST_THROW_EXCEPTION(module_error() << errstr_info("Stencil entry " + std::to_string(slot) + " does not exist for row " + std::to_string(local_row)));
+	  return offset;
+	}
+
 	SolveConverge Solve();
 
 	double getSolutionMax();
@@ -113,6 +280,10 @@ namespace math
 
 	ArrayRCP<const double> getSolutionView();
 
+	// The assembled system. Only complete once Solve has called fillComplete
+	RCP<const crs_matrix_type> getMatrix() const { return m_matrix; }
+	RCP<const MV> getRhs() const { return m_rhs; }
+
 	// Dumping the problem and solution to MatrixMarket format for inspection
 	void writeSystemMatrixMarket(std::string file_prefix);
 	void writeSolutionMatrixMarket(std::string file_prefix);
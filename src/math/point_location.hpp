@@ -0,0 +1,364 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace math
+{
+    /*
+     * Point location in a triangle mesh.
+     *
+     * Triangles are bucketed on a uniform grid by their bounding box, so finding the triangle that contains a point only
+     * tests the few triangles in one grid cell. Callers that march along a ray in short steps can instead walk across
+     * triangle edges from the previous result, which usually takes one or two steps.
+     */
+    namespace point_location
+    {
+        class grid_index
+        {
+          public:
+            // triangle vertices, x0 y0 x1 y1 x2 y2
+            typedef std::array<double, 6> triangle;
+
+            grid_index() : _nx(0), _ny(0), _x0(0), _y0(0), _inv_dx(0), _inv_dy(0) {}
+
+            /**
+             * Builds the index
+             * @param triangles
+             * @param neighbors neighbors[t][i] is the triangle across the edge opposite vertex i, -1 for none
+             * @param per_cell Average # of triangles per grid cell
+             */
+            void build(std::vector<triangle> triangles, std::vector<std::array<int, 3>> neighbors,
+                       double per_cell = 2.0)
+            {
+                _tri = std::move(triangles);
+                _neighbors = std::move(neighbors);
+
+                const size_t n = _tri.size();
+                _cell_start.clear();
+                _cell_tri.clear();
+                _centroid_start.clear();
+                _nx = _ny = 0;
+                if (n == 0)
+                    return;
+
+                std::vector<double> cx(n), cy(n);
+                double xmin = std::numeric_limits<double>::max(), ymin = xmin;
+                double xmax = std::numeric_limits<double>::lowest(), ymax = xmax;
+                for (size_t t = 0; t < n; ++t)
+                {
+                    auto& v = _tri[t];
+                    cx[t] = (v[0] + v[2] + v[4]) / 3.0;
+                    cy[t] = (v[1] + v[3] + v[5]) / 3.0;
+                    for (int k = 0; k < 3; ++k)
+                    {
+                        xmin = std::min(xmin, v[2 * k]);
+                        xmax = std::max(xmax, v[2 * k]);
+                        ymin = std::min(ymin, v[2 * k + 1]);
+                        ymax = std::max(ymax, v[2 * k + 1]);
+                    }
+                }
+
+                // square cells sized so there are ~per_cell triangles in each
+                double w = std::max(xmax - xmin, 1e-12);
+                double h = std::max(ymax - ymin, 1e-12);
+                double cell = std::sqrt(w * h * per_cell / n);
+                _nx = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(std::ceil(w / cell)), 1 << 14));
+                _ny = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(std::ceil(h / cell)), 1 << 14));
+                _x0 = xmin;
+                _y0 = ymin;
+                _inv_dx = _nx / w;
+                _inv_dy = _ny / h;
+
+                // counting sort of the triangles into every cell their bounding box overlaps, as a CSR layout
+                _cell_start.assign(_nx * _ny + 1, 0);
+                for (int pass = 0; pass < 2; ++pass)
+                {
+                    std::vector<uint32_t> fill;
+                    if (pass == 1)
+                    {
+                        for (size_t c = 0; c < _nx * _ny; ++c)
+                            _cell_start[c + 1] += _cell_start[c];
+                        _cell_tri.resize(_cell_start.back());
+                        fill.assign(_cell_start.begin(), _cell_start.end() - 1);
+                    }
+
+                    for (size_t t = 0; t < n; ++t)
+                    {
+                        auto& v = _tri[t];
+                        size_t i0 = cell_x(std::min({v[0], v[2], v[4]}));
+                        size_t i1 = cell_x(std::max({v[0], v[2], v[4]}));
+                        size_t j0 = cell_y(std::min({v[1], v[3], v[5]}));
+                        size_t j1 = cell_y(std::max({v[1], v[3], v[5]}));
+                        for (size_t j = j0; j <= j1; ++j)
+                        {
+                            for (size_t i = i0; i <= i1; ++i)
+                            {
+                                size_t c = j * _nx + i;
+                                if (pass == 0)
+                                    _cell_start[c + 1] += 1;
+                                else
+                                    _cell_tri[fill[c]++] = static_cast<uint32_t>(t);
+                            }
+                        }
+                    }
+                }
+
+                // each triangle once more, in the cell its centroid is in, for the nearest centroid search
+                _centroid_start.assign(_nx * _ny + 1, 0);
+                std::vector<uint32_t> centroid_cell(n);
+                for (size_t t = 0; t < n; ++t)
+                {
+                    centroid_cell[t] = static_cast<uint32_t>(cell_y(cy[t]) * _nx + cell_x(cx[t]));
+                    _centroid_start[centroid_cell[t] + 1] += 1;
+                }
+                for (size_t c = 0; c < _nx * _ny; ++c)
+                    _centroid_start[c + 1] += _centroid_start[c];
+
+                _centroid_tri.resize(n);
+                _centroid_x.resize(n);
+                _centroid_y.resize(n);
+                std::vector<uint32_t> fill(_centroid_start.begin(), _centroid_start.end() - 1);
+                for (size_t t = 0; t < n; ++t)
+                {
+                    uint32_t k = fill[centroid_cell[t]]++;
+                    _centroid_tri[k] = static_cast<uint32_t>(t);
+                    _centroid_x[k] = cx[t];
+                    _centroid_y[k] = cy[t];
+                }
+            }
+
+            /**
+             * Triangle that contains (x,y), including its edges
+             * @return Triangle index, -1 if the point is outside of every triangle
+             */
+            int locate(double x, double y) const
+            {
+                if (_nx == 0 || !in_grid(x, y))
+                    return -1;
+
+                size_t c = cell_y(y) * _nx + cell_x(x);
+                for (uint32_t k = _cell_start[c]; k < _cell_start[c + 1]; ++k)
+                {
+                    if (contains(_cell_tri[k], x, y))
+                        return static_cast<int>(_cell_tri[k]);
+                }
+                return -1;
+            }
+
+            /**
+             * Triangle that contains (x,y), found by walking across edges starting from hint. Falls back to locate if
+             * the walk leaves the mesh or takes more than max_steps.
+             * @return Triangle index, -1 if the point is outside of every triangle
+             */
+            int walk(double x, double y, int hint, int max_steps = 32) const
+            {
+                if (hint < 0 || static_cast<size_t>(hint) >= _tri.size())
+                    return locate(x, y);
+
+                int t = hint;
+                for (int step = 0; step < max_steps; ++step)
+                {
+                    auto& v = _tri[t];
+                    double s = orientation(v[0], v[1], v[2], v[3], v[4], v[5]) >= 0 ? 1.0 : -1.0;
+
+                    // cross the edge (opposite vertex i) the point is most outside of
+                    int exit = -1;
+                    double worst = 0;
+                    for (int i = 0; i < 3; ++i)
+                    {
+                        int a = (i + 1) % 3;
+                        int b = (i + 2) % 3;
+                        double o = s * orientation(v[2 * a], v[2 * a + 1], v[2 * b], v[2 * b + 1], x, y);
+                        if (o < worst)
+                        {
+                            worst = o;
+                            exit = i;
+                        }
+                    }
+
+                    if (exit == -1)
+                        return t;
+
+                    t = _neighbors[t][exit];
+                    if (t < 0)
+                        break;
+                }
+
+                return locate(x, y);
+            }
+
+            /**
+             * Triangle with the centroid closest to (x,y). Always returns a triangle if the index is not empty.
+             */
+            int nearest_centroid(double x, double y) const
+            {
+                if (_tri.empty())
+                    return -1;
+
+                // search rings of cells outward from the query's cell, clamped to the grid, until the cells not yet
+                // searched are further away than the closest centroid found
+                const long nx = static_cast<long>(_nx);
+                const long ny = static_cast<long>(_ny);
+                const long ci = static_cast<long>(cell_x(x));
+                const long cj = static_cast<long>(cell_y(y));
+                const double dx = 1.0 / _inv_dx;
+                const double dy = 1.0 / _inv_dy;
+
+                int best = -1;
+                double best_d2 = std::numeric_limits<double>::max();
+
+                auto search_cell = [&](long i, long j)
+                {
+                    size_t c = j * _nx + i;
+                    for (uint32_t k = _centroid_start[c]; k < _centroid_start[c + 1]; ++k)
+                    {
+                        double ex = _centroid_x[k] - x;
+                        double ey = _centroid_y[k] - y;
+                        double d2 = ex * ex + ey * ey;
+                        int t = static_cast<int>(_centroid_tri[k]);
+                        if (d2 < best_d2 || (d2 == best_d2 && t < best))
+                        {
+                            best_d2 = d2;
+                            best = t;
+                        }
+                    }
+                };
+
+                // squared distance from the query to the rectangle [xa,xb] x [ya,yb]
+                auto rect_d2 = [x, y](double xa, double xb, double ya, double yb)
+                {
+                    double ex = std::max({xa - x, 0.0, x - xb});
+                    double ey = std::max({ya - y, 0.0, y - yb});
+                    return ex * ex + ey * ey;
+                };
+
+                for (long r = 0;; ++r)
+                {
+                    long i0 = std::max(ci - r, 0L), i1 = std::min(ci + r, nx - 1);
+                    long j0 = std::max(cj - r, 0L), j1 = std::min(cj + r, ny - 1);
+
+                    for (long j = j0; j <= j1; ++j)
+                    {
+                        // only the border of the ring, the inside was searched already
+                        bool row = j == cj - r || j == cj + r;
+                        for (long i = i0; i <= i1; ++i)
+                        {
+                            if (!row && i != ci - r && i != ci + r)
+                            {
+                                i = std::max(i, ci + r - 1);
+                                continue;
+                            }
+                            search_cell(i, j);
+                        }
+                    }
+
+                    // the cells left are in the slabs of the grid outside of the ring's box
+                    bool left = ci - r > 0, right = ci + r + 1 < nx, below = cj - r > 0, above = cj + r + 1 < ny;
+                    if (!left && !right && !below && !above)
+                        break;
+
+                    if (best >= 0)
+                    {
+                        double gx0 = _x0, gx1 = _x0 + nx * dx, gy0 = _y0, gy1 = _y0 + ny * dy;
+                        double rest = std::numeric_limits<double>::max();
+                        if (left)
+                            rest = std::min(rest, rect_d2(gx0, _x0 + (ci - r) * dx, gy0, gy1));
+                        if (right)
+                            rest = std::min(rest, rect_d2(_x0 + (ci + r + 1) * dx, gx1, gy0, gy1));
+                        if (below)
+                            rest = std::min(rest, rect_d2(gx0, gx1, gy0, _y0 + (cj - r) * dy));
+                        if (above)
+                            rest = std::min(rest, rect_d2(gx0, gx1, _y0 + (cj + r + 1) * dy, gy1));
+
+                        if (rest > best_d2)
+                            break;
+                    }
+                }
+
+                return best;
+            }
+
+            /**
+             * Is (x,y) inside or on an edge of triangle t
+             */
+            bool contains(size_t t, double x, double y) const
+            {
+                auto& v = _tri[t];
+                double d0 = orientation(v[0], v[1], v[2], v[3], x, y);
+                double d1 = orientation(v[2], v[3], v[4], v[5], x, y);
+                double d2 = orientation(v[4], v[5], v[0], v[1], x, y);
+
+                return (d0 >= 0 && d1 >= 0 && d2 >= 0) || (d0 <= 0 && d1 <= 0 && d2 <= 0);
+            }
+
+            size_t size() const { return _tri.size(); }
+
+          private:
+            // twice the signed area of (a, b, p), > 0 if p is left of a->b
+            static double orientation(double ax, double ay, double bx, double by, double px, double py)
+            {
+                return (bx - ax) * (py - ay) - (by - ay) * (px - ax);
+            }
+
+            bool in_grid(double x, double y) const
+            {
+                return x >= _x0 && y >= _y0 && (x - _x0) * _inv_dx <= _nx && (y - _y0) * _inv_dy <= _ny;
+            }
+
+            size_t cell_x(double x) const
+            {
+                return std::min(static_cast<size_t>(std::max(0.0, (x - _x0) * _inv_dx)), _nx - 1);
+            }
+
+            size_t cell_y(double y) const
+            {
+                return std::min(static_cast<size_t>(std::max(0.0, (y - _y0) * _inv_dy)), _ny - 1);
+            }
+
+            std::vector<triangle> _tri;
+            std::vector<std::array<int, 3>> _neighbors;
+
+            size_t _nx, _ny;
+            double _x0, _y0;
+            double _inv_dx, _inv_dy;
+
+            // triangles overlapping cell c are _cell_tri[_cell_start[c] .. _cell_start[c+1])
+            std::vector<uint32_t> _cell_start;
+            std::vector<uint32_t> _cell_tri;
+
+            // triangles with their centroid in cell c, and those centroids, are at [_centroid_start[c] .. _centroid_start[c+1])
+            std::vector<uint32_t> _centroid_start;
+            std::vector<uint32_t> _centroid_tri;
+            std::vector<double> _centroid_x, _centroid_y;
+        };
+    }
+}
@@ -0,0 +1,159 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace math
+{
+    /*
+     * Space-filling curve orderings of 2D points.
+     *
+     * Sorting mesh elements along a Hilbert or Morton (Z-order) curve keeps elements that are close in space close in
+     * memory, so neighbour lookups in stencil-type loops mostly hit data that is already in cache.
+     */
+    namespace space_filling_curve
+    {
+        enum class curve
+        {
+            none,
+            hilbert,
+            morton
+        };
+
+        // bits of resolution per axis. 16 gives a 65536^2 grid, far finer than any mesh we see in practice
+        const unsigned int order = 16;
+
+        /**
+         * Parses a curve name (none, hilbert, morton)
+         * @param name
+         * @param c Set to the curve if the name is known
+         * @return false if the name is not a known curve
+         */
+        inline bool from_string(const std::string& name, curve& c)
+        {
+            if (name == "none")
+                c = curve::none;
+            else if (name == "hilbert")
+                c = curve::hilbert;
+            else if (name == "morton")
+                c = curve::morton;
+            else
+                return false;
+
+            return true;
+        }
+
+        /**
+         * Distance along the Hilbert curve of the cell (x,y) of a 2^order x 2^order grid
+         */
+        inline uint64_t hilbert_key(uint32_t x, uint32_t y)
+        {
+            uint64_t d = 0;
+            for (uint32_t s = 1u << (order - 1); s > 0; s >>= 1)
+            {
+                uint32_t rx = (x & s) > 0;
+                uint32_t ry = (y & s) > 0;
+                d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+                // rotate the quadrant so the sub-curve is in the canonical orientation
+                if (ry == 0)
+                {
+                    if (rx == 1)
+                    {
+                        x = s - 1 - (x & (s - 1));
+                        y = s - 1 - (y & (s - 1));
+                    }
+                    std::swap(x, y);
+                }
+            }
+            return d;
+        }
+
+        /**
+         * Morton (Z-order) key of the cell (x,y): the bits of x and y interleaved
+         */
+        inline uint64_t morton_key(uint32_t x, uint32_t y)
+        {
+            auto spread = [](uint64_t v)
+            {
+                v &= 0xFFFFFFFF;
+                v = (v | (v << 16)) & 0x0000FFFF0000FFFF;
+                v = (v | (v << 8)) & 0x00FF00FF00FF00FF;
+                v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0F;
+                v = (v | (v << 2)) & 0x3333333333333333;
+                v = (v | (v << 1)) & 0x5555555555555555;
+                return v;
+            };
+            return spread(x) | (spread(y) << 1);
+        }
+
+        /**
+         * Orders points along a space-filling curve through their bounding box
+         * @param x
+         * @param y
+         * @param c
+         * @return Permutation such that result[new position] = old index. Ties keep their input order, and curve::none
+         * returns the identity.
+         */
+        inline std::vector<size_t> ordering(const std::vector<double>& x, const std::vector<double>& y, curve c)
+        {
+            const size_t n = x.size();
+            std::vector<size_t> permutation(n);
+            std::iota(permutation.begin(), permutation.end(), 0);
+
+            if (c == curve::none || n == 0)
+                return permutation;
+
+            auto xr = std::minmax_element(x.begin(), x.end());
+            auto yr = std::minmax_element(y.begin(), y.end());
+            double xmin = *xr.first;
+            double ymin = *yr.first;
+
+            // use the same scale on both axes so the curve is not stretched on elongated domains
+            double extent = std::max(*xr.second - xmin, *yr.second - ymin);
+            const double cells = static_cast<double>((1u << order) - 1);
+            double scale = extent > 0 ? cells / extent : 0;
+
+            std::vector<uint64_t> key(n);
+#pragma omp parallel for
+            for (size_t i = 0; i < n; ++i)
+            {
+                auto xi = static_cast<uint32_t>((x[i] - xmin) * scale);
+                auto yi = static_cast<uint32_t>((y[i] - ymin) * scale);
+                key[i] = c == curve::hilbert ? hilbert_key(xi, yi) : morton_key(xi, yi);
+            }
+
+            std::stable_sort(permutation.begin(), permutation.end(),
+                             [&key](size_t a, size_t b) { return key[a] < key[b]; });
+
+            return permutation;
+        }
+    }
+}
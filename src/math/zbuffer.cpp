@@ -0,0 +1,249 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "zbuffer.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace math
+{
+    namespace shading
+    {
+        zbuffer::zbuffer()
+        {
+            _requested_cell_size = 0;
+            _max_cells = 8192;
+
+            _cell_size = 0;
+            _nx = 0;
+            _ny = 0;
+        }
+
+        void zbuffer::set_cell_size(double cell_size)
+        {
+            _requested_cell_size = cell_size;
+        }
+
+        void zbuffer::set_max_cells(size_t max_cells)
+        {
+            _max_cells = std::max<size_t>(max_cells, 1);
+        }
+
+        size_t zbuffer::nx()
+        {
+            return _nx;
+        }
+
+        size_t zbuffer::ny()
+        {
+            return _ny;
+        }
+
+        double zbuffer::cell_size()
+        {
+            return _cell_size;
+        }
+
+        void zbuffer::compute(const std::vector<double>& xyz, double azimuth, double elevation,
+                              std::vector<int>& shadow, std::vector<double>& z_prime)
+        {
+            const size_t ntri = xyz.size() / 9;
+
+            shadow.assign(ntri, 0);
+            z_prime.assign(ntri, 0);
+
+            if (ntri == 0)
+                return;
+
+            // euler rotation matrix K, eqns(6) & (7) in Montero. Same as Marsh_shading_iswr
+            const double z0 = M_PI - azimuth * M_PI / 180.0;
+            const double q0 = M_PI / 2.0 - elevation * M_PI / 180.0;
+
+            const double K[3][3] = {{cos(z0), sin(z0), 0},
+                                    {-cos(q0) * sin(z0), cos(q0) * cos(z0), sin(q0)},
+                                    {sin(q0) * sin(z0), -cos(z0) * sin(q0), cos(q0)}};
+
+            // rotate relative to the first vertex so UTM sized coordinates don't eat the float precision of the buffer
+            const double ox = xyz[0];
+            const double oy = xyz[1];
+            const double oz = xyz[2];
+            const double z_offset = K[2][0] * ox + K[2][1] * oy + K[2][2] * oz;
+
+            _rot.resize(ntri * 9);
+
+            double xmin = std::numeric_limits<double>::max();
+            double ymin = std::numeric_limits<double>::max();
+            double xmax = std::numeric_limits<double>::lowest();
+            double ymax = std::numeric_limits<double>::lowest();
+            double area = 0;
+
+#pragma omp parallel for reduction(min:xmin,ymin) reduction(max:xmax,ymax) reduction(+:area)
+            for (size_t t = 0; t < ntri; ++t)
+            {
+                double* r = &_rot[9 * t];
+                for (size_t v = 0; v < 3; ++v)
+                {
+                    const double x = xyz[9 * t + 3 * v] - ox;
+                    const double y = xyz[9 * t + 3 * v + 1] - oy;
+                    const double z = xyz[9 * t + 3 * v + 2] - oz;
+
+                    r[3 * v] = K[0][0] * x + K[0][1] * y + K[0][2] * z;
+                    r[3 * v + 1] = K[1][0] * x + K[1][1] * y + K[1][2] * z;
+                    r[3 * v + 2] = K[2][0] * x + K[2][1] * y + K[2][2] * z;
+
+                    xmin = std::min(xmin, r[3 * v]);
+                    xmax = std::max(xmax, r[3 * v]);
+                    ymin = std::min(ymin, r[3 * v + 1]);
+                    ymax = std::max(ymax, r[3 * v + 1]);
+                }
+
+                area += 0.5 * std::fabs((r[3] - r[0]) * (r[7] - r[1]) - (r[6] - r[0]) * (r[4] - r[1]));
+                z_prime[t] = (r[2] + r[5] + r[8]) / 3.0;
+            }
+
+            // pick the cell size, then grow it if the grid would be too large
+            double h = _requested_cell_size;
+            if (h <= 0)
+                h = 0.5 * std::sqrt(area / ntri);
+
+            h = std::max({h, (xmax - xmin) / _max_cells, (ymax - ymin) / _max_cells});
+            if (!(h > 0))
+                h = 1; // everything projects to a point, e.g., a single degenerate triangle
+
+            _cell_size = h;
+            _nx = std::min(_max_cells, static_cast<size_t>((xmax - xmin) / h) + 1);
+            _ny = std::min(_max_cells, static_cast<size_t>((ymax - ymin) / h) + 1);
+
+            _depth.assign(_nx * _ny, std::numeric_limits<float>::lowest());
+
+            auto col = [&](double x) -> size_t
+            {
+                return std::min(_nx - 1, static_cast<size_t>(std::max(0.0, (x - xmin) / h)));
+            };
+            auto row = [&](double y) -> size_t
+            {
+                return std::min(_ny - 1, static_cast<size_t>(std::max(0.0, (y - ymin) / h)));
+            };
+
+            // Tiles are bands of rows. A triangle is listed in every band it overlaps and each band is rasterized by
+            // one thread, so depth writes never race.
+            const size_t band_rows = 64;
+            const size_t nbands = (_ny + band_rows - 1) / band_rows;
+            std::vector<std::vector<size_t>> bands(nbands);
+
+            for (size_t t = 0; t < ntri; ++t)
+            {
+                const double* r = &_rot[9 * t];
+                size_t b0 = row(std::min({r[1], r[4], r[7]})) / band_rows;
+                size_t b1 = row(std::max({r[1], r[4], r[7]})) / band_rows;
+                for (size_t b = b0; b <= b1; ++b)
+                    bands[b].push_back(t);
+            }
+
+            const double eps = 1e-12 * h * h;
+
+#pragma omp parallel for schedule(dynamic)
+            for (size_t b = 0; b < nbands; ++b)
+            {
+                const size_t rb0 = b * band_rows;
+                const size_t rb1 = std::min(_ny, rb0 + band_rows) - 1;
+
+                for (auto t : bands[b])
+                {
+                    const double* r = &_rot[9 * t];
+                    const double x0 = r[0], y0 = r[1], d0 = r[2];
+                    const double x1 = r[3], y1 = r[4], d1 = r[5];
+                    const double x2 = r[6], y2 = r[7], d2 = r[8];
+
+                    // always sample the centroid so triangles smaller than a cell still occlude
+                    size_t cr = row((y0 + y1 + y2) / 3.0);
+                    if (cr >= rb0 && cr <= rb1)
+                    {
+                        float& d = _depth[cr * _nx + col((x0 + x1 + x2) / 3.0)];
+                        d = std::max(d, static_cast<float>(z_prime[t]));
+                    }
+
+                    const double det = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+                    if (std::fabs(det) <= eps)
+                        continue; // edge on to the sun
+
+                    const size_t c0 = col(std::min({x0, x1, x2}));
+                    const size_t c1 = col(std::max({x0, x1, x2}));
+                    const size_t r0 = std::max(rb0, row(std::min({y0, y1, y2})));
+                    const size_t r1 = std::min(rb1, row(std::max({y0, y1, y2})));
+
+                    for (size_t j = r0; j <= r1; ++j)
+                    {
+                        const double py = ymin + (j + 0.5) * h - y0;
+                        for (size_t i = c0; i <= c1; ++i)
+                        {
+                            const double px = xmin + (i + 0.5) * h - x0;
+
+                            // barycentric coordinates of the cell centre
+                            const double l1 = (px * (y2 - y0) - (x2 - x0) * py) / det;
+                            const double l2 = ((x1 - x0) * py - px * (y1 - y0)) / det;
+                            const double l0 = 1.0 - l1 - l2;
+
+                            if (l0 < 0 || l1 < 0 || l2 < 0)
+                                continue;
+
+                            float& d = _depth[j * _nx + i];
+                            d = std::max(d, static_cast<float>(l0 * d0 + l1 * d1 + l2 * d2));
+                        }
+                    }
+                }
+            }
+
+            // slope-scaled bias so a triangle doesn't shadow itself or its neighbours because of the cell discretization.
+            // Near edge-on triangles have an unbounded slope, so cap it.
+            const double max_slope = 10;
+
+#pragma omp parallel for
+            for (size_t t = 0; t < ntri; ++t)
+            {
+                const double* r = &_rot[9 * t];
+                const double x0 = r[0], y0 = r[1], d0 = r[2];
+                const double x1 = r[3], y1 = r[4], d1 = r[5];
+                const double x2 = r[6], y2 = r[7], d2 = r[8];
+
+                const double det = (x1 - x0) * (y2 - y0) - (x2 - x0) * (y1 - y0);
+                double slope = max_slope;
+                if (std::fabs(det) > eps)
+                {
+                    const double dzdx = ((d1 - d0) * (y2 - y0) - (d2 - d0) * (y1 - y0)) / det;
+                    const double dzdy = ((x1 - x0) * (d2 - d0) - (x2 - x0) * (d1 - d0)) / det;
+                    slope = std::min(max_slope, std::fabs(dzdx) + std::fabs(dzdy));
+                }
+                const double bias = h * (1e-3 + slope);
+
+                const float depth = _depth[row((y0 + y1 + y2) / 3.0) * _nx + col((x0 + x1 + x2) / 3.0)];
+                shadow[t] = depth > z_prime[t] + bias ? 1 : 0;
+
+                z_prime[t] += z_offset;
+            }
+        }
+    }
+}
@@ -0,0 +1,91 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace math
+{
+    namespace shading
+    {
+        /**
+         * Sun-view depth buffer for terrain self-shadowing.
+         *
+         * Every triangle is rotated into a frame whose z axis points at the sun and rasterized into a regular grid
+         * over the rotated x/y plane, keeping the depth (z) nearest the sun per cell. A triangle is shadowed if
+         * the buffer holds something nearer the sun than the triangle at the cell under its centroid. This is the
+         * same criterion as Marsh et al (2012), but costs O(triangles + cells) instead of pairwise comparisons.
+         *
+         * The engine works on its own copy of the coordinates; the mesh is never modified.
+         */
+        class zbuffer
+        {
+          public:
+            zbuffer();
+
+            /**
+             * Size of a depth cell in the rotated frame, in the units of the coordinates.
+             * A value <= 0 picks half the square root of the mean projected triangle area.
+             * @param cell_size
+             */
+            void set_cell_size(double cell_size);
+
+            /**
+             * Upper bound on cells per side of the grid. If the domain would need more, the cell size is increased.
+             * @param max_cells
+             */
+            void set_max_cells(size_t max_cells);
+
+            /**
+             * Computes the shadows for one sun position.
+             * @param xyz Triangle vertex coordinates, 9 per triangle: x0,y0,z0,x1,y1,z1,x2,y2,z2
+             * @param azimuth Solar azimuth, degrees CW from north
+             * @param elevation Solar elevation, degrees
+             * @param shadow Output, 1 if the triangle is shadowed, else 0. Resized to the number of triangles.
+             * @param z_prime Output, depth of the triangle centroid toward the sun. Resized to the number of triangles.
+             */
+            void compute(const std::vector<double>& xyz, double azimuth, double elevation,
+                         std::vector<int>& shadow, std::vector<double>& z_prime);
+
+            /// Grid dimensions and cell size used by the last compute
+            size_t nx();
+            size_t ny();
+            double cell_size();
+
+          private:
+            double _requested_cell_size;
+            size_t _max_cells;
+
+            // state of the last compute
+            double _cell_size;
+            size_t _nx, _ny;
+            std::vector<float> _depth;
+
+            // rotated coordinates, 9 per triangle, relative to the first vertex
+            std::vector<double> _rot;
+        };
+    }
+}
@@ -25,6 +25,11 @@ triangulation::triangulation()
     _is_geographic = false;
     _UTM_zone = 0;
     _terrain_deformed=false;
+    _next_ghost_exchange_tag = 0;
+    _face_ordering = math::space_filling_curve::curve::none;
+    _vtu_data_mode = "appended";
+    _vtu_compressor = "none";
+    _vtu_compression_level = 5;
     _min_z =  999999;
     _max_z = -999999;
 
@@ -121,20 +126,10 @@ mesh_elem triangulation::locate_face(double x, double y)
 
 mesh_elem triangulation::locate_face(Point_2 query)
 {
-    // In some limited cases triangles can be arranged in a circle around a central vertex
-    // In this case, there could be 360/21.5 = 16 and change triangles.
-    // So just grab the nearest 17 triangles, one of these will hold the point we need
-    K_neighbor_search search(*dD_tree, query, 17);
-
-    //check if the closest is what we wanted
-    for(auto itr: search)
-    {
-      auto f = boost::get<1>(itr.first); //grab the triangle from the iterator
-      if(!f->is_ghost &&
-          f->contains(query.x(),query.y()))
-        return boost::get<1>(itr.first);
-    }
+    auto f = find_containing_face(query);
 
+    if(f != nullptr && !f->is_ghost)
+        return f;
 
     //we tried....
     return nullptr;
@@ -169,12 +164,8 @@ std::vector< mesh_elem > triangulation::find_faces_in_radius(double x, double y,
 
 mesh_elem triangulation::find_closest_face(Point_2 query) const
 {
-    K_neighbor_search search(*dD_tree, query, 1);
-
-    //return the first face only
-    auto it = search.begin();
-    return  boost::get<1>(it->first);
-
+    int id = _point_index.nearest_centroid(query.x(), query.y());
+    return _point_index_faces.at(id);
 }
 mesh_elem triangulation::find_closest_face(double x, double y) const
 {
@@ -185,6 +176,39 @@ mesh_elem triangulation::find_closest_face(double x, double y) const
 
 }
 
+mesh_elem triangulation::find_containing_face(Point_2 query, mesh_elem hint) const
+{
+    int id = -1;
+    if(hint != nullptr && hint->point_location_id >= 0 &&
+       static_cast<size_t>(hint->point_location_id) < _point_index_faces.size() &&
+       _point_index_faces[hint->point_location_id] == hint)
+        id = _point_index.walk(query.x(), query.y(), hint->point_location_id);
+    else
+        id = _point_index.locate(query.x(), query.y());
+
+    if(id < 0)
+        return nullptr;
+
+    return _point_index_faces[id];
+}
+
+mesh_elem triangulation::find_face(Point_2 query, mesh_elem hint) const
+{
+    auto f = find_containing_face(query, hint);
+
+    if(f == nullptr)
+        f = find_closest_face(query);
+
+    return f;
+}
+
+mesh_elem triangulation::find_face(double x, double y, mesh_elem hint) const
+{
+    Point_2 query(x,y);
+
+    return find_face(query, hint);
+}
+
 
 void triangulation::serialize_parameter(std::string output_path, std::string parameter)
 {
@@ -485,8 +509,9 @@ void triangulation::from_json(pt::ptree &mesh)
 
     }catch(pt::ptree_bad_path& e)
     {
-        // If not, just ignore the exception
+        // If not, order the faces spatially so that neighbours are close in memory
         LOG_DEBUG << "No face permutation.";
+        reorder_spatially(_face_ordering);
     }
 
     // Don't actually want to partition the mesh. Use the non-MPI one
@@ -1051,6 +1076,39 @@ void triangulation::_build_dDtree()
     dD_tree = boost::make_shared<Tree>(boost::make_zip_iterator(boost::make_tuple( center_points.begin(),_faces.begin() )),
                                        boost::make_zip_iterator(boost::make_tuple( center_points.end(),  _faces.end() ) )
     );
+
+    LOG_DEBUG << "Building point location index";
+
+    // the index refers to faces by their position here, so keep its own copy in case _faces changes afterwards
+    _point_index_faces = _faces;
+
+#pragma omp parallel for
+    for(size_t ii=0; ii < nfaces; ++ii)
+    {
+        _faces.at(ii)->point_location_id = ii;
+    }
+
+    std::vector<math::point_location::grid_index::triangle> triangles(nfaces);
+    std::vector<std::array<int,3>> neighbors(nfaces);
+
+#pragma omp parallel for
+    for(size_t ii=0; ii < nfaces; ++ii)
+    {
+        auto face = _faces.at(ii);
+        for (int j = 0; j < 3; ++j)
+        {
+            triangles[ii][2 * j] = face->vertex(j)->point().x();
+            triangles[ii][2 * j + 1] = face->vertex(j)->point().y();
+
+            // neighbor(j) is opposite vertex(j), as the index expects. A neighbour that is not in _faces may still
+            // hold an id from a previous build, so check it refers back to the same face
+            auto neigh = face->neighbor(j);
+            int id = neigh != nullptr ? neigh->point_location_id : -1;
+            neighbors[ii][j] = id >= 0 && static_cast<size_t>(id) < nfaces && _faces[id] == neigh ? id : -1;
+        }
+    }
+
+    _point_index.build(std::move(triangles), std::move(neighbors));
 }
 
 void triangulation::from_partitioned_hdf5(const std::string& partition_filename,
@@ -1408,6 +1466,45 @@ void triangulation::reorder_faces(std::vector<size_t> permutation)
   		     });
 }
 
+void triangulation::reorder_spatially(math::space_filling_curve::curve c)
+{
+    if (c == math::space_filling_curve::curve::none)
+        return;
+
+    LOG_DEBUG << "Ordering faces and vertices along a "
+              << (c == math::space_filling_curve::curve::hilbert ? "Hilbert" : "Morton") << " curve";
+
+    std::vector<double> x(_faces.size());
+    std::vector<double> y(_faces.size());
+    for (size_t i = 0; i < _faces.size(); ++i)
+    {
+        auto p = _faces[i]->center();
+        x[i] = p.x();
+        y[i] = p.y();
+    }
+
+    // new position -> current position in _faces, as reorder_faces expects
+    auto order = math::space_filling_curve::ordering(x, y, c);
+    reorder_faces(order);
+
+    x.resize(_vertexes.size());
+    y.resize(_vertexes.size());
+    for (size_t i = 0; i < _vertexes.size(); ++i)
+    {
+        x[i] = _vertexes[i]->point().x();
+        y[i] = _vertexes[i]->point().y();
+    }
+
+    order = math::space_filling_curve::ordering(x, y, c);
+    std::vector<Delaunay::Vertex_handle> vertexes(_vertexes.size());
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        vertexes[i] = _vertexes[order[i]];
+        vertexes[i]->set_id(i);
+    }
+    _vertexes.swap(vertexes);
+}
+
 void triangulation::load_partition_from_mesh(const std::string& mesh_filename)
 {
     // This differs from partition_mesh() in that the partitioned mesh has ghosts mixed in with the faces so that
@@ -1910,6 +2007,8 @@ void triangulation::setup_nearest_neighbor_communication()
   // Wait for all comms to finish before proceeding
   boost::mpi::wait_all(reqs.begin(), reqs.end());
 
+  _comm_ghost = boost::mpi::communicator(_comm_world, boost::mpi::comm_duplicate);
+
   for (auto it : global_indices_to_send) {
     auto partner_id = it.first;
     auto indices = it.second;
@@ -1971,215 +2070,190 @@ void triangulation::ghost_neighbors_communicate_variable(const std::string& var)
 
 void triangulation::ghost_neighbors_communicate_variable(const uint64_t& var)
 {
-
-// Function is meaningful only when using MPI
-#ifdef USE_MPI
-
   // For each communication partner:
   // - pack vectors of the variable to send
   // - send/recv it
-  // - unpack the recv'd vectors into mesh_elem->face_data (so it can be used exactly as local info)
-
-  std::vector<boost::mpi::request> reqs;
+  // - unpack the recv'd vectors into the face variables (so it can be used exactly as local info)
+  // The plan is kept so the buffers and requests are reused on the next call for this variable.
 
-  for(auto it : local_faces_to_send) {
-    auto partner_id = it.first;
-    auto faces = it.second;
-    std::vector<double> send_buffer(faces.size());
-    std::transform(faces.begin(), faces.end(),
-		   send_buffer.begin(),
-		   [var](mesh_elem e){
-		     return (*e)[var]; });
-
-    for(int i=0; i < send_buffer.size(); ++i) {
-      double val = send_buffer[i];
-      if( isnan(val) )	{
-	  auto f = local_faces_to_send[partner_id][i];
-	  LOG_DEBUG << "-------------------------------------------------";
-	  LOG_DEBUG << "Detected SEND variable is NaN:";
-	  LOG_DEBUG << "\tmy rank:            " << f->owner;
-	  LOG_DEBUG << "\tdestination rank:  " << partner_id;
-	  LOG_DEBUG << "\tsend_buffer entry: " << i;
-	  LOG_DEBUG << "\tcell_global_id:    " << f->cell_global_id;
-	  LOG_DEBUG << "\tcell_local_id:      " << f->cell_local_id;
-          LOG_DEBUG << "\tvalue:       " << val;
-//	  _mpi_env.abort(-1);
-	}
-    }
-
-
-    // Send variables
-    int send_tag = generate_unique_send_tag(_comm_world.rank(), partner_id);
-    _comm_world.isend(partner_id, send_tag, send_buffer);
-
-  }
-
-  // map of received data from comm partners
-  std::map< int, std::vector<double>> recv_buffer;
-  for( auto it : ghost_faces_to_recv) {
-    auto partner_id = it.first;
-    auto faces = it.second;
-    recv_buffer[partner_id] = std::vector<double>(faces.size(),0.0);
-  }
+// Function is meaningful only when using MPI
+#ifdef USE_MPI
+  auto& plan = _ghost_exchange_to_ghosts[var];
+  if (!plan)
+    plan = make_ghost_exchange(std::vector<uint64_t>{var}, ghost_exchange::direction::to_ghosts);
 
-  for(auto it : ghost_faces_to_recv) {
-    auto partner_id = it.first;
+  plan->exchange();
+#endif // USE_MPI
+}
 
-    // Note only recv gets added to the list of requests to watch for
-    int recv_tag = generate_unique_recv_tag(_comm_world.rank(), partner_id);
-    reqs.push_back(_comm_world.irecv(partner_id, recv_tag, recv_buffer[partner_id] ));
-  }
+void triangulation::ghost_to_neighbors_communicate_variable(const std::string& var)
+{
+    // This supports the use case if _s no-oped to const char * via
+    uint64_t hash = xxh64::hash (var.c_str(), var.length());
+    ghost_to_neighbors_communicate_variable(hash);
+}
 
-  // Wait for all communication to me before proceeding
-  boost::mpi::wait_all(reqs.begin(), reqs.end());
+void triangulation::ghost_to_neighbors_communicate_variable(const uint64_t& var)
+{
+#ifdef USE_MPI
+  auto& plan = _ghost_exchange_from_ghosts[var];
+  if (!plan)
+    plan = make_ghost_exchange(std::vector<uint64_t>{var}, ghost_exchange::direction::from_ghosts);
 
-  // Check for NaN entries in recv_buffer
-  for(auto it : recv_buffer) {
-    auto partner_id = it.first;
-    auto values = it.second;
-    for(int i=0; i < values.size(); ++i) {
-      double val = values[i];
-      if( isnan(val) )	{
-	auto f = ghost_faces_to_recv[partner_id][i];
-	  LOG_DEBUG << "-------------------------------------------------";
-	  LOG_DEBUG << "Detected RECV variable is NaN:";
-	  LOG_DEBUG << "\tmy rank:            " << f->owner;
-	  LOG_DEBUG << "\tsent from rank:     " << partner_id;
-	  LOG_DEBUG << "\trecv_buffer entry:  " << i;
-	  LOG_DEBUG << "\tcell_global_id:     " << f->cell_global_id;
-	  LOG_DEBUG << "\tcell_local_id:       " << f->cell_local_id;
-          LOG_DEBUG << "\tvalue:       " << val;
-//	  _mpi_env.abort(-1);
-	}
-    }
+  plan->exchange();
+#endif // USE_MPI
+}
 
-  }
+void triangulation::clear_ghost_exchanges()
+{
+  _ghost_exchange_to_ghosts.clear();
+  _ghost_exchange_from_ghosts.clear();
+}
 
-  // Pack the data into the face pointers
-  for(auto it : ghost_faces_to_recv) {
-    auto partner_id = it.first;
-    auto faces = it.second;
+std::shared_ptr<ghost_exchange> triangulation::make_ghost_exchange(const std::vector<std::string>& variables,
+                                                                   ghost_exchange::direction dir)
+{
+  std::vector<uint64_t> hashes;
+  for (auto& v : variables)
+    hashes.push_back(xxh64::hash(v.c_str(), v.length()));
 
-    auto recv_it = recv_buffer[partner_id].begin();
-    for (auto f : faces ) {
+  return make_ghost_exchange(hashes, dir);
+}
 
-      (*f)[var] = *recv_it;
-//      LOG_DEBUG << "Rank=" <<f->owner << " Var="<<var<<" *f="<<(*f)[var]<< " recv_it="<<*recv_it << " is_ghost="<<f->is_ghost;
-      ++recv_it;
-    }
+std::shared_ptr<ghost_exchange> triangulation::make_ghost_exchange(const std::vector<uint64_t>& variables,
+                                                                   ghost_exchange::direction dir)
+{
+  return std::make_shared<ghost_exchange>(*this, variables, dir, _next_ghost_exchange_tag++);
+}
 
-  }
+ghost_exchange::ghost_exchange(triangulation& domain, const std::vector<uint64_t>& variables, direction dir, int tag)
+    : _domain(domain), _in_flight(false)
+{
+  for (auto& v : variables)
+    _columns.push_back(domain.face_variables().index(v));
 
-#endif // USE_MPI
+#ifdef USE_MPI
+  auto& to_owned = domain.local_faces_to_send;
+  auto& to_ghosts = domain.ghost_faces_to_recv;
 
-}
+  auto& send_faces = dir == direction::to_ghosts ? to_owned : to_ghosts;
+  auto& recv_faces = dir == direction::to_ghosts ? to_ghosts : to_owned;
 
-void triangulation::ghost_to_neighbors_communicate_variable(const std::string& var)
-{
-    // This supports the use case if _s no-oped to const char * via
-    uint64_t hash = xxh64::hash (var.c_str(), var.length());
-    ghost_to_neighbors_communicate_variable(hash);
+  auto make_partners = [&](const std::map<int, std::vector<mesh_elem>>& faces, std::vector<partner>& partners)
+  {
+    for (auto& it : faces)
+    {
+      partner p;
+      p.rank = it.first;
+      p.cells.reserve(it.second.size());
+      for (auto& f : it.second)
+        p.cells.push_back(f->storage_id);
+      p.buffer.resize(p.cells.size() * _columns.size());
+      partners.push_back(std::move(p));
+    }
+  };
+  make_partners(send_faces, _send);
+  make_partners(recv_faces, _recv);
+
+  // the partner buffers don't move from here on, so the persistent requests can point at them
+  MPI_Comm comm = domain._comm_ghost;
+  _requests.resize(_send.size() + _recv.size());
+  size_t r = 0;
+  for (auto& p : _send)
+    MPI_Send_init(p.buffer.data(), p.buffer.size(), MPI_DOUBLE, p.rank, tag, comm, &_requests[r++]);
+  for (auto& p : _recv)
+    MPI_Recv_init(p.buffer.data(), p.buffer.size(), MPI_DOUBLE, p.rank, tag, comm, &_requests[r++]);
+#endif
 }
 
-void triangulation::ghost_to_neighbors_communicate_variable(const uint64_t& var)
+ghost_exchange::~ghost_exchange()
 {
-
-// Function is meaningful only when using MPI
 #ifdef USE_MPI
+  // Freeing a request after MPI_Finalize is erroneous. Plans should be released before then, see core::~core
+  int finalized = 0;
+  MPI_Finalized(&finalized);
+  if (finalized)
+    return;
 
-    // For each communication partner:
-    // - pack vectors of the variable to send
-    // - send/recv it
-    // - unpack the recv'd vectors into mesh_elem->face_data (so it can be used exactly as local info)
-
-    std::vector<boost::mpi::request> reqs;
-
-    for(auto it : ghost_faces_to_recv) {
-        auto partner_id = it.first;
-        auto faces = it.second;
-        std::vector<double> send_buffer(faces.size());
-        std::transform(faces.begin(), faces.end(),
-                       send_buffer.begin(),
-                       [var](mesh_elem e){
-                           return (*e)[var]; });
-
-        for(int i=0; i < send_buffer.size(); ++i) {
-            double val = send_buffer[i];
-            if( isnan(val) )	{
-                auto f = ghost_faces_to_recv[partner_id][i];
-                LOG_DEBUG << "-------------------------------------------------";
-                LOG_DEBUG << "Detected SEND variable is NaN:";
-                LOG_DEBUG << "\tmy rank:            " << f->owner;
-                LOG_DEBUG << "\tdestination rank:  " << partner_id;
-                LOG_DEBUG << "\tsend_buffer entry: " << i;
-                LOG_DEBUG << "\tcell_global_id:    " << f->cell_global_id;
-                LOG_DEBUG << "\tcell_local_id:      " << f->cell_local_id;
-                //	  _mpi_env.abort(-1);
-            }
-        }
+  if (_in_flight)
+    wait();
 
+  for (auto& r : _requests)
+    MPI_Request_free(&r);
+#endif
+}
 
-        // Send variables
-        int send_tag = generate_unique_send_tag(_comm_world.rank(), partner_id);
-        _comm_world.isend(partner_id, send_tag, send_buffer);
+void ghost_exchange::start()
+{
+  if (_in_flight)
+    CHM_THROW_EXCEPTION(mesh_error, "ghost_exchange::start called while an exchange is in flight");
 
+#ifdef USE_MPI
+  auto& storage = _domain.face_variables();
+  for (auto& p : _send)
+  {
+    const size_t n = p.cells.size();
+    for (size_t v = 0; v < _columns.size(); ++v)
+    {
+      double* buf = &p.buffer[v * n];
+      for (size_t i = 0; i < n; ++i)
+        buf[i] = storage(_columns[v], p.cells[i]);
     }
 
-    // map of received data from comm partners
-    std::map< int, std::vector<double>> recv_buffer;
-    for( auto it : local_faces_to_send) {
-        auto partner_id = it.first;
-        auto faces = it.second;
-        recv_buffer[partner_id] = std::vector<double>(faces.size(),0.0);
+#ifdef SAFE_CHECKS
+    for (size_t i = 0; i < p.buffer.size(); ++i)
+    {
+      if (std::isnan(p.buffer[i]))
+        LOG_DEBUG << "Detected SEND variable is NaN: destination rank " << p.rank << " storage_id " << p.cells[i % n];
     }
+#endif
+  }
 
-    for(auto it : local_faces_to_send) {
-        auto partner_id = it.first;
-
-        // Note only recv gets added to the list of requests to watch for
-        int recv_tag = generate_unique_recv_tag(_comm_world.rank(), partner_id);
-        reqs.push_back(_comm_world.irecv(partner_id, recv_tag, recv_buffer[partner_id] ));
-    }
+  if (!_requests.empty())
+    MPI_Startall(_requests.size(), _requests.data());
+#endif
 
-    // Wait for all communication to me before proceeding
-    boost::mpi::wait_all(reqs.begin(), reqs.end());
+  _in_flight = true;
+}
 
-    // Check for NaN entries in recv_buffer
-    for(auto it : recv_buffer) {
-        auto partner_id = it.first;
-        auto values = it.second;
-        for(int i=0; i < values.size(); ++i) {
-            double val = values[i];
-            if( isnan(val) )	{
-                auto f = local_faces_to_send[partner_id][i];
-                LOG_DEBUG << "-------------------------------------------------";
-                LOG_DEBUG << "Detected RECV variable is NaN:";
-                LOG_DEBUG << "\tmy rank:            " << f->owner;
-                LOG_DEBUG << "\tsent from rank:     " << partner_id;
-                LOG_DEBUG << "\trecv_buffer entry:  " << i;
-                LOG_DEBUG << "\tcell_global_id:     " << f->cell_global_id;
-                LOG_DEBUG << "\tcell_local_id:       " << f->cell_local_id;
-                //	  _mpi_env.abort(-1);
-            }
-        }
+void ghost_exchange::wait()
+{
+  if (!_in_flight)
+    return;
 
-    }
+#ifdef USE_MPI
+  if (!_requests.empty())
+    MPI_Waitall(_requests.size(), _requests.data(), MPI_STATUSES_IGNORE);
 
-    // Pack the data into the face pointers
-    for(auto it : local_faces_to_send) {
-        auto partner_id = it.first;
-        auto faces = it.second;
+  auto& storage = _domain.face_variables();
+  for (auto& p : _recv)
+  {
+    const size_t n = p.cells.size();
 
-        auto recv_it = recv_buffer[partner_id].begin();
-        for (auto f : faces ) {
-            (*f)[var] = *recv_it;
-            ++recv_it;
-        }
+#ifdef SAFE_CHECKS
+    for (size_t i = 0; i < p.buffer.size(); ++i)
+    {
+      if (std::isnan(p.buffer[i]))
+        LOG_DEBUG << "Detected RECV variable is NaN: sent from rank " << p.rank << " storage_id " << p.cells[i % n];
+    }
+#endif
 
+    for (size_t v = 0; v < _columns.size(); ++v)
+    {
+      const double* buf = &p.buffer[v * n];
+      for (size_t i = 0; i < n; ++i)
+        storage(_columns[v], p.cells[i]) = buf[i];
     }
+  }
+#endif
 
-#endif // USE_MPI
+  _in_flight = false;
+}
 
+void ghost_exchange::exchange()
+{
+  start();
+  wait();
 }
 
 void dfs_to_max_distance_aux(mesh_elem starting_face, double max_distance, mesh_elem face, std::unordered_set<mesh_elem> &visited)
@@ -2320,6 +2394,12 @@ void triangulation::timeseries_to_file(mesh_elem m, std::string fname)
     m->to_file(fname);
 }
 
+// vtu output is float, with NaN instead of -9999 for missing values
+static inline float vtu_value(double d)
+{
+    return d == -9999. ? std::numeric_limits<float>::quiet_NaN() : static_cast<float>(d);
+}
+
 void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_variables)
 {
     vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
@@ -2412,61 +2492,99 @@ void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_va
     //by this point this should be a fair assumption
 
     auto variables = output_variables.size() == 0 ? this->face(0)->variables() : output_variables;
+
+    // columns are (re)allocated here, so drop any from a previous init, e.g., after the terrain deformed
+    data.clear();
+    vectors.clear();
+    _vtu_columns.clear();
+    _vtu_vector_columns.clear();
+
     for(auto& v: variables)
     {
-        data[v] = vtkSmartPointer<vtkFloatArray>::New();
-        data[v]->SetName(v.c_str());
+        data[v] = make_vtu_column(_vtu_columns, v);
     }
 
+    const size_t nowned = this->size_faces();
+    const size_t nghost = _write_ghost_neighbors_to_vtu ? _ghost_faces.size() : 0;
+    auto cell = [&](size_t i) -> mesh_elem { return i < nowned ? this->face(i) : _ghost_faces[i - nowned]; };
+
+    // global id and the geometry only change if the terrain deforms, which re-runs this, so fill them once here
     _vtu_global_id = vtkSmartPointer<vtkUnsignedLongArray>::New();
     _vtu_global_id->SetName("global_id");
+    _vtu_global_id->SetNumberOfTuples(nowned + nghost);
+    auto* global_id = _vtu_global_id->WritePointer(0, nowned + nghost);
+
+#pragma omp parallel for
+    for (size_t i = 0; i < nowned + nghost; ++i)
+        global_id[i] = cell(i)->cell_global_id;
 
     if(_write_parameters_to_vtu)
     {
         auto params = this->face(0)->parameters();
         for (auto &v: params)
         {
-            data["[param] " + v] = vtkSmartPointer<vtkFloatArray>::New();
-            data["[param] " + v]->SetName(("[param] " + v).c_str());
+            data["[param] " + v] = make_vtu_column(_vtu_columns, "[param] " + v);
         }
 
         auto ics = this->face(0)->initial_conditions();
         for(auto& v: ics)
         {
-            data["[ic] " + v] = vtkSmartPointer<vtkFloatArray>::New();
-            data["[ic] " + v]->SetName(("[ic] " + v).c_str());
+            data["[ic] " + v] = make_vtu_column(_vtu_columns, "[ic] " + v);
+
+            auto& column = _vtu_columns["[ic] " + v];
+#pragma omp parallel for
+            for (size_t i = 0; i < nowned + nghost; ++i)
+                column[i] = vtu_value(cell(i)->get_initial_condition(v));
         }
 
         //handle elevation/aspect/slope
-        data["Elevation"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["Elevation"]->SetName("Elevation");
-
-        data["Slope"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["Slope"]->SetName("Slope");
-
-        data["Aspect"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["Aspect"]->SetName("Aspect");
-
-        data["Area"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["Area"]->SetName("Area");
+        for (auto& v : {"Elevation", "Slope", "Aspect", "Area", "is_ghost", "ghost_type"})
+        {
+            data[v] = make_vtu_column(_vtu_columns, v);
+        }
 
-        data["is_ghost"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["is_ghost"]->SetName("is_ghost");
+        float* elevation = _vtu_columns["Elevation"].data();
+        float* slope = _vtu_columns["Slope"].data();
+        float* aspect = _vtu_columns["Aspect"].data();
+        float* area = _vtu_columns["Area"].data();
+        float* is_ghost = _vtu_columns["is_ghost"].data();
+        float* ghost_type = _vtu_columns["ghost_type"].data();
 
-        data["ghost_type"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["ghost_type"]->SetName("ghost_type");
+#pragma omp parallel for
+        for (size_t i = 0; i < nowned + nghost; ++i)
+        {
+            auto fit = cell(i);
+            elevation[i] = fit->get_z();
+            slope[i] = fit->slope();
+            aspect[i] = fit->aspect();
+            area[i] = fit->get_area();
+            is_ghost[i] = fit->is_ghost;
+            ghost_type[i] = fit->ghost_type;
+        }
 
 #ifdef USE_MPI
-        data["owner"] = vtkSmartPointer<vtkFloatArray>::New();
-        data["owner"]->SetName("owner");
+        data["owner"] = make_vtu_column(_vtu_columns, "owner");
+        auto& owner = _vtu_columns["owner"];
+        for (size_t i = 0; i < nowned + nghost; ++i)
+            owner[i] = i < nowned ? _comm_world.rank() : cell(i)->owner;
 #endif
     }
     auto vec = this->face(0)->vectors();
     for(auto& v: vec)
     {
-        vectors[v] = vtkSmartPointer<vtkFloatArray>::New();
-        vectors[v]->SetName(v.c_str());
-        vectors[v]->SetNumberOfComponents(3);
+        vectors[v] = make_vtu_column(_vtu_vector_columns, v, 3);
+    }
+
+    _vtk_unstructuredGrid->GetCellData()->AddArray(_vtu_global_id);
+
+    for(auto& m : vectors)
+    {
+        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
+    }
+
+    for(auto& m : data)
+    {
+        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
     }
 
     // Global vertex ids -> only need to be set here, get written in the writer
@@ -2478,15 +2596,54 @@ void triangulation::init_vtkUnstructured_Grid(std::vector<std::string> output_va
 //    }
 }
 
-void triangulation::init_timeseries(std::set< std::string > variables)
+void triangulation::_init_face_variables(const std::vector<mesh_elem>& faces, std::set<std::string>& variables)
 {
+    _face_variables.init(variables, faces.size());
+
     #pragma omp parallel for
+    for (size_t it = 0; it < faces.size(); it++)
+    {
+        faces[it]->storage_id = it;
+    }
+}
+
+void triangulation::init_timeseries(std::set< std::string > variables)
+{
+    // owned faces first so that storage_id == face(i) index, then the ghosts
+    std::vector<mesh_elem> faces;
+    faces.reserve(size_faces() + _ghost_faces.size());
     for (size_t it = 0; it < size_faces(); it++)
     {
-        auto face = this->face(it);
-        face->init_time_series(variables);
+        faces.push_back(this->face(it));
     }
+    faces.insert(faces.end(), _ghost_faces.begin(), _ghost_faces.end());
+
+    _init_face_variables(faces, variables);
+}
+
+columnstorage<double>& triangulation::face_variables()
+{
+    return _face_variables;
+}
+
+var_handle triangulation::var(const std::string& variable)
+{
+    return _face_variables.handle(variable);
+}
+
+var_handle triangulation::var(const uint64_t& hash)
+{
+    return _face_variables.handle(hash);
+}
 
+columnstorage<double>::column_view triangulation::variable_column(const std::string& variable)
+{
+    return _face_variables.column(_face_variables.index(variable));
+}
+
+columnstorage<double>::column_view triangulation::variable_column(const uint64_t& hash)
+{
+    return _face_variables.column(_face_variables.index(hash));
 }
 
 void triangulation::init_vectors(std::set<std::string>& variables)
@@ -2526,29 +2683,38 @@ void triangulation::prune_faces(std::vector<Face_handle>& faces)
 
     _num_faces = _num_global_faces = _faces.size(); //number of global faces
 
+    // renumber so face(i), the face variable rows, module data slabs and checkpoints all agree on the subset
+    _global_IDs.resize(_faces.size());
+    for (size_t i = 0; i < _faces.size(); ++i)
+    {
+        _faces[i]->cell_local_id = i;
+        _global_IDs[i] = _faces[i]->cell_global_id;
+    }
+    global_cell_start_idx = 0;
+    global_cell_end_idx = _faces.size() - 1;
 }
 void triangulation::init_face_data(std::set< std::string >& timeseries,
                     std::set< std::string >& vectors,
                     std::set< std::string >& module_data)
 {
+    // Variables for owned and ghost faces live in the mesh-wide columns
+    // Ghosts are included so they can be treated just like normal neighbors (after vars communicated)
+    init_timeseries(timeseries);
+
     #pragma omp parallel for
         for (size_t it = 0; it < size_faces(); it++)
         {
             auto face = this->face(it);
-            face->init_time_series(timeseries);
             face->init_module_data(module_data);
             face->init_vectors(vectors);
         }
 	// Init data in ghost neighbors as well
-	// - so they can be treated just like normal neighbors (after vars communicated)
-	// - timeseries not needed here
 	LOG_DEBUG << "######### Current _ghost_neighbors.size(): " << _ghost_neighbors.size();
     #pragma omp parallel for
         for (size_t it = 0; it < _ghost_faces.size(); it++)
         {
             auto face = _ghost_faces.at(it);
             face->init_module_data(module_data);
-            face->init_time_series(timeseries);
             face->init_vectors(vectors);
         }
 }
@@ -2562,177 +2728,218 @@ void triangulation::update_vtk_data(std::vector<std::string> output_variables)
     }
 
     auto variables = output_variables.size() == 0 ? this->face(0)->variables() : output_variables;
-    auto params = this->face(0)->parameters();
-    auto ics = this->face(0)->initial_conditions();
-    auto vecs = this->face(0)->vectors();
-
-    for (size_t i = 0; i < this->size_faces(); i++)
-    {
-        mesh_elem fit = this->face(i);
-
-        for (auto &v: variables)
-        {
-            double d = (*fit)[v];
-            if(d == -9999.)
-            {
-                d = nan("");
-            }
-
-            data[v]->InsertTuple1(i,d);
-        }
-
-        //this is mandatory now
-        _vtu_global_id->InsertTuple1(i, fit->cell_global_id);
 
-        if(_write_parameters_to_vtu)
-        {
-            for (auto &v: params)
-            {
-                double d = fit->parameter(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[param] " + v]->InsertTuple1(i, d);
-            }
+    const size_t nowned = this->size_faces();
+    const size_t nghost = _write_ghost_neighbors_to_vtu ? _ghost_faces.size() : 0;
 
-            for (auto &v: ics)
-            {
-                double d = fit->get_initial_condition(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[ic] " + v]->InsertTuple1(i, d);
-            }
+    // One pass per output column. The face variables are already columns in face order (owned faces first, then
+    // ghosts by storage_id) so this is a strided-free copy that parallelizes cleanly
+    for (auto &v: variables)
+    {
+        auto values = variable_column(v);
+        float* column = _vtu_columns.at(v).data();
 
-            data["Elevation"]->InsertTuple1(i,fit->get_z());
-            data["Slope"]->InsertTuple1(i,fit->slope());
-            data["Aspect"]->InsertTuple1(i,fit->aspect());
-            data["Area"]->InsertTuple1(i,fit->get_area());
-	    data["is_ghost"]->InsertTuple1(i,fit->is_ghost);
-            data["ghost_type"]->InsertTuple1(i,fit->ghost_type);
+#pragma omp parallel for
+        for (size_t i = 0; i < nowned; ++i)
+            column[i] = vtu_value(values[i]);
 
-#ifdef USE_MPI
-	    data["owner"]->InsertTuple1(i,_comm_world.rank());
-#endif
-        }
-        for(auto& v: vecs)
+        // only the ghosts that are direct neighbours are kept up to date
+#pragma omp parallel for
+        for (size_t i = 0; i < nghost; ++i)
         {
-            Vector_3 d = fit->face_vector(v);
-
-            vectors[v]->InsertTuple3(i,d.x(),d.y(),d.z());
+            auto fit = _ghost_faces[i];
+            column[nowned + i] = fit->ghost_type == GHOST_TYPE::NEIGH ? vtu_value(values[fit->storage_id])
+                                                                     : std::numeric_limits<float>::quiet_NaN();
         }
 
-
+        data[v]->Modified();
     }
 
-    if(_write_ghost_neighbors_to_vtu)
-    {
-
-    /* Ghost neighbors */
-    for (size_t i = 0; i < _ghost_faces.size(); i++)
+    // parameters may be changed by modules, e.g., crop_rotation, so these are refreshed each time
+    if(_write_parameters_to_vtu)
     {
-        mesh_elem fit = _ghost_faces[i];
-
-	size_t insert_offset = i + this->size_faces();
-
-
-        for (auto &v: variables)
+        auto params = this->face(0)->parameters();
+        for (auto &v: params)
         {
-            double d = -9999;
-            if(fit->ghost_type == GHOST_TYPE::NEIGH)
-                d = (*fit)[v];
+            float* column = _vtu_columns.at("[param] " + v).data();
 
-            if(d == -9999.)
+#pragma omp parallel for
+            for (size_t i = 0; i < nowned + nghost; ++i)
             {
-                d = nan("");
+                auto fit = i < nowned ? this->face(i) : _ghost_faces[i - nowned];
+                column[i] = vtu_value(fit->parameter(v));
             }
 
-            data[v]->InsertTuple1(insert_offset,d);
+            data["[param] " + v]->Modified();
         }
+    }
 
-        _vtu_global_id->InsertTuple1(insert_offset,fit->cell_global_id);
+    for (auto& m : vectors)
+    {
+        float* column = _vtu_vector_columns.at(m.first).data();
 
-        if(_write_parameters_to_vtu)
+#pragma omp parallel for
+        for (size_t i = 0; i < nowned + nghost; ++i)
         {
-            for (auto &v: params)
-            {
-                double d = fit->parameter(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[param] " + v]->InsertTuple1(insert_offset, d);
-            }
+            auto fit = i < nowned ? this->face(i) : _ghost_faces[i - nowned];
+            Vector_3 d = fit->face_vector(m.first);
+            column[3 * i] = d.x();
+            column[3 * i + 1] = d.y();
+            column[3 * i + 2] = d.z();
+        }
 
-            for (auto &v: ics)
-            {
-                double d = fit->get_initial_condition(v);
-                if (d == -9999.)
-                {
-                    d = nan("");
-                }
-                data["[ic] " + v]->InsertTuple1(insert_offset, d);
-            }
+        m.second->Modified();
+    }
 
-            data["Elevation"]->InsertTuple1(insert_offset,fit->get_z());
-            data["Slope"]->InsertTuple1(insert_offset,fit->slope());
-            data["Aspect"]->InsertTuple1(insert_offset,fit->aspect());
-            data["Area"]->InsertTuple1(insert_offset,fit->get_area());
-	    data["is_ghost"]->InsertTuple1(insert_offset,fit->is_ghost);
-            data["ghost_type"]->InsertTuple1(insert_offset,fit->ghost_type);
+    for(auto& m : vertex_data)
+    {
+        _vtk_unstructuredGrid->GetPointData()->AddArray(m.second);
+    }
 
-	    data["owner"]->InsertTuple1(insert_offset,fit->owner);
-        }
-        for(auto& v: vecs)
-        {
-            Vector_3 d = fit->face_vector(v);
+}
 
-            vectors[v]->InsertTuple3(insert_offset,d.x(),d.y(),d.z());
-        }
+vtkSmartPointer<vtkFloatArray> triangulation::make_vtu_column(std::map<std::string, std::vector<float>>& columns,
+                                                              const std::string& name, int components)
+{
+    size_t ncells = this->size_faces() + (_write_ghost_neighbors_to_vtu ? _ghost_faces.size() : 0);
 
+    auto& column = columns[name];
+    column.assign(ncells * components, std::numeric_limits<float>::quiet_NaN());
 
-    }
+    auto array = vtkSmartPointer<vtkFloatArray>::New();
+    array->SetName(name.c_str());
+    array->SetNumberOfComponents(components);
 
-    } // if write ghosts
+    // save=1: VTK must not free the memory, it belongs to columns
+    array->SetArray(column.data(), column.size(), 1);
 
-    _vtk_unstructuredGrid->GetCellData()->AddArray(_vtu_global_id);
+    return array;
+}
 
-    for(auto& m : vectors)
+void triangulation::vtu_format(const std::string& data_mode, const std::string& compressor, int compression_level)
+{
+    if (data_mode != "appended" && data_mode != "binary" && data_mode != "ascii")
     {
-        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
+        CHM_THROW_EXCEPTION(config_error, "Unknown vtu data mode " + data_mode + ". Must be one of appended, binary, ascii.");
+    }
 
+    if (compressor != "none" && compressor != "zlib" && compressor != "lz4" && compressor != "lzma")
+    {
+        CHM_THROW_EXCEPTION(config_error, "Unknown vtu compressor " + compressor + ". Must be one of none, zlib, lz4, lzma.");
     }
 
+#if VTK_MAJOR_VERSION < 8 || (VTK_MAJOR_VERSION == 8 && VTK_MINOR_VERSION < 2)
+    if (compressor == "lz4" || compressor == "lzma")
+    {
+        CHM_THROW_EXCEPTION(config_error, "The " + compressor + " vtu compressor requires VTK >= 8.2.");
+    }
+#endif
 
-    for(auto& m : data)
+    if (compression_level < 1 || compression_level > 9)
     {
-        _vtk_unstructuredGrid->GetCellData()->AddArray(m.second);
+        CHM_THROW_EXCEPTION(config_error, "vtu compression level must be between 1 and 9.");
     }
 
-    for(auto& m : vertex_data)
+    if (data_mode == "ascii" && compressor != "none")
     {
-        _vtk_unstructuredGrid->GetPointData()->AddArray(m.second);
+        LOG_WARNING << "vtu compression is not used in ascii mode";
     }
 
+    _vtu_data_mode = data_mode;
+    _vtu_compressor = compressor;
+    _vtu_compression_level = compression_level;
 }
+
 void triangulation::write_vtu(std::string file_name)
 {
     //this now needs to be called from outside these functions
 //    update_vtk_data();
 
+    write_vtu(_vtk_unstructuredGrid, file_name);
+
+//    write_vtp(file_name);
+}
+
+void triangulation::snapshot_vtu(vtu_snapshot& snapshot)
+{
+    // a snapshot from before the vtu was re-initialized may hold columns that no longer exist
+    if (snapshot.columns.size() != _vtu_columns.size() || snapshot.vector_columns.size() != _vtu_vector_columns.size())
+    {
+        snapshot.columns.clear();
+        snapshot.vector_columns.clear();
+    }
+
+    // the copy has its own cell data, holding the same arrays until they are replaced below
+    snapshot.grid = vtkSmartPointer<vtkUnstructuredGrid>::New();
+    snapshot.grid->ShallowCopy(_vtk_unstructuredGrid);
+
+    auto copy = [&](std::map<std::string, std::vector<float>>& from, std::map<std::string, std::vector<float>>& to,
+                    int components)
+    {
+        for (auto& itr : from)
+        {
+            auto& column = to[itr.first];
+            column.resize(itr.second.size());
+            std::copy(itr.second.begin(), itr.second.end(), column.begin());
+
+            auto array = vtkSmartPointer<vtkFloatArray>::New();
+            array->SetName(itr.first.c_str());
+            array->SetNumberOfComponents(components);
+            array->SetArray(column.data(), column.size(), 1);
+            snapshot.grid->GetCellData()->AddArray(array);
+        }
+    };
+
+    copy(_vtu_columns, snapshot.columns, 1);
+    copy(_vtu_vector_columns, snapshot.vector_columns, 3);
+}
+
+void triangulation::write_vtu(vtu_snapshot& snapshot, const std::string& fname)
+{
+    write_vtu(snapshot.grid, fname);
+}
+
+void triangulation::write_vtu(vtkSmartPointer<vtkUnstructuredGrid> grid, const std::string& file_name)
+{
     vtkSmartPointer<vtkXMLUnstructuredGridWriter> writer = vtkSmartPointer<vtkXMLUnstructuredGridWriter>::New();
     writer->SetFileName(file_name.c_str());
-//    writer->SetCompressorType( vtkXMLUnstructuredGridWriter::CompressorType::ZLIB);
+
+    if (_vtu_data_mode == "ascii")
+    {
+        writer->SetDataModeToAscii();
+    }
+    else if (_vtu_data_mode == "binary")
+    {
+        writer->SetDataModeToBinary();
+    }
+    else
+    {
+        // raw, not base64 encoded, binary is the fastest to write and the smallest uncompressed
+        writer->SetDataModeToAppended();
+        writer->EncodeAppendedDataOff();
+    }
+
+    if (_vtu_compressor == "zlib")
+        writer->SetCompressorTypeToZLib();
+#if VTK_MAJOR_VERSION > 8 || (VTK_MAJOR_VERSION == 8 && VTK_MINOR_VERSION >= 2)
+    else if (_vtu_compressor == "lz4")
+        writer->SetCompressorTypeToLZ4();
+    else if (_vtu_compressor == "lzma")
+        writer->SetCompressorTypeToLZMA();
+#endif
+    else
+        writer->SetCompressorTypeToNone();
+
+#if VTK_MAJOR_VERSION >= 9
+    writer->SetCompressionLevel(_vtu_compression_level);
+#endif
+
 #if VTK_MAJOR_VERSION <= 5
-    writer->SetInput(_vtk_unstructuredGrid);
+    writer->SetInput(grid);
 #else
-    writer->SetInputData(_vtk_unstructuredGrid);
+    writer->SetInputData(grid);
 #endif
     writer->Write();
-
-//    write_vtp(file_name);
 }
 
 double triangulation::max_z()
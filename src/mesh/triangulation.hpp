@@ -21,6 +21,8 @@
 
 #include "station.hpp"
 #include "global.hpp"
+#include "math/space_filling_curve.hpp"
+#include "math/point_location.hpp"
 
 //for valgrind, remove
 #define CGAL_DISABLE_ROUNDING_MATH_CHECK
@@ -67,6 +69,8 @@ inline int omp_get_max_threads() { return 1;}
 #include <stack>
 #include <fstream>
 #include <utility>
+#include <map>
+#include <memory>
 
 
 #include <armadillo>
@@ -135,6 +139,7 @@ namespace pt = boost::property_tree;
 #include "utility/xxh64.hpp"
 
 #include "timeseries/variablestorage.hpp"
+#include "timeseries/columnstorage.hpp"
 
 // #include "hdf5.h"
 #include "H5Cpp.h"
@@ -243,6 +248,15 @@ public:
      */
     const Face_handle find_closest_face(double azimuth, double distance);
 
+    /**
+     * Exactly the same as find_face in triangulation but uses the current face's center
+     * @param azimuth
+     * @param distance
+     * @param hint A face near the query point, e.g., the result of the previous step along a ray
+     * @return
+     */
+    const Face_handle find_face(double azimuth, double distance, const Face_handle& hint = nullptr);
+
     /**
      * Returns the ith edge's length. Refering to the docs here
      * http://doc.cgal.org/latest/Triangulation_2/classCGAL_1_1Triangulation__2.html
@@ -328,6 +342,14 @@ public:
 
     double& operator[](const uint64_t& variable);
     double& operator[](const std::string& variable);
+
+    /**
+     * Get and set a variable via a handle resolved once, e.g., in a module's init().
+     * This is a direct indexed load and should be preferred in per-face loops.
+     * @param h
+     * @return
+     */
+    double& get(const var_handle& h);
     /**
      * Returns the face vector for a specified variable
      * @param variable
@@ -335,12 +357,6 @@ public:
      */
     Vector_3 face_vector(const std::string& variable);
 
-    /**
-    * Initializes  this faces variable storage
-    * \param variables Names of the variables to add
-    */
-    void init_time_series(std::set<std::string>& variables);
-
     /**
     * Initializes  this faces vector storage
     * \param variables Names of the vectors to add
@@ -450,6 +466,15 @@ public:
     size_t cell_global_id;
     size_t cell_local_id;
 
+    /**
+     * Row of this face in the mesh-wide variable columns. For owned faces this is the position in the
+     * triangulation's face(i) order (== cell_local_id), ghosts follow after all owned faces.
+     */
+    size_t storage_id;
+
+    // position of this face in the triangulation's point location index, -1 if not indexed
+    int point_location_id = -1;
+
 
     /**
      * Gets the face parameter value. E.g., landcover type
@@ -517,7 +542,6 @@ private:
     boost::shared_ptr<Vector_3> _normal;
 
 
-    variablestorage<double> _variables;
     variablestorage<double> _parameters;
 
     variablestorage< std::unique_ptr<face_info>> _module_face_data;
@@ -561,6 +585,66 @@ typedef CGAL::Orthogonal_k_neighbor_search <
 // used for faces in radius
 typedef CGAL::Fuzzy_sphere<Traits> Fuzzy_circle;
 
+/**
+ * A reusable halo exchange of a fixed set of face variables with the nearest-neighbour comm partners.
+ * Every variable for a partner is packed into one message, and the send/recv buffers and persistent MPI requests are
+ * set up once when the plan is created, so repeated exchanges do no allocation.
+ *
+ * start() packs and posts the messages and wait() completes them and unpacks, so a module can do work that does not
+ * need the halo in between. Obtain via triangulation::make_ghost_exchange. Without MPI this is a no-op.
+ *
+ * Plans have to be created in the same order with the same variables on every rank, and after the face variables
+ * have been initialized.
+ */
+class ghost_exchange
+{
+  public:
+    enum class direction
+    {
+        to_ghosts,  // owned face -> ghost copy on the neighbouring rank
+        from_ghosts // ghost face -> owned face on the owning rank
+    };
+
+    ghost_exchange(triangulation& domain, const std::vector<uint64_t>& variables, direction dir, int tag);
+    ~ghost_exchange();
+
+    ghost_exchange(const ghost_exchange&) = delete;
+    ghost_exchange& operator=(const ghost_exchange&) = delete;
+
+    /**
+     * Pack the variables and post the sends and receives. The face variables being sent must not be modified, and
+     * those being received must not be read, until wait() returns.
+     */
+    void start();
+
+    /**
+     * Complete the exchange and unpack the received values into the faces
+     */
+    void wait();
+
+    /**
+     * start() followed by wait()
+     */
+    void exchange();
+
+  private:
+    triangulation& _domain;
+    std::vector<size_t> _columns; // columnstorage column of each variable
+    bool _in_flight;
+
+#ifdef USE_MPI
+    struct partner
+    {
+        int rank;
+        std::vector<size_t> cells; // storage_ids to pack or unpack
+        std::vector<double> buffer; // variable-major, buffer[v * cells.size() + i]
+    };
+    std::vector<partner> _send;
+    std::vector<partner> _recv;
+    std::vector<MPI_Request> _requests; // sends then recvs
+#endif
+};
+
 
 /**
 *
@@ -629,6 +713,14 @@ public:
     */
   void reorder_faces(std::vector<size_t> permutation);
 
+    /**
+    * Orders faces (by centroid) and vertices along a space-filling curve so that spatial neighbours are close in
+    * memory. Faces are renumbered through reorder_faces, and vertex ids are reassigned to match the new vertex order.
+    * Only valid before the mesh is partitioned.
+    * \param c Curve to order along. curve::none is a no-op
+    */
+  void reorder_spatially(math::space_filling_curve::curve c);
+
     /**
     * Sets the MPI process ownership of mesh faces and nodes
     */
@@ -692,6 +784,28 @@ public:
    */
   void ghost_to_neighbors_communicate_variable(const uint64_t& var);
 
+  /**
+   * Creates a persistent exchange plan for a set of variables. See ghost_exchange.
+   * @param variables Variable names
+   * @param dir
+   */
+  std::shared_ptr<ghost_exchange> make_ghost_exchange(const std::vector<std::string>& variables,
+                                                      ghost_exchange::direction dir = ghost_exchange::direction::to_ghosts);
+
+  /**
+   * Creates a persistent exchange plan for a set of variables. Use _s for compile-time hash.
+   * @param variables
+   * @param dir
+   */
+  std::shared_ptr<ghost_exchange> make_ghost_exchange(const std::vector<uint64_t>& variables,
+                                                      ghost_exchange::direction dir = ghost_exchange::direction::to_ghosts);
+
+  /**
+   * Releases the single variable plans cached by ghost_neighbors_communicate_variable and
+   * ghost_to_neighbors_communicate_variable. Has to be called before MPI_Finalize.
+   */
+  void clear_ghost_exchanges();
+
     /**
     * Figures out which faces are required in the ghost region of an MPI process.
     * \param max_distance the maximum distance needed for communication
@@ -753,6 +867,26 @@ public:
      */
 	mesh_elem find_closest_face(Point_2 query) const;
 
+    /**
+     * Locates the triangle that contains the query point, including its edges. If a hint is given, the search walks
+     * across the mesh from the hint, which is much faster when the hint is near the query point, e.g., when stepping
+     * along a ray. Ghost faces are included.
+     * @param query Query point
+     * @param hint Optional face to start the search from
+     * @return triangle if found, otherwise nullptr
+     */
+    mesh_elem find_containing_face(Point_2 query, mesh_elem hint = nullptr) const;
+
+    /**
+     * Locates the triangle that contains the query point. If the query point is outside of the domain, this is the
+     * triangle with the closest center, so like find_closest_face it will always return a triangle.
+     * @param query Query point
+     * @param hint Optional face to start the search from, see find_containing_face
+     * @return
+     */
+    mesh_elem find_face(Point_2 query, mesh_elem hint = nullptr) const;
+    mesh_elem find_face(double x, double y, mesh_elem hint = nullptr) const;
+
     /**
      * Locates the triangles (based on centers) within a given radius. Example:
      * @code
@@ -834,6 +968,32 @@ public:
     /// @param variables
     void init_timeseries(std::set< std::string > variables);
 
+    /// Mesh-wide storage of the face variables. One contiguous column per variable, indexed by face->storage_id.
+    /// Owned faces occupy rows [0, size_faces()) in face(i) order, ghost faces follow.
+    /// @return
+    columnstorage<double>& face_variables();
+
+    /// Resolves a variable to a handle for use with face->get(h)
+    /// @param variable
+    /// @return
+    var_handle var(const std::string& variable);
+
+    /// Resolves a variable to a handle for use with face->get(h). Use _s for compile-time hash.
+    /// @param hash
+    /// @return
+    var_handle var(const uint64_t& hash);
+
+    /// Returns a view over a variable's full column, e.g., for vectorized loops over all faces.
+    /// The first size_faces() entries correspond to face(i), any remaining entries are ghost faces.
+    /// @param variable
+    /// @return
+    columnstorage<double>::column_view variable_column(const std::string& variable);
+
+    /// Returns a view over a variable's full column. Use _s for compile-time hash.
+    /// @param hash
+    /// @return
+    columnstorage<double>::column_view variable_column(const uint64_t& hash);
+
     /// Initializes the face vectors
     /// @param variables
     void init_vectors(std::set<std::string>& variables);
@@ -855,7 +1015,10 @@ public:
     /**
      * Prunes the internal vector that holds faces to only hold a subset. Does not actually remove the faces from the
      * triangulation. Cannot be used with MPI ranks >1 and outside point mode.
-     * @param faces
+     * Afterwards face(i) only returns the subset, which is renumbered in the given order. The spatial searches still
+     * cover the whole mesh, so modules can look up the surrounding terrain geometry.
+     * Must be called before init_face_data.
+     * @param faces Must not contain duplicates
      */
     void prune_faces(std::vector<Face_handle>& faces);
 
@@ -873,6 +1036,32 @@ public:
     */
 	void write_vtu(std::string fname);
 
+    /**
+     * A copy of the vtu output at one timestep, so it can be written while the model moves on.
+     * The geometry is shared with the triangulation's vtu, the output columns are copied.
+     */
+    struct vtu_snapshot
+    {
+        vtkSmartPointer<vtkUnstructuredGrid> grid;
+        std::map<std::string, std::vector<float>> columns;
+        std::map<std::string, std::vector<float>> vector_columns;
+    };
+
+    /**
+     * Copies the current vtu output (see update_vtk_data) into snapshot. The snapshot's buffers are reused if it has
+     * held a previous output.
+     * @param snapshot
+     */
+    void snapshot_vtu(vtu_snapshot& snapshot);
+
+    /**
+     * Saves a snapshot to a vtu file. Only reads the snapshot and the vtu format options, so it may be called from
+     * another thread while the model continues.
+     * @param snapshot
+     * @param fname
+     */
+    void write_vtu(vtu_snapshot& snapshot, const std::string& fname);
+
 
 	/**
 	 * Returns true if this is a geogrphic mesh
@@ -890,6 +1079,10 @@ public:
 	//http://doc.cgal.org/latest/Spatial_searching/index.html
 	boost::shared_ptr<Tree> dD_tree;
 
+    // triangle point location, built alongside dD_tree over the same faces
+    math::point_location::grid_index _point_index;
+    std::vector<mesh_elem> _point_index_faces;
+
     /**
      * Set the the private variable for writing parameters in vtu output
      */
@@ -898,6 +1091,13 @@ public:
      * Set the the private variable for writing the ghost neighbor data in vtu output
      */
     void write_ghost_neighbors_to_vtu(bool write_ghost_neighbors);
+    /**
+     * Set how the vtu output is encoded.
+     * @param data_mode appended (raw binary appended to the file), binary (base64 inline) or ascii
+     * @param compressor none, zlib, lz4 or lzma. Not used in ascii mode
+     * @param compression_level 1 (fastest) to 9 (smallest). Only honoured by VTK >= 9
+     */
+    void vtu_format(const std::string& data_mode, const std::string& compressor, int compression_level);
 
     /**
      * Returns the set of parameters available on the triangulation
@@ -907,6 +1107,27 @@ public:
 
     bool _terrain_deformed;
 
+    /**
+     * Returns the object stored under key, creating it with make() if nothing holds one. The mesh only keeps a weak
+     * reference, so the object is freed once the last holder releases it. For data derived from the mesh that more than
+     * one module would otherwise build; the key must include every parameter that changes the result.
+     * Not thread safe, call from init.
+     * @param key
+     * @param make Callable returning std::shared_ptr<T>
+     */
+    template<typename T, typename F>
+    std::shared_ptr<T> shared_data(const std::string& key, F make)
+    {
+        auto& weak = _shared_data[key];
+        auto data = std::static_pointer_cast<T>(weak.lock());
+        if (!data)
+        {
+            data = make();
+            weak = data;
+        }
+        return data;
+    }
+
     /**
      * Minimium z elevation in mesh
      * @return
@@ -922,6 +1143,9 @@ public:
     //Point to the global object that contains paramter information.
     boost::shared_ptr<global> _global;
 
+    // Space-filling curve used to order a json mesh that has no face permutation of its own (cell_global_id)
+    math::space_filling_curve::curve _face_ordering;
+
     //this holds the parameters that we load
     //however, core might have found some parameters from modules
     // it will have to insert them into this list so that the static hashmaps can be properly init
@@ -1004,6 +1228,13 @@ protected:
 
     } _version;
 
+    /**
+     * Allocates the mesh-wide variable columns for the given faces and assigns each its storage_id in order.
+     * @param faces
+     * @param variables
+     */
+    void _init_face_variables(const std::vector<mesh_elem>& faces, std::set<std::string>& variables);
+
     /**
      * Loads a given mesh as h5 into the triangulation. Only loads the main topology.
      * @param mesh_filename
@@ -1018,8 +1249,8 @@ protected:
     void partition_mesh_nonMPI(size_t _num_global_faces);
 
     /**
-     * Build the spatial search dD tree. Assumes _num_global_faces has been set and this needs to be called after
-     * the partition has happened
+     * Build the spatial search dD tree and the point location index. Assumes _num_global_faces has been set and this
+     * needs to be called after the partition has happened
      */
     void _build_dDtree();
 
@@ -1032,6 +1263,9 @@ protected:
     int _UTM_zone;
 
     std::string _srs_wkt;
+    // face variables for all local + ghost faces, see face_variables()
+    columnstorage<double> _face_variables;
+
     //holds the vtk ugrid if we are outputing to vtk formats
     vtkSmartPointer<vtkUnstructuredGrid> _vtk_unstructuredGrid;
 
@@ -1053,6 +1287,23 @@ protected:
     //should we write ghost neighbor faces to the vtu file?
     bool _write_ghost_neighbors_to_vtu;
 
+    // vtu encoding, see vtu_format
+    std::string _vtu_data_mode;
+    std::string _vtu_compressor;
+    int _vtu_compression_level;
+
+    // Backing store of the vtkFloatArrays in data and vectors. The arrays are pointed at these with SetArray, so
+    // update_vtk_data can fill each output column in parallel without going through VTK
+    std::map<std::string, std::vector<float>> _vtu_columns;
+    std::map<std::string, std::vector<float>> _vtu_vector_columns;
+
+    // writes grid with the vtu format options
+    void write_vtu(vtkSmartPointer<vtkUnstructuredGrid> grid, const std::string& fname);
+
+    // allocates a column of the vtu output in columns and returns a vtkFloatArray over it
+    vtkSmartPointer<vtkFloatArray> make_vtu_column(std::map<std::string, std::vector<float>>& columns,
+                                                   const std::string& name, int components = 1);
+
     // min and max elevations
     double _min_z;
     double _max_z;
@@ -1123,6 +1374,21 @@ protected:
   std::map< int, std::vector<mesh_elem> >
       ghost_faces_to_recv; // key=process to send to, entry=locally owned pointer to face
 
+  friend class ghost_exchange;
+
+  // Private communicator for the ghost_exchange plans so their tags can't match any other message
+#ifdef USE_MPI
+  boost::mpi::communicator _comm_ghost;
+#endif
+  int _next_ghost_exchange_tag;
+
+  // single variable plans used by ghost_neighbors_communicate_variable and ghost_to_neighbors_communicate_variable
+  std::map<uint64_t, std::shared_ptr<ghost_exchange>> _ghost_exchange_to_ghosts;
+  std::map<uint64_t, std::shared_ptr<ghost_exchange>> _ghost_exchange_from_ghosts;
+
+  // see shared_data
+  std::map<std::string, std::weak_ptr<void>> _shared_data;
+
     std::vector<int> _global_IDs;
 
   std::vector< std::shared_ptr<station> > _stations;
@@ -1545,6 +1811,12 @@ const typename face<Gt, Fb>::Face_handle face<Gt, Fb>::find_closest_face(double
     return _domain->find_closest_face(math::gis::point_from_bearing(center(), azimuth, distance));
 };
 
+template < class Gt, class Fb>
+const typename face<Gt, Fb>::Face_handle face<Gt, Fb>::find_face(double azimuth, double distance, const Face_handle& hint)
+{
+    return _domain->find_face(math::gis::point_from_bearing(center(), azimuth, distance), hint);
+};
+
 template < class Gt, class Fb>
 Vector_3 face<Gt, Fb>::normal()
 {
@@ -1623,33 +1895,39 @@ template < class Gt, class Fb>
 std::vector<std::string> face<Gt, Fb>::variables()
 {
 
-    return _variables.variables();
+    return _domain->face_variables().variables();
 }
 
 
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has(const std::string& variable)
 {
-    return _variables.has(variable);
+    return _domain->face_variables().has(variable);
 
 };
 
 template < class Gt, class Fb>
 bool face<Gt, Fb>::has(const uint64_t& hash)
 {
-    return _variables.has(hash);
+    return _domain->face_variables().has(hash);
 }
 
 template < class Gt, class Fb>
 double& face<Gt, Fb>::operator[](const uint64_t& hash)
 {
-     return _variables[hash];
+     return _domain->face_variables().at(hash, storage_id);
 }
 
 template < class Gt, class Fb>
 double& face<Gt, Fb>::operator[](const std::string& variable)
 {
-    return _variables[variable];
+    return _domain->face_variables().at(variable, storage_id);
+}
+
+template < class Gt, class Fb>
+double& face<Gt, Fb>::get(const var_handle& h)
+{
+    return _domain->face_variables()(h, storage_id);
 }
 
 template < class Gt, class Fb >
@@ -1694,12 +1972,6 @@ Vector_3 face<Gt, Fb>::face_vector(const std::string& variable)
     return _module_face_vectors[variable];
 };
 
-template < class Gt, class Fb>
-void face<Gt, Fb>::init_time_series(std::set<std::string>& variables)
-{
-    _variables.init(variables);
-}
-
 template < class Gt, class Fb>
 void face<Gt, Fb>::init_vectors(std::set<std::string>& variables)
 {
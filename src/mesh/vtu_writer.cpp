@@ -0,0 +1,194 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "vtu_writer.hpp"
+
+#include <boost/filesystem.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+vtu_writer::vtu_writer(triangulation& domain, size_t queue_depth, const std::string& pvd_file)
+    : _domain(domain), _queue_depth(queue_depth), _pvd_file(pvd_file), _allocated(0), _stop(false)
+{
+    _pvd.add("VTKFile.<xmlattr>.type", "Collection");
+    _pvd.add("VTKFile.<xmlattr>.version", "0.1");
+
+    if (_queue_depth > 0)
+        _thread = std::thread(&vtu_writer::run, this);
+}
+
+vtu_writer::~vtu_writer()
+{
+    try
+    {
+        finish();
+    }
+    catch (...)
+    {
+        // already reported by the writer thread, and a destructor can't throw
+    }
+}
+
+void vtu_writer::submit(const std::string& file_name, std::vector<pvd_entry> pvd)
+{
+    rethrow();
+
+    if (_queue_depth == 0)
+    {
+        _domain.write_vtu(file_name);
+        write_pvd(pvd);
+        return;
+    }
+
+    std::shared_ptr<triangulation::vtu_snapshot> snapshot;
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+
+        // back-pressure: wait for a buffer once queue_depth snapshots are in flight
+        if (_pool.empty() && _allocated >= _queue_depth)
+        {
+            LOG_DEBUG << "Mesh output queue is full, waiting for the writer";
+            _released.wait(lock, [this] { return !_pool.empty() || _error; });
+        }
+
+        if (_error)
+        {
+            lock.unlock();
+            rethrow();
+        }
+
+        if (!_pool.empty())
+        {
+            snapshot = _pool.back();
+            _pool.pop_back();
+        }
+        else
+        {
+            snapshot = std::make_shared<triangulation::vtu_snapshot>();
+            ++_allocated;
+        }
+    }
+
+    // the copy is done outside of the lock so the writer can keep going
+    _domain.snapshot_vtu(*snapshot);
+
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back(job{snapshot, file_name, std::move(pvd)});
+    }
+    _queued.notify_one();
+}
+
+void vtu_writer::finish()
+{
+    if (_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _queued.notify_one();
+        _thread.join();
+    }
+
+    rethrow();
+}
+
+void vtu_writer::run()
+{
+    while (true)
+    {
+        job j;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _queued.wait(lock, [this] { return _stop || !_queue.empty(); });
+
+            // drain the queue before stopping so no output is lost
+            if (_queue.empty())
+                return;
+
+            j = std::move(_queue.front());
+            _queue.pop_front();
+        }
+
+        try
+        {
+            _domain.write_vtu(*j.snapshot, j.file_name);
+            write_pvd(j.pvd);
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Writing " << j.file_name << " failed";
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+            _queue.clear();
+            _released.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _pool.push_back(j.snapshot);
+        }
+        _released.notify_one();
+    }
+}
+
+void vtu_writer::write_pvd(const std::vector<pvd_entry>& pvd)
+{
+    if (_pvd_file.empty())
+        return;
+
+    for (auto& e : pvd)
+    {
+        auto& dataset = _pvd.add("VTKFile.Collection.DataSet", "");
+        dataset.add("<xmlattr>.timestep", e.timestep);
+        dataset.add("<xmlattr>.group", "");
+        dataset.add("<xmlattr>.part", e.part);
+        dataset.add("<xmlattr>.file", e.file);
+    }
+
+    // write then rename so Paraview never sees a partially written collection
+    std::string tmp = _pvd_file + ".tmp";
+#if (BOOST_VERSION / 100 % 1000) < 56
+    boost::property_tree::write_xml(tmp, _pvd, std::locale(),
+                                    boost::property_tree::xml_writer_make_settings<char>(' ', 4));
+#else
+    boost::property_tree::write_xml(tmp, _pvd, std::locale(),
+                                    boost::property_tree::xml_writer_settings<std::string>(' ', 4));
+#endif
+    boost::filesystem::rename(tmp, _pvd_file);
+}
+
+void vtu_writer::rethrow()
+{
+    // the error is kept, the writer thread has stopped so every later submit has to fail too
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        error = _error;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
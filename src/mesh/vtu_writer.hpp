@@ -0,0 +1,112 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include "triangulation.hpp"
+
+#include <boost/property_tree/ptree.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Writes the vtu mesh output on a dedicated thread.
+ *
+ * submit() snapshots the triangulation's current vtu output (see triangulation::update_vtk_data) into a pooled buffer
+ * and queues it, so the timestep only pays for a memory copy. At most queue_depth snapshots are in flight, which bounds
+ * the memory used; submit() blocks once they are all queued. With a queue depth of 0 the vtu is written directly by the
+ * calling thread.
+ *
+ * The .pvd collection is rewritten after each vtu has been written, so a partial run can always be opened in Paraview.
+ */
+class vtu_writer
+{
+  public:
+    /**
+     * One DataSet entry of the .pvd collection
+     */
+    struct pvd_entry
+    {
+        size_t timestep;
+        int part;
+        std::string file; // relative to the .pvd
+    };
+
+    /**
+     * @param domain
+     * @param queue_depth # of snapshots that may wait to be written. 0 writes synchronously
+     * @param pvd_file .pvd collection to maintain. Empty if this rank does not write it.
+     */
+    vtu_writer(triangulation& domain, size_t queue_depth, const std::string& pvd_file);
+    ~vtu_writer();
+
+    /**
+     * Queue the current vtu output to be written to file_name.
+     * Rethrows any exception from a previous write.
+     * @param file_name
+     * @param pvd Entries added to the .pvd collection once file_name is written
+     */
+    void submit(const std::string& file_name, std::vector<pvd_entry> pvd);
+
+    /**
+     * Waits for all queued writes and stops the writer thread. Rethrows any exception from a write.
+     */
+    void finish();
+
+  private:
+    struct job
+    {
+        std::shared_ptr<triangulation::vtu_snapshot> snapshot;
+        std::string file_name;
+        std::vector<pvd_entry> pvd;
+    };
+
+    void run();
+    void write_pvd(const std::vector<pvd_entry>& pvd);
+    void rethrow();
+
+    triangulation& _domain;
+    size_t _queue_depth;
+
+    std::string _pvd_file;
+    boost::property_tree::ptree _pvd;
+
+    std::mutex _mutex;
+    std::condition_variable _queued;   // a job was queued, or stop was requested
+    std::condition_variable _released; // a snapshot went back to the pool
+    std::deque<job> _queue;
+    std::vector<std::shared_ptr<triangulation::vtu_snapshot>> _pool;
+    size_t _allocated;                 // snapshots in the pool, the queue, or being written
+    bool _stop;
+    std::exception_ptr _error;
+
+    std::thread _thread;
+};
@@ -27,6 +27,7 @@ metdata::metdata(std::string mesh_proj4)
 {
     _nc = nullptr;
     _use_netcdf = false;
+    _nc_x0 = _nc_y0 = _nc_nx = _nc_ny = 0;
     _n_timesteps = 0;
     _mesh_proj4 = mesh_proj4;
     is_first_timestep = true;
@@ -38,7 +39,8 @@ metdata::metdata(std::string mesh_proj4)
 
 metdata::~metdata()
 {
-
+    // don't let the reader thread outlive the file
+    cancel_prefetch_nc();
 }
 
 void metdata::load_from_netcdf(const std::string& path, const triangulation::bounding_box* box, std::map<std::string, boost::shared_ptr<filter_base> > filters)
@@ -201,6 +203,11 @@ void metdata::load_from_netcdf(const std::string& path, const triangulation::bou
     _dt = _nc->get_dt();
 
     _current_ts = _start_time;
+
+    auto nc_vars = _nc->get_variable_names();
+    _nc_variables.assign(nc_vars.begin(), nc_vars.end());
+
+    compute_nc_window();
 }
 
 void metdata::load_from_ascii(std::vector<ascii_metdata> stations, int utc_offset)
@@ -553,25 +560,48 @@ bool metdata::next_nc()
         return false; // we've run out of data, we done
     }
 
+    std::map<std::string, netcdf::data> window;
 
-    //The call to netCDF isn't thread safe. It is protected by a critical section but it's costly, and not running this
-    // in parallel is about 2x faster  #pragma omp parallel for
-    for(size_t i = 0; i < nstations();i++)
+    try
     {
-        auto s = _stations.at(i);
+        // use the background read if it is for this timestep, otherwise (first timestep, subset, prune) read it now
+        if(_nc_prefetch.valid() && _nc_prefetch_ts == _current_ts)
+        {
+            window = _nc_prefetch.get();
+        }
+        else
+        {
+            cancel_prefetch_nc();
+            window = read_nc_window(_current_ts);
+        }
+    }
+    catch(netCDF::exceptions::NcException& e)
+    {
+        BOOST_THROW_EXCEPTION(forcing_error() << errstr_info(e.what()));
+    }
 
-        // we might have a NaN point, so so a nullptr station, just keep going
-        if(!s)
-            continue;
+    // overlap the read of the next timestep with the model run of this one
+    if(_current_ts + _dt <= _end_time)
+        prefetch_nc(_current_ts + _dt);
+
+    // same order as _nc_variables
+    std::vector<const double*> columns;
+    for (auto &v: _nc_variables )
+        columns.push_back(window[v].data());
+
+    // the data are all in memory now, so filling the stations no longer serializes on the netCDF library
+#pragma omp parallel for
+    for(size_t i = 0; i < _nc_active.size(); i++)
+    {
+        auto s = _nc_active[i].first;
+        size_t offset = _nc_active[i].second;
 
         s->set_posix(_current_ts);
 
         // don't use the stations variable map as it'll contain anything inserted by a filter which won't exist in the nc file
-        for (auto &v: _nc->get_variable_names() )
+        for (size_t j = 0; j < _nc_variables.size(); j++)
         {
-            double d = _nc->get_var(v, _current_ts, s->_nc_x, s->_nc_y);
-            (*s)[v] = d;
-
+            (*s)[_nc_variables[j]] = columns[j][offset];
         }
 
         // run all the filters for this station
@@ -585,6 +615,97 @@ bool metdata::next_nc()
 
 }
 
+void metdata::compute_nc_window()
+{
+    // any prefetched window has the old shape
+    cancel_prefetch_nc();
+
+    size_t x_min = std::numeric_limits<size_t>::max();
+    size_t y_min = std::numeric_limits<size_t>::max();
+    size_t x_max = 0;
+    size_t y_max = 0;
+
+    for(auto& s : _stations)
+    {
+        // we might have a NaN point, so so a nullptr station
+        if(!s)
+            continue;
+
+        x_min = std::min(x_min, s->_nc_x);
+        y_min = std::min(y_min, s->_nc_y);
+        x_max = std::max(x_max, s->_nc_x);
+        y_max = std::max(y_max, s->_nc_y);
+    }
+
+    _nc_active.clear();
+
+    if(x_min == std::numeric_limits<size_t>::max())
+    {
+        // no stations, nothing will be read
+        _nc_x0 = _nc_y0 = _nc_nx = _nc_ny = 0;
+        return;
+    }
+
+    _nc_x0 = x_min;
+    _nc_y0 = y_min;
+    _nc_nx = x_max - x_min + 1;
+    _nc_ny = y_max - y_min + 1;
+
+    for(auto& s : _stations)
+    {
+        if(!s)
+            continue;
+
+        size_t offset = (s->_nc_y - _nc_y0) * _nc_nx + (s->_nc_x - _nc_x0);
+        _nc_active.push_back(std::make_pair(s, offset));
+    }
+
+    LOG_DEBUG << "Reading a " << _nc_ny << " (y) by " << _nc_nx << " (x) window of the forcing grid for "
+              << _nc_active.size() << " stations";
+}
+
+std::map<std::string, netcdf::data> metdata::read_nc_window(boost::posix_time::ptime t)
+{
+    std::map<std::string, netcdf::data> window;
+
+    if(_nc_active.empty())
+        return window;
+
+    for (auto &v: _nc_variables )
+    {
+        // emplace as multi_array's assignment requires the shapes to already match
+        window.emplace(v, _nc->get_var(v, t, _nc_x0, _nc_y0, _nc_nx, _nc_ny));
+    }
+
+    return window;
+}
+
+void metdata::prefetch_nc(boost::posix_time::ptime t)
+{
+    cancel_prefetch_nc();
+
+    _nc_prefetch_ts = t;
+    _nc_prefetch = std::async(std::launch::async, [this, t]()
+    {
+        return read_nc_window(t);
+    });
+}
+
+void metdata::cancel_prefetch_nc()
+{
+    if(!_nc_prefetch.valid())
+        return;
+
+    try
+    {
+        _nc_prefetch.get();
+    }
+    catch(...)
+    {
+        // the result is being discarded, so is any error. A real read of this timestep will report it.
+    }
+}
+
 std::vector< std::shared_ptr<station> > metdata::get_stations_in_radius(double x, double y, double radius )
 {
     // define exact circular range query  (fuzziness=0)
@@ -630,6 +751,9 @@ void metdata::prune_stations(std::unordered_set<std::string>& station_ids)
         std::end(_stations));
 
     _nstations = _stations.size();
+
+    if(_use_netcdf)
+        compute_nc_window();
 }
 
 std::vector< std::shared_ptr<station>>& metdata::stations()
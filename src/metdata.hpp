@@ -38,6 +38,9 @@
 #include <set>
 #include <unordered_set>
 #include <vector>
+#include <map>
+#include <future>
+#include <limits>
 
 //boost includes
 #include <boost/function.hpp>
@@ -211,6 +214,22 @@ class metdata
     /// Advances 1 timestep in the netcdf files
     bool next_nc();
 
+    /// Finds the smallest window of the nc grid that covers the stations in use, and each station's offset into it.
+    /// Needs to be recomputed whenever the station list changes.
+    void compute_nc_window();
+
+    /// Reads the window of every nc variable for timestep t. Safe to call from a background thread.
+    /// @param t
+    /// @return variable -> window
+    std::map<std::string, netcdf::data> read_nc_window(boost::posix_time::ptime t);
+
+    /// Starts reading timestep t on a background thread
+    /// @param t
+    void prefetch_nc(boost::posix_time::ptime t);
+
+    /// Blocks until any in-flight prefetch is done and discards it
+    void cancel_prefetch_nc();
+
 
     /// Advances 1 timestep from the ascii timeseries
     /// @return
@@ -231,6 +250,20 @@ class metdata
 
         std::set<std::string> _provides_from_nc_filters;
 
+        // variables read from the nc file, cached so the variable list isn't rebuilt each timestep
+        std::vector<std::string> _nc_variables;
+
+        // window of the nc grid that covers all the stations in use. Only this is ever read.
+        size_t _nc_x0, _nc_y0, _nc_nx, _nc_ny;
+
+        // stations in use and their row-major offset into the window
+        std::vector<std::pair<std::shared_ptr<station>, size_t>> _nc_active;
+
+        // read of the next timestep, overlapped with the model computing the current one.
+        // Declared after _nc so it is torn down first.
+        std::future<std::map<std::string, netcdf::data>> _nc_prefetch;
+        boost::posix_time::ptime _nc_prefetch_ts;
+
         // if false, we are using ascii files
         bool _use_netcdf;
 
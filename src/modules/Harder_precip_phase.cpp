@@ -61,12 +61,12 @@ Harder_precip_phase::~Harder_precip_phase()
 }
 void Harder_precip_phase::init(mesh& domain)
 {
+    _face_data = make_module_data_slab<data>(domain);
 
 #pragma omp parallel for
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
-        auto face = domain->face(i);
-        auto& d = face->make_module_data<data>(ID);
+        auto& d = _face_data[i];
         d.hours_since_snowfall = 0;
         d.acc_rain = 0;
         d.acc_snow = 0;
@@ -138,7 +138,7 @@ void Harder_precip_phase::run(mesh_elem& face)
     (*face)["p_rain"_s]= p * frTi;
     (*face)["p_snow"_s]= p * (1.0-frTi);
 
-    auto& d = face->get_module_data<data>(ID);
+    auto& d = _face_data[face];
     if( p * (1.0-frTi) > 0) // it's snowing
     {
         d.hours_since_snowfall = 0; // reset
@@ -162,33 +162,22 @@ void Harder_precip_phase::run(mesh_elem& face)
 
 void Harder_precip_phase::checkpoint(mesh& domain,  netcdf& chkpt)
 {
-
-    chkpt.create_variable1D("Harder_precip_phase:hours_since_snowfall", domain->size_faces());
-    chkpt.create_variable1D("Harder_precip_phase:acc_rain", domain->size_faces());
-    chkpt.create_variable1D("Harder_precip_phase:acc_snow", domain->size_faces());
-
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        chkpt.put_var1D("Harder_precip_phase:hours_since_snowfall",i,face->get_module_data<data>(ID).hours_since_snowfall);
-        chkpt.put_var1D("Harder_precip_phase:acc_rain",i,face->get_module_data<data>(ID).acc_rain);
-        chkpt.put_var1D("Harder_precip_phase:acc_snow",i,face->get_module_data<data>(ID).acc_snow);
-    }
-
+    _face_data.checkpoint(chkpt, "Harder_precip_phase:hours_since_snowfall", &data::hours_since_snowfall);
+    _face_data.checkpoint(chkpt, "Harder_precip_phase:acc_rain", &data::acc_rain);
+    _face_data.checkpoint(chkpt, "Harder_precip_phase:acc_snow", &data::acc_snow);
 }
+
 void Harder_precip_phase::load_checkpoint(mesh& domain, netcdf& chkpt)
 {
+    _face_data.load_checkpoint(chkpt, "Harder_precip_phase:hours_since_snowfall", &data::hours_since_snowfall);
+    _face_data.load_checkpoint(chkpt, "Harder_precip_phase:acc_rain", &data::acc_rain);
+    _face_data.load_checkpoint(chkpt, "Harder_precip_phase:acc_snow", &data::acc_snow);
 
+#pragma omp parallel for
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
         auto face = domain->face(i);
-        face->get_module_data<data>(ID).hours_since_snowfall = chkpt.get_var1D("Harder_precip_phase:hours_since_snowfall",i);
-        face->get_module_data<data>(ID).acc_rain = chkpt.get_var1D("Harder_precip_phase:acc_rain",i);
-        face->get_module_data<data>(ID).acc_snow = chkpt.get_var1D("Harder_precip_phase:acc_snow",i);
-
-        (*face)["acc_rain"_s]=face->get_module_data<data>(ID).acc_rain;
-        (*face)["acc_snow"_s]=face->get_module_data<data>(ID).acc_snow;
+        (*face)["acc_rain"_s]=_face_data[i].acc_rain;
+        (*face)["acc_snow"_s]=_face_data[i].acc_snow;
     }
-
-
 }
@@ -75,7 +75,7 @@ public:
     double b;
     double c;
 
-    class data : public face_info
+    class data
     {
     public:
         double hours_since_snowfall;
@@ -83,6 +83,7 @@ public:
         double acc_snow;
 
     };
+    module_data_slab<data> _face_data;
 
     void checkpoint(mesh& domain,  netcdf& chkpt);
     void load_checkpoint(mesh& domain, netcdf& chkpt);
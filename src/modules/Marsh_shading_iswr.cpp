@@ -36,11 +36,97 @@ Marsh_shading_iswr::Marsh_shading_iswr(config_file cfg)
 
     x_AABB = cfg.get<int>("x_AABB",10);
     y_AABB = cfg.get<int>("y_AABB",10);
+
+    auto method = cfg.get<std::string>("method","aabb");
+    if(method == "zbuffer")
+    {
+        _use_zbuffer = true;
+        _zbuffer.set_cell_size(cfg.get("zbuffer_cell_size",0.0));
+    }
+    else if(method == "aabb")
+    {
+        _use_zbuffer = false;
+    }
+    else
+    {
+        CHM_THROW_EXCEPTION(config_error, "Marsh_shading_iswr: unknown method " + method + ". Must be aabb or zbuffer.");
+    }
     LOG_DEBUG << "Successfully instantiated module " << this->ID;
 
 }
 
 void Marsh_shading_iswr::run(mesh& domain)
+{
+    if(_use_zbuffer)
+        run_zbuffer(domain);
+    else
+        run_aabb(domain);
+}
+
+void Marsh_shading_iswr::run_zbuffer(mesh& domain)
+{
+    size_t nfaces = domain->size_faces();
+
+    // the engine works on its own copy of the coordinates, so the triangulation is never rotated
+    std::vector<double> xyz(nfaces * 9);
+
+    // one sun position for the domain. Azimuth is averaged as a vector so it doesn't break at north
+    double sin_az = 0;
+    double cos_az = 0;
+    double sum_el = 0;
+    double max_el = -90;
+
+#pragma omp parallel for reduction(+:sin_az,cos_az,sum_el) reduction(max:max_el)
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        auto face = domain->face(i);
+        for (int v = 0; v < 3; v++)
+        {
+            auto p = face->vertex(v)->point();
+            xyz[9 * i + 3 * v] = p.x();
+            xyz[9 * i + 3 * v + 1] = p.y();
+            xyz[9 * i + 3 * v + 2] = p.z();
+        }
+
+        double A = (*face)["solar_az"_s] * M_PI / 180.0;
+        double E = (*face)["solar_el"_s];
+        sin_az += sin(A);
+        cos_az += cos(A);
+        sum_el += E;
+        max_el = std::max(max_el, E);
+    }
+
+    std::vector<int> shadow;
+    std::vector<double> z_prime;
+
+    // nothing is above the cutoff below, skip the raster
+    if (max_el >= 5)
+    {
+        double A = atan2(sin_az, cos_az) * 180.0 / M_PI;
+        if (A < 0)
+            A += 360.0;
+
+        _zbuffer.compute(xyz, A, sum_el / nfaces, shadow, z_prime);
+    }
+
+#pragma omp parallel for
+    for (size_t i = 0; i < nfaces; i++)
+    {
+        auto face = domain->face(i);
+        double E = (*face)["solar_el"_s];
+        if (E < 5)
+        {
+            (*face)["z_prime"_s] = 0; //unshadowed
+            (*face)["shadow"_s] = 0;
+            continue;
+        }
+
+        (*face)["shadow"_s] = shadow[i];
+        (*face)["z_prime"_s] = z_prime[i];
+    }
+}
+
+void Marsh_shading_iswr::run_aabb(mesh& domain)
 {
 
 
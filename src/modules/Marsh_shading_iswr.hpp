@@ -26,6 +26,7 @@
 #include "logger.hpp"
 #include "triangulation.hpp"
 #include "module_base.hpp"
+#include "math/zbuffer.hpp"
 
 #include <cstdlib>
 #include <string>
@@ -64,6 +65,10 @@ struct vertex_data : vertex_info
  * Computes the horizon-shadows using the parallel point plane projection from Marsh, et al (2011). The :ref:`fast_shadow` routine
  * provides almost as good of a result with less computational overhead.
  *
+ * Two engines are available. ``aabb`` is the original pairwise triangle comparison within a grid of bins. ``zbuffer``
+ * rasterizes all triangles into a depth grid in the sun's frame of reference and marks a triangle shadowed if something
+ * nearer the sun covers its centroid. It scales linearly with the number of triangles and does not modify the mesh.
+ *
  * **Depends:**
  * - Solar azimuth "solar_az" [degrees]
  * - Solar elevation "solar_el" [degrees]
@@ -78,8 +83,10 @@ struct vertex_data : vertex_info
  * .. code:: json
  *
  *    {
+ *       "method":"aabb",
  *       "x_AABB":10,
- *       "y_AABB":10
+ *       "y_AABB":10,
+ *       "zbuffer_cell_size":0
  *    }
  *
  *
@@ -88,6 +95,13 @@ struct vertex_data : vertex_info
  *    more chance of missing a triangle intersection. It also decreases the number of comparisons and can dramatically
  *    decrease the computational time.
  *
+ * .. confval:: method
+ *
+ *    :type: string
+ *    :default: aabb
+ *
+ *    Shadow engine, ``aabb`` or ``zbuffer``.
+ *
  * .. confval:: x_AABB
  *
  *    :type: int
@@ -103,6 +117,14 @@ struct vertex_data : vertex_info
  *
  *    This is the size number of bins in the y direction.
  *
+ * .. confval:: zbuffer_cell_size
+ *
+ *    :type: double
+ *    :default: 0
+ *
+ *    ``zbuffer`` only. Size of a depth cell, in mesh units, in the sun's frame of reference. Smaller cells resolve
+ *    smaller shadows at the cost of memory and time. 0 picks half the square root of the mean projected triangle area.
+ *
  * \endrst
  * Reference:
  * - Marsh, C.B., J.W. Pomeroy, and R.J. Spiteri. “Implications of Mountain Shading on Calculating Energy for Snowmelt
@@ -118,6 +140,13 @@ REGISTER_MODULE_HPP(Marsh_shading_iswr);
 
     int x_AABB;
     int y_AABB;
+
+    private:
+        void run_aabb(mesh& domain);
+        void run_zbuffer(mesh& domain);
+
+        bool _use_zbuffer;
+        math::shading::zbuffer _zbuffer;
 };
 
 /**
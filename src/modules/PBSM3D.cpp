@@ -25,6 +25,8 @@
 
 REGISTER_MODULE_CPP(PBSM3D);
 
+namespace la = math::LinearAlgebra;
+
 struct my_fill_topo_params
 {
     double a1;
@@ -189,6 +191,17 @@ PBSM3D::PBSM3D(config_file cfg) : module_base("PBSM3D", parallel::domain, cfg)
         provides("dm/dt");
         provides("mm");
     }
+
+    // provided here, not in init, so the columns exist when the face variables are allocated
+    export_solver_stats = cfg.get("solver.export_stats", false);
+    if (export_solver_stats)
+    {
+        provides("suspension_solver_iterations");
+        provides("suspension_solver_time");
+        provides("deposition_solver_iterations");
+        provides("deposition_solver_time");
+    }
+
     provides("Qsubl");
     provides("Qsubl_mass");
     provides("sum_subl");
@@ -219,6 +232,9 @@ PBSM3D::PBSM3D(config_file cfg) : module_base("PBSM3D", parallel::domain, cfg)
 void PBSM3D::init(mesh& domain)
 {
     nLayer = cfg.get("nLayer", 10);
+    // the bottom layer couples to the one above it
+    if (nLayer < 2)
+        CHM_THROW_EXCEPTION(config_error, "PBSM3D: nLayer must be >= 2");
 
     susp_depth = 5;                      // 5m as per pomeroy
     v_edge_height = susp_depth / nLayer; // height of each vertical prism
@@ -253,6 +269,20 @@ void PBSM3D::init(mesh& domain)
 
     iterative_subl = cfg.get("iterative_subl", false);
 
+    solver_options.matrix_free = cfg.get("solver.matrix_free", false);
+    solver_options.solver = cfg.get("solver.type", solver_options.solver);
+    solver_options.preconditioner = cfg.get("solver.preconditioner",
+                                            solver_options.matrix_free ? std::string("NONE") : solver_options.preconditioner);
+    solver_options.tolerance = cfg.get("solver.tolerance", solver_options.tolerance);
+    solver_options.max_iterations = cfg.get("solver.max_iterations", solver_options.max_iterations);
+    solver_options.num_blocks = cfg.get("solver.num_blocks", solver_options.num_blocks);
+    solver_options.recompute_every = cfg.get("solver.recompute_every", solver_options.recompute_every);
+    solver_options.recompute_threshold = cfg.get("solver.recompute_threshold", solver_options.recompute_threshold);
+    solver_options.warm_start = cfg.get("solver.warm_start", solver_options.warm_start);
+
+    if (solver_options.recompute_every < 1)
+        CHM_THROW_EXCEPTION(config_error, "PBSM3D: solver.recompute_every must be >= 1");
+
     if (rouault_diffusion_coeff)
     {
         LOG_WARNING << "rouault_diffusion_coef overrides const "
@@ -389,8 +419,10 @@ void PBSM3D::init(mesh& domain)
 
     }
 
-    suspension_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain,nLayer));
-    deposition_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain));
+    suspension_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain,nLayer,solver_options));
+    deposition_NNP.reset(new math::LinearAlgebra::NearestNeighborProblem(domain,1,solver_options));
+
+    Q_ghost_exchange = domain->make_ghost_exchange({"Qsusp"_s, "Qsalt"_s});
 
 }
 
@@ -399,13 +431,15 @@ void PBSM3D::run(mesh& domain)
 
     LOG_DEBUG << "PBSM: ";
 
-    // needed for linear system offsets
     size_t ntri = domain->size_faces();
-    size_t n_global_tri = domain->size_global_faces();
 
     suspension_NNP->zeroSystem();
     deposition_NNP->zeroSystem();
 
+    // stays 0 on steps without a solve
+    math::LinearAlgebra::SolveConverge suspension_results{0, 0, 0, 0, false};
+    math::LinearAlgebra::SolveConverge deposition_results{0, 0, 0, 0, false};
+
     // Set this flag if the RHS of the suspension system is ever nonzero
     // Thread-safe because it is only ever switched in one direction
     suspension_present = false;
@@ -1214,7 +1248,7 @@ void PBSM3D::run(mesh& domain)
                     udotm[j] = arma::dot(uvw, m[j]);
                 }
                 // lateral
-                int idx = n_global_tri * z + face->cell_global_id;
+                size_t row = suspension_NNP->localRow(face->cell_local_id, z);
 
                 double V = face->get_area() * v_edge_height;
                 // the sink term is added on for each edge check, which isn't right
@@ -1237,13 +1271,11 @@ void PBSM3D::run(mesh& domain)
 
                         if (d.face_neigh[f])
                         {
-                            int nidx = n_global_tri * z + face->neighbor(f)->cell_global_id;
-
                             // Diagonal value
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                            suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                     (V * csubl - d.A[f] * udotm[f] - alpha[f]));
                             // Off diagonal value
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, (alpha[f]));
+                            suspension_NNP->matrixSumIntoLocalRow(row, static_cast<la::StencilSlot>(f), (alpha[f]));
                         }
                         else // missing neighbor case
                         {
@@ -1251,7 +1283,7 @@ void PBSM3D::run(mesh& domain)
                             //                            elements[ idx_idx_off ] += V*csubl-d.A[f]*udotm[f]-alpha[f];
 
                             // allow mass into the domain from ghost cell
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                            suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                     (-0.1e-1 * alpha[f] - 1. * d.A[f] * udotm[f] + csubl * V));
                         }
                     }
@@ -1259,12 +1291,11 @@ void PBSM3D::run(mesh& domain)
                     {
                         if (d.face_neigh[f])
                         {
-                            int nidx = n_global_tri * z + face->neighbor(f)->cell_global_id;
                             // Diagonal entry
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                            suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                     V * csubl - alpha[f]);
                             // Off diagonal entry
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, nidx,
+                            suspension_NNP->matrixSumIntoLocalRow(row, static_cast<la::StencilSlot>(f),
                                     -d.A[f] * udotm[f] + alpha[f]);
                         }
                         else
@@ -1273,7 +1304,7 @@ void PBSM3D::run(mesh& domain)
                             //                            elements[ idx_idx_off ] +=  V*csubl-alpha[f];
 
                             // allow mass in
-                            suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                            suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                     -0.1e-1 * alpha[f] - .99 * d.A[f] * udotm[f] + csubl * V);
                         }
                     }
@@ -1289,31 +1320,28 @@ void PBSM3D::run(mesh& domain)
                     //              elements[idx_idx_off] += V * csubl - alpha4;
 
                     // includes advection term
-                    suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                    suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                             V * csubl - d.A[4] * udotm[4] - alpha4);
                     // RHS
                     double val = -alpha4 * c_salt;
-                    suspension_NNP->rhsSumIntoGlobalValue(idx,val);
-
-                    // ntri * (z + 1) + face->cell_local_id
-                    int nidx = n_global_tri*(z+1) + face->cell_global_id;
+                    suspension_NNP->rhsSumIntoLocalRow(row, val);
 
                     if (udotm[3] > 0)
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                 V * csubl - d.A[3] * udotm[3] - alpha[3]);
                         // Off diagonal
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, alpha[3]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::above, alpha[3]);
 
                     }
                     else
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                 V * csubl - alpha[3]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, (nidx),
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::above,
                                 -d.A[3] * udotm[3] + alpha[3]);
                     }
                 }
@@ -1328,75 +1356,67 @@ void PBSM3D::run(mesh& domain)
                     if (udotm[3] > 0)
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                 V * csubl - d.A[3] * udotm[3] - alpha[3]);
                         // RHS
                         double val = -alpha[3] * cprecip;
-                        suspension_NNP->rhsSumIntoGlobalValue(idx,val);
+                        suspension_NNP->rhsSumIntoLocalRow(row, val);
                     }
                     else
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                 V * csubl - alpha[3]);
                         // RHS
                         double val = d.A[3] * cprecip * udotm[3] - alpha[3] * cprecip;
-                        suspension_NNP->rhsSumIntoGlobalValue(idx,val);
+                        suspension_NNP->rhsSumIntoLocalRow(row, val);
                     }
-
-                    // ntri * (z - 1) + face->cell_local_id
-                    int nidx = n_global_tri*(z-1)+face->cell_global_id;
                     if (udotm[4] > 0)
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx,
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self,
                                 V * csubl - d.A[4] * udotm[4] - alpha[4]);
 
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::below, alpha[4]);
                     }
                     else
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx, V * csubl - alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self, V * csubl - alpha[4]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, -d.A[4] * udotm[4] + alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::below, -d.A[4] * udotm[4] + alpha[4]);
                     }
                 }
                 else // middle layers
                 {
-                    // ntri * (z + 1) + face->cell_local_id (looking up)
-                    int nidx = n_global_tri*(z+1) + face->cell_global_id;
                     if (udotm[3] > 0)
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx, V * csubl - d.A[3] * udotm[3] - alpha[3]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self, V * csubl - d.A[3] * udotm[3] - alpha[3]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, alpha[3]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::above, alpha[3]);
                     }
                     else
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx, V * csubl - alpha[3]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self, V * csubl - alpha[3]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, -d.A[3] * udotm[3] + alpha[3]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::above, -d.A[3] * udotm[3] + alpha[3]);
                     }
-
-                    // ntri * (z + 1) + face->cell_local_id (looking down)
-                    nidx = n_global_tri*(z-1) + face->cell_global_id;
                     if (udotm[4] > 0)
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx, V * csubl - d.A[4] * udotm[4] - alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self, V * csubl - d.A[4] * udotm[4] - alpha[4]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::below, alpha[4]);
                     }
                     else
                     {
                         // Diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, idx, V * csubl - alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::self, V * csubl - alpha[4]);
                         // Off diagonal entry
-                        suspension_NNP->matrixSumIntoGlobalValues(idx, nidx, -d.A[4] * udotm[4] + alpha[4]);
+                        suspension_NNP->matrixSumIntoLocalRow(row, la::below, -d.A[4] * udotm[4] + alpha[4]);
                     }
                 }
 
@@ -1428,8 +1448,10 @@ void PBSM3D::run(mesh& domain)
 
         try
         {
-            auto suspension_results = suspension_NNP->Solve();
-            LOG_DEBUG << "  suspension (isolated) iterations: " << suspension_results.numIters << " residual: " << suspension_results.residual;
+            suspension_results = suspension_NNP->Solve();
+            LOG_DEBUG << "  suspension (isolated) iterations: " << suspension_results.numIters << " residual: " << suspension_results.residual
+                      << " setup: " << suspension_results.setup_time << " s" << (suspension_results.preconditioner_recomputed ? " (recomputed)" : " (reused)")
+                      << " solve: " << suspension_results.solve_time << " s";
         } catch(const Belos::StatusTestError& e)
         {
             int rank = 0;
@@ -1454,6 +1476,7 @@ void PBSM3D::run(mesh& domain)
     else {
         LOG_DEBUG << "  No suspended snow.";
     }
+    export_solver_stats_to_faces(domain, "suspension", suspension_results);
 
     // Note we still have to do the following if there is no suspended snow.
     // - In that case suspension_solution should be the 0 vector it was initialized to for this iteration
@@ -1502,9 +1525,8 @@ void PBSM3D::run(mesh& domain)
     /*
        Communicate necessary (neighbor) vars for deposition linear system setup
        */
-    // LOG_DEBUG << "Qsusp"_s << "     " << "Qsalt"_s;
-    domain->ghost_neighbors_communicate_variable("Qsusp"_s);
-    domain->ghost_neighbors_communicate_variable("Qsalt"_s);
+    // one packed message per neighbour rank for both variables
+    Q_ghost_exchange->exchange();
 
     /*
        Setup and solve the linear system for deposition
@@ -1532,15 +1554,14 @@ void PBSM3D::run(mesh& domain)
 
         double V = face->get_area(); // V for consistency but actually an area
 
-        int global_row, local_col, global_col;
-        global_row = static_cast<int>(face->cell_global_id);
+        size_t row = deposition_NNP->localRow(face->cell_local_id);
 
         if(is_nan(V))
         {
             LOG_DEBUG << "Triangle " << face->cell_global_id << " area is nan";
         }
         // Diagonal element
-        deposition_NNP->matrixReplaceGlobalValues(global_row, global_row, V);
+        deposition_NNP->matrixReplaceLocalRow(row, la::self, V);
 
         // iterate over edges
         for (int j = 0; j < 3; j++)
@@ -1606,7 +1627,6 @@ void PBSM3D::run(mesh& domain)
             if (d.face_neigh[j])
             {
                 auto neigh = face->neighbor(j);
-                global_col = static_cast<int>(neigh->cell_global_id);
                 dx[j] = math::gis::distance(face->center(), neigh->center());
 
                 if(is_nan(eps))
@@ -1618,10 +1638,10 @@ void PBSM3D::run(mesh& domain)
                     LOG_DEBUG << "dx is nan!";
                 }
                 // diagonal entry
-                deposition_NNP->matrixSumIntoGlobalValues(global_row, global_row, eps * E[j] / dx[j]);
+                deposition_NNP->matrixSumIntoLocalRow(row, la::self, eps * E[j] / dx[j]);
 
                 // off diagonal entry
-                deposition_NNP->matrixSumIntoGlobalValues(global_row, global_col, -eps * E[j] / dx[j]);
+                deposition_NNP->matrixSumIntoLocalRow(row, static_cast<la::StencilSlot>(j), -eps * E[j] / dx[j]);
             }
 
             // RHS
@@ -1650,7 +1670,7 @@ void PBSM3D::run(mesh& domain)
                 }
                 LOG_DEBUG << "-------------------------------------------------";
             }
-            deposition_NNP->rhsSumIntoGlobalValue(global_row,val);
+            deposition_NNP->rhsSumIntoLocalRow(row, val);
         }
     } // end face iteration
 
@@ -1682,8 +1702,10 @@ void PBSM3D::run(mesh& domain)
 
         try
         {
-            auto deposition_results = deposition_NNP->Solve();
-            LOG_DEBUG << "  deposition (isolated) iterations: " << deposition_results.numIters << " residual: " << deposition_results.residual;
+            deposition_results = deposition_NNP->Solve();
+            LOG_DEBUG << "  deposition (isolated) iterations: " << deposition_results.numIters << " residual: " << deposition_results.residual
+                      << " setup: " << deposition_results.setup_time << " s" << (deposition_results.preconditioner_recomputed ? " (recomputed)" : " (reused)")
+                      << " solve: " << deposition_results.solve_time << " s";
         } catch(Belos::StatusTestError& e)
         {
             int rank = 0;
@@ -1695,6 +1717,7 @@ void PBSM3D::run(mesh& domain)
             std::string prefix = "deposition.rank" + std::to_string(rank);
 //            deposition_NNP->writeSystemMatrixMarket(prefix);
             LOG_ERROR << e.what();
+            export_solver_stats_to_faces(domain, "deposition", deposition_results);
             return;
 //            BOOST_THROW_EXCEPTION(module_error() << errstr_info(e.what()));
         }
@@ -1741,7 +1764,20 @@ void PBSM3D::run(mesh& domain)
         LOG_DEBUG << "  No deposited snow.";
     }
 
+    export_solver_stats_to_faces(domain, "deposition", deposition_results);
+}
 
+void PBSM3D::export_solver_stats_to_faces(mesh& domain, const std::string& system,
+                                          const math::LinearAlgebra::SolveConverge& results)
+{
+    if (!export_solver_stats)
+        return;
+
+    // the solve is global, so every face gets the same value
+    auto iterations = domain->variable_column(system + "_solver_iterations");
+    auto time = domain->variable_column(system + "_solver_time");
+    std::fill(iterations.begin(), iterations.end(), results.numIters);
+    std::fill(time.begin(), time.end(), results.setup_time + results.solve_time);
 }
 
 PBSM3D::~PBSM3D() {
@@ -1749,22 +1785,13 @@ PBSM3D::~PBSM3D() {
 
 void PBSM3D::checkpoint(mesh& domain,  netcdf& chkpt)
 {
-    chkpt.create_variable1D("PBSM3D:sum_drift", domain->size_faces());
-
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        chkpt.put_var1D("PBSM3D:sum_drift", i,
-                        (*face)["sum_drift"_s]);
-    }
+    size_t n = domain->size_faces();
 
+    chkpt.put_column("PBSM3D:sum_drift", n, [&](size_t i) { return (*domain->face(i))["sum_drift"_s]; });
 }
 
 void PBSM3D::load_checkpoint(mesh& domain,  netcdf& chkpt)
 {
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        (*face)["sum_drift"_s] = chkpt.get_var1D("PBSM3D:sum_drift", i);
-    }
+    size_t n = domain->size_faces();
+    chkpt.get_column("PBSM3D:sum_drift", n, [&](size_t i, double v) { (*domain->face(i))["sum_drift"_s] = v; });
 }
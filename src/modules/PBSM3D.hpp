@@ -44,6 +44,7 @@
 #include <gsl/gsl_randist.h>
 #include <gsl/gsl_sf_lambert.h>
 #include <vector>
+#include <algorithm>
 
 #include <armadillo>
 
@@ -128,7 +129,13 @@
  *       "rouault_diffusion_coef": false,
  *       "enable_veg": true,
  *       "iterative_subl": false,
- *
+ *       "solver":
+ *       {
+ *          "type": "GMRES",
+ *          "preconditioner": "ILUT",
+ *          "recompute_every": 1,
+ *          "warm_start": false
+ *       }
  *    }
  *
  *
@@ -292,6 +299,70 @@
  *    Use the Pomeroy and Li (2000) iterative solution for Schimdt's sublimation equation. This code path has not had
  *    extensive testing and should not be used at the moment.
  *
+ * .. confval:: solver.type
+ *
+ *    :default: "GMRES"
+ *
+ *    Belos Krylov solver used for the suspension and deposition systems, e.g., ``GMRES`` or ``BICGSTAB``.
+ *
+ * .. confval:: solver.preconditioner
+ *
+ *    :default: "ILUT"
+ *
+ *    One of ``ILUT``, ``RILUK``, ``JACOBI``, ``MUELU`` or ``NONE``. ``MUELU`` is only available if Trilinos was built with MueLu.
+ *
+ * .. confval:: solver.tolerance
+ *
+ *    :default: 1e-8
+ *
+ *    Relative residual convergence tolerance.
+ *
+ * .. confval:: solver.max_iterations
+ *
+ *    :default: 1000
+ *
+ *    Maximum number of solver iterations.
+ *
+ * .. confval:: solver.num_blocks
+ *
+ *    :default: 30
+ *
+ *    GMRES restart length.
+ *
+ * .. confval:: solver.recompute_every
+ *
+ *    :default: 1
+ *
+ *    Recompute the preconditioner after it has been used for this many solves. The sparsity pattern never changes,
+ *    so a preconditioner from a previous timestep is usually still effective when the wind field changes slowly.
+ *
+ * .. confval:: solver.recompute_threshold
+ *
+ *    :default: 0
+ *
+ *    If > 0, also recompute the preconditioner once the relative change in the matrix Frobenius norm since it was
+ *    last computed exceeds this value.
+ *
+ * .. confval:: solver.warm_start
+ *
+ *    :default: false
+ *
+ *    Use the previous solution as the initial guess.
+ *
+ * .. confval:: solver.matrix_free
+ *
+ *    :default: false
+ *
+ *    Experimental. Apply the cached stencil directly instead of assembling a sparse matrix. No preconditioner is
+ *    available in this mode, so :confval:`solver.preconditioner` defaults to ``NONE`` and must not be set otherwise.
+ *
+ * .. confval:: solver.export_stats
+ *
+ *    :default: false
+ *
+ *    Output ``suspension_solver_iterations``, ``suspension_solver_time``, ``deposition_solver_iterations`` and
+ *    ``deposition_solver_time`` [s]. These are 0 on timesteps without a solve.
+ *
  *
  *
  * \endrst
@@ -420,6 +491,16 @@ private:
   std::unique_ptr<math::LinearAlgebra::NearestNeighborProblem> deposition_NNP;
   std::unique_ptr<math::LinearAlgebra::NearestNeighborProblem> suspension_NNP;
 
+  math::LinearAlgebra::SolverOptions solver_options;
+
+  // halo exchange of Qsusp and Qsalt for the deposition system
+  std::shared_ptr<ghost_exchange> Q_ghost_exchange;
+
+  // write per-solve iteration counts and times to the faces
+  bool export_solver_stats;
+  void export_solver_stats_to_faces(mesh& domain, const std::string& system,
+                                    const math::LinearAlgebra::SolveConverge& results);
+
 };
 
 /**
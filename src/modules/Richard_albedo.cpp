@@ -43,23 +43,18 @@ Richard_albedo::~Richard_albedo()
 
 void Richard_albedo::checkpoint(mesh& domain,  netcdf& chkpt)
 {
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> Richard_albedo::data& { return domain->face(i)->get_module_data<Richard_albedo::data>(ID); };
 
-    chkpt.create_variable1D("Richard_albedo:albedo", domain->size_faces());
-
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        chkpt.put_var1D("Richard_albedo:albedo",i,face->get_module_data<Richard_albedo::data>(ID).albedo);
-    }
+    chkpt.put_column("Richard_albedo:albedo", n, [&](size_t i) { return face_data(i).albedo; });
 }
 
 void Richard_albedo::load_checkpoint(mesh& domain,  netcdf& chkpt)
 {
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        face->get_module_data<Richard_albedo::data>(ID).albedo = chkpt.get_var1D("Richard_albedo:albedo",i);
-    }
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> Richard_albedo::data& { return domain->face(i)->get_module_data<Richard_albedo::data>(ID); };
+
+    chkpt.get_column("Richard_albedo:albedo", n, [&](size_t i, double v) { face_data(i).albedo = v; });
 }
 
 void Richard_albedo::run(mesh_elem &face)
@@ -39,35 +39,38 @@ fast_shadow::fast_shadow(config_file cfg)
 
     //size of the step to take
     size_of_step = max_distance / steps;
-}
 
-fast_shadow::~fast_shadow()
-{
+    // number of azimuth bins in the precomputed horizon table. 0 searches every timestep
+    azimuth_bins = cfg.get("azimuth_bins",72);
 
+    // save/load the horizon table next to the mesh
+    horizon_cache = cfg.get("horizon_cache",false);
 
+    if(azimuth_bins < 0)
+    {
+        CHM_THROW_EXCEPTION(config_error, "fast_shadow azimuth_bins must be >= 0");
+    }
 }
 
-void fast_shadow::run(mesh_elem& face)
+fast_shadow::~fast_shadow()
 {
 
-    double solar_el = (*face)["solar_el"_s] *M_PI / 180.;
 
-    (*face)["shadow"_s]= 0;
-    //bail early
-    if (solar_el < 0)
-        return;
-
-    double solar_az = (*face)["solar_az"_s] ;
+}
 
+double fast_shadow::horizon_angle(mesh_elem& face, double azimuth)
+{
     Point_3 me = face->center();
 
     double phi = 0.;
+    // each step starts the search from the previous step's face, which is at most a few triangles away
+    mesh_elem f = face;
     // search along each azimuth in j step increments to find horizon angle
     for (int j = 1; j <= steps; ++j)
     {
         double distance = j * size_of_step;
 
-        auto f = face->find_closest_face(solar_az, distance);
+        f = face->find_face(azimuth, distance, f);
 
         double z_diff = f->center().z() - me.z() ;
         if (z_diff > 0)
@@ -75,18 +78,220 @@ void fast_shadow::run(mesh_elem& face)
             double dist = math::gis::distance(f->center(), me);
             phi = std::max(atan(z_diff / dist), phi);
         }
-        //try to bail early if possible
-        if (phi > solar_el )
+    }
+
+    return phi;
+}
+
+uint64_t fast_shadow::terrain_checksum(mesh& domain)
+{
+    // a horizon depends on the elevations up to max_distance away, so any edit to the vertices invalidates the table
+    std::vector<double> coords;
+    coords.reserve(domain->size_vertex() * 3);
+    for (size_t i = 0; i < domain->size_vertex(); i++)
+    {
+        auto p = domain->vertex(i)->point();
+        coords.push_back(p.x());
+        coords.push_back(p.y());
+        coords.push_back(p.z());
+    }
+
+    return wyhash(coords.data(), coords.size() * sizeof(double), 0);
+}
+
+std::string fast_shadow::horizon_cache_path(mesh& domain)
+{
+    auto path = boost::filesystem::path(global_param->mesh_path());
+
+    std::string suffix = "_horizon";
+#ifdef USE_MPI
+    suffix += "_" + std::to_string(domain->_comm_world.rank());
+#endif
+
+    return (path.parent_path() / (path.stem().string() + suffix + ".h5")).string();
+}
+
+bool fast_shadow::load_horizon(mesh& domain, const std::string& path)
+{
+    if(!boost::filesystem::exists(path))
+        return false;
+
+    try
+    {
+        Exception::dontPrint();
+
+        H5::H5File file(path, H5F_ACC_RDONLY);
+
+        // only reuse a table built with the same search
+        int bins = 0;
+        int nsteps = 0;
+        double distance = 0;
+        file.openAttribute("azimuth_bins").read(PredType::NATIVE_INT, &bins);
+        file.openAttribute("steps").read(PredType::NATIVE_INT, &nsteps);
+        file.openAttribute("max_distance").read(PredType::NATIVE_DOUBLE, &distance);
+
+        if(bins != azimuth_bins || nsteps != steps || distance != max_distance)
+        {
+            LOG_DEBUG << "Horizon table " << path << " was built with different settings, rebuilding";
+            return false;
+        }
+
+        // the same face ids do not mean the same terrain, e.g., an edited mesh
+        uint64_t checksum = 0;
+        if(file.attrExists("terrain_checksum"))
+            file.openAttribute("terrain_checksum").read(PredType::NATIVE_UINT64, &checksum);
+
+        if(checksum != terrain_checksum(domain))
         {
-            (*face)["shadow"_s]= 1;
+            LOG_DEBUG << "Horizon table " << path << " was built for different terrain, rebuilding";
+            return false;
+        }
+
+        H5::DataSet ids_dataset = file.openDataSet("/global_id");
+        hsize_t nrows = 0;
+        ids_dataset.getSpace().getSimpleExtentDims(&nrows);
+
+        std::vector<int> ids(nrows);
+        ids_dataset.read(ids.data(), PredType::NATIVE_INT);
+
+        std::vector<float> table(nrows * azimuth_bins);
+        file.openDataSet("/horizon").read(table.data(), PredType::NATIVE_FLOAT);
+
+        std::unordered_map<int, size_t> rows;
+        for (size_t i = 0; i < nrows; i++)
+            rows[ids[i]] = i;
+
+        for (size_t i = 0; i < domain->size_faces(); i++)
+        {
+            auto face = domain->face(i);
+            auto itr = rows.find(face->cell_global_id);
+            if(itr == rows.end())
+            {
+                LOG_DEBUG << "Horizon table " << path << " does not cover this domain, rebuilding";
+                return false;
+            }
+
+            std::copy_n(table.begin() + itr->second * azimuth_bins, azimuth_bins,
+                        _horizon.begin() + face->storage_id * azimuth_bins);
         }
     }
-    //try to bail early if possible
-    if (phi > solar_el )
+    catch(H5::Exception& e)
     {
-        (*face)["shadow"_s]= 1;
+        LOG_WARNING << "Unable to read horizon table " << path << ", rebuilding";
+        return false;
     }
 
+    return true;
+}
 
+void fast_shadow::save_horizon(mesh& domain, const std::string& path)
+{
+    try
+    {
+        Exception::dontPrint();
+
+        H5::H5File file(path, H5F_ACC_TRUNC);
+
+        H5::DataSpace scalar(H5S_SCALAR);
+        file.createAttribute("azimuth_bins", PredType::NATIVE_INT, scalar).write(PredType::NATIVE_INT, &azimuth_bins);
+        file.createAttribute("steps", PredType::NATIVE_INT, scalar).write(PredType::NATIVE_INT, &steps);
+        file.createAttribute("max_distance", PredType::NATIVE_DOUBLE, scalar).write(PredType::NATIVE_DOUBLE, &max_distance);
+
+        uint64_t checksum = terrain_checksum(domain);
+        file.createAttribute("terrain_checksum", PredType::NATIVE_UINT64, scalar).write(PredType::NATIVE_UINT64, &checksum);
+
+        hsize_t nrows = domain->size_faces();
+        std::vector<int> ids(nrows);
+        for (size_t i = 0; i < nrows; i++)
+            ids[i] = domain->face(i)->cell_global_id;
+
+        H5::DataSpace id_space(1, &nrows);
+        file.createDataSet("/global_id", PredType::NATIVE_INT, id_space).write(ids.data(), PredType::NATIVE_INT);
+
+        // owned faces are the first rows of the table
+        hsize_t dims[2] = {nrows, static_cast<hsize_t>(azimuth_bins)};
+        H5::DataSpace table_space(2, dims);
+        file.createDataSet("/horizon", PredType::NATIVE_FLOAT, table_space).write(_horizon.data(), PredType::NATIVE_FLOAT);
+    }
+    catch(H5::Exception& e)
+    {
+        // the cache is optional, keep going
+        LOG_WARNING << "Unable to write horizon table " << path;
+    }
+}
+
+void fast_shadow::init(mesh& domain)
+{
+    _domain = domain;
+
+    if(azimuth_bins == 0)
+        return;
+
+    _horizon.resize(domain->size_faces() * azimuth_bins);
+
+    std::string path;
+    if(horizon_cache)
+    {
+        path = horizon_cache_path(domain);
+        if(load_horizon(domain, path))
+        {
+            LOG_DEBUG << "Loaded horizon table from " << path;
+            return;
+        }
+    }
+
+    LOG_DEBUG << "Building horizon table with " << azimuth_bins << " azimuth bins";
+
+    double bin_width = 360.0 / azimuth_bins;
+
+#pragma omp parallel for
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+        for (int b = 0; b < azimuth_bins; b++)
+        {
+            _horizon[face->storage_id * azimuth_bins + b] = horizon_angle(face, b * bin_width);
+        }
+    }
+
+    if(horizon_cache)
+        save_horizon(domain, path);
+}
+
+void fast_shadow::run(mesh_elem& face)
+{
+
+    double solar_el = (*face)["solar_el"_s] *M_PI / 180.;
+
+    (*face)["shadow"_s]= 0;
+    //bail early
+    if (solar_el < 0)
+        return;
+
+    double solar_az = (*face)["solar_az"_s] ;
+
+    double phi = 0;
+
+    // The table is only valid for the terrain it was built on
+    if(azimuth_bins > 0 && !_domain->_terrain_deformed)
+    {
+        // linearly interpolate between the two bins either side of the azimuth
+        double bin = std::fmod(std::fmod(solar_az, 360.0) + 360.0, 360.0) / (360.0 / azimuth_bins);
+        size_t b0 = static_cast<size_t>(bin) % azimuth_bins;
+        size_t b1 = (b0 + 1) % azimuth_bins;
+        double w = bin - std::floor(bin);
+
+        const float* h = &_horizon[face->storage_id * azimuth_bins];
+        phi = (1.0 - w) * h[b0] + w * h[b1];
+    }
+    else
+    {
+        phi = horizon_angle(face, solar_az);
+    }
+
+    if (phi > solar_el )
+    {
+        (*face)["shadow"_s]= 1;
+    }
 
 }
@@ -28,6 +28,9 @@
 #include "module_base.hpp"
 #include "TPSpline.hpp"
 
+#include <boost/filesystem.hpp>
+#include <unordered_map>
+
 //
 
 /**
@@ -51,7 +54,9 @@
  *
  *    {
  *       "steps": 10,
- *       "max_distance": 1000
+ *       "max_distance": 1000,
+ *       "azimuth_bins": 72,
+ *       "horizon_cache": false
  *    }
  *
  *
@@ -69,6 +74,24 @@
  *
  *    Maximum search distance to look for a higher point
  *
+ * .. confval:: azimuth_bins
+ *
+ *    :type: int
+ *    :default: 72
+ *
+ *    Number of azimuth bins in the horizon table that is built at init. The horizon angle for the solar azimuth is
+ *    linearly interpolated between bins. 0 disables the table and searches for the horizon every timestep. If the
+ *    mesh is deformed (e.g., ``deform_mesh``) the table is no longer used.
+ *
+ * .. confval:: horizon_cache
+ *
+ *    :type: bool
+ *    :default: false
+ *
+ *    Save the horizon table to ``<mesh>_horizon.h5`` next to the mesh and reuse it on later runs with the same settings
+ *    and the same vertex coordinates and elevations.
+ *    Under MPI each rank has its own ``<mesh>_horizon_<rank>.h5``.
+ *
  * \endrst
  *
  * **References:**
@@ -89,6 +112,7 @@ public:
     ~fast_shadow();
 
     virtual void run(mesh_elem& face);
+    virtual void init(mesh& domain);
 
 //number of steps along the search vector to check for a higher point
     int steps;
@@ -98,4 +122,25 @@ public:
     //size of the step to take
     double size_of_step;
 
+    // number of azimuth bins in the horizon table
+    int azimuth_bins;
+
+    // persist the horizon table next to the mesh
+    bool horizon_cache;
+
+private:
+    // horizon angle (rad) looking along azimuth (degrees)
+    double horizon_angle(mesh_elem& face, double azimuth);
+
+    // hash of every vertex's coordinates, so a cached table is only reused on the terrain it was built on
+    uint64_t terrain_checksum(mesh& domain);
+    std::string horizon_cache_path(mesh& domain);
+    bool load_horizon(mesh& domain, const std::string& path);
+    void save_horizon(mesh& domain, const std::string& path);
+
+    // horizon angle (rad) per face per azimuth bin, row = face storage_id
+    std::vector<float> _horizon;
+
+    // to check if the terrain has been deformed since the table was built
+    mesh _domain;
 };
@@ -46,6 +46,19 @@ fetchr::fetchr(config_file cfg)
 
     h_IBL = 5;
 
+    // number of wind direction bins in the precomputed fetch table. 0 searches every timestep
+    direction_bins = cfg.get("direction_bins",72);
+
+    if(direction_bins < 0)
+    {
+        CHM_THROW_EXCEPTION(config_error, "fetchr direction_bins must be >= 0");
+    }
+
+    if(steps > std::numeric_limits<uint16_t>::max())
+    {
+        CHM_THROW_EXCEPTION(config_error, "fetchr steps must be <= 65535");
+    }
+
 }
 
 fetchr::~fetchr()
@@ -54,15 +67,32 @@ fetchr::~fetchr()
 
 }
 
-void fetchr::run(mesh_elem& face)
+void fetchr::init(mesh& domain)
 {
+    _domain = domain;
 
+    if(direction_bins == 0)
+        return;
 
-    (*face)["fetch"_s]= max_distance;
+    LOG_DEBUG << "Building fetch table with " << direction_bins << " direction bins";
 
-    //direction it is from, need upwind fetch
-    double wind_dir = (*face)["vw_dir"_s] ;
+    _fetch_steps.resize(domain->size_faces() * direction_bins);
+
+    double bin_width = 360.0 / direction_bins;
+
+#pragma omp parallel for
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+        for (int b = 0; b < direction_bins; b++)
+        {
+            _fetch_steps[face->storage_id * direction_bins + b] = fetch_steps(face, b * bin_width);
+        }
+    }
+}
 
+uint16_t fetchr::fetch_steps(mesh_elem& face, double wind_dir)
+{
     //if we are using vegetation and the current face is covered in veg, set the fetch to 0
     if(incl_veg && face->has_vegetation())
     {
@@ -70,18 +100,18 @@ void fetchr::run(mesh_elem& face)
         double me_Z_CanTop = face->veg_attribute("CanopyHeight");
         if(me_Z_CanTop > 1) // 1m might be too high?
         {
-            (*face)["fetch"_s]= 0;
-            return;
+            return 0;
         }
 
     }
 
-    // search along wind_dir azimuth in j step increments
+    // search along wind_dir azimuth in j step increments, starting each search from the previous step's face
+    mesh_elem f = face;
     for (int j = 1; j <= steps; ++j)
     {
         double distance = j * size_of_step;
 
-        auto f = face->find_closest_face(wind_dir, distance);
+        f = face->find_face(wind_dir, distance, f);
 
         double Z_CanTop = 0;
         if (incl_veg && f->has_vegetation())
@@ -109,12 +139,33 @@ void fetchr::run(mesh_elem& face)
         if(Z_test >= Z_core ||
                 (incl_veg && distance < x_sss) )
         {
-            (*face)["fetch"_s]= distance;
-            break;
+            return j;
         }
     }
 
+    // unbroken
+    return steps;
+}
 
+void fetchr::run(mesh_elem& face)
+{
+    //direction it is from, need upwind fetch
+    double wind_dir = (*face)["vw_dir"_s] ;
 
-
+    // The table is only valid for the terrain it was built on
+    if(direction_bins > 0 && !_domain->_terrain_deformed)
+    {
+        // linearly interpolate between the two bins either side of the wind direction
+        double bin = std::fmod(std::fmod(wind_dir, 360.0) + 360.0, 360.0) / (360.0 / direction_bins);
+        size_t b0 = static_cast<size_t>(bin) % direction_bins;
+        size_t b1 = (b0 + 1) % direction_bins;
+        double w = bin - std::floor(bin);
+
+        const uint16_t* f = &_fetch_steps[face->storage_id * direction_bins];
+        (*face)["fetch"_s] = ((1.0 - w) * f[b0] + w * f[b1]) * size_of_step;
+    }
+    else
+    {
+        (*face)["fetch"_s] = fetch_steps(face, wind_dir) * size_of_step;
+    }
 }
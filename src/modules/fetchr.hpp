@@ -28,6 +28,9 @@
 #include "module_base.hpp"
 #include "TPSpline.hpp"
 
+#include <cstdint>
+#include <limits>
+
 
 
 /**
@@ -49,7 +52,8 @@
  *
  *    {
  *       "steps": 10,
- *       "max_distance": 1000
+ *       "max_distance": 1000,
+ *       "direction_bins": 72
  *    }
  *
  *
@@ -74,6 +78,15 @@
  *
  *    Rise/run threshold to multiply against the distance of a test triangle.
  *
+ * .. confval:: direction_bins
+ *
+ *    :type: int
+ *    :default: 72
+ *
+ *    Number of wind direction bins in the fetch table that is built at init. The fetch for the wind direction is
+ *    linearly interpolated between bins. 0 disables the table and searches for the fetch every timestep. If the mesh
+ *    is deformed (e.g., ``deform_mesh``) the table is no longer used.
+ *
  * \endrst
  *
  * **References:**
@@ -91,6 +104,7 @@ public:
     ~fetchr();
 
     virtual void run(mesh_elem& face);
+    virtual void init(mesh& domain);
 
 //number of steps along the search vector to check for a higher point
     int steps;
@@ -106,4 +120,16 @@ public:
     //0.06 m/m corresponds to prarie shelter belts
     double I;
 
+    // number of wind direction bins in the fetch table
+    int direction_bins;
+
+private:
+    // fetch, in number of steps, looking upwind from wind_dir (degrees)
+    uint16_t fetch_steps(mesh_elem& face, double wind_dir);
+
+    // fetch in steps per face per direction bin, row = face storage_id. fetch = steps * size_of_step is exact.
+    std::vector<uint16_t> _fetch_steps;
+
+    // to check if the terrain has been deformed since the table was built
+    mesh _domain;
 };
@@ -42,6 +42,17 @@ Liston_monthly_llra_ta::~Liston_monthly_llra_ta()
 }
 void Liston_monthly_llra_ta::init(mesh& domain)
 {
+    _t = var("t");
+    _t_lapse_rate = var("t_lapse_rate");
+
+    // IDW and nearest weights only depend on the geometry, so outside of point mode interpolate every face at once
+    // with a precomputed plan. Point mode only runs data parallel modules.
+    if( interp_plan::supported(global_param->interp_algorithm) && !global_param->is_point_mode())
+    {
+        _plan.init(global_param->interp_algorithm, domain);
+        _parallel_type = parallel::domain;
+        return;
+    }
 
 #pragma omp parallel for
     for (size_t i = 0; i < domain->size_faces(); i++)
@@ -54,9 +65,9 @@ void Liston_monthly_llra_ta::init(mesh& domain)
     }
 
 }
-void Liston_monthly_llra_ta::run(mesh_elem& face)
-{
 
+double Liston_monthly_llra_ta::lapse_rate()
+{
     double lapse_rate = -9999;
 
     switch(global_param->month())
@@ -100,6 +111,41 @@ void Liston_monthly_llra_ta::run(mesh_elem& face)
 
     }
 
+    return lapse_rate;
+}
+
+void Liston_monthly_llra_ta::run(mesh& domain)
+{
+    double lapse_rate = this->lapse_rate();
+
+    //lower all the station values to sea level prior to the interpolation
+    auto lowered_values = _plan.station_values([&](station& s)
+    {
+        if( is_nan(s["t"_s]))
+            return std::nan("nan");
+
+        return s["t"_s] - lapse_rate * (0.0 - s.z());
+    });
+
+    // rows of the plan are the face variable column order
+    auto t = domain->face_variables().column(_t);
+    _plan.apply(lowered_values, t.data);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+
+        //raise value back up to the face's elevation from sea level
+        face->get(_t) += lapse_rate * (0.0 - face->get_z());
+        face->get(_t_lapse_rate) = lapse_rate;
+    }
+}
+
+void Liston_monthly_llra_ta::run(mesh_elem& face)
+{
+
+    double lapse_rate = this->lapse_rate();
 
     //lower all the station values to sea level prior to the interpolation
     std::vector< boost::tuple<double, double, double> > lowered_values;
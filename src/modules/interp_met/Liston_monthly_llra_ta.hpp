@@ -26,6 +26,7 @@
 #include "../logger.hpp"
 #include "triangulation.hpp"
 #include "module_base.hpp"
+#include "interp_plan.hpp"
 #include <cstdlib>
 #include <string>
 
@@ -59,9 +60,19 @@ public:
     Liston_monthly_llra_ta(config_file cfg);
     ~Liston_monthly_llra_ta();
     virtual void run(mesh_elem& face);
+    virtual void run(mesh& domain);
     virtual void init(mesh& domain);
     struct data : public face_info
     {
         interpolation interp;
     };
+private:
+    // lapse rate for the current month
+    double lapse_rate();
+
+    // used instead of the per-face interpolation when the algorithm allows it
+    interp_plan _plan;
+
+    var_handle _t;
+    var_handle _t_lapse_rate;
 };
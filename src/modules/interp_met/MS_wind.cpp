@@ -54,12 +54,14 @@ MS_wind::MS_wind(config_file cfg)
 //Calculates the curvature required
 void MS_wind::init(mesh& domain)
 {
+    _face_data = make_module_data_slab<data>(domain);
+
     #pragma omp parallel for
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
         auto face = domain->face(i);
 
-         auto& d = face->make_module_data<data>(ID);
+         auto& d = _face_data[face];
          d.interp.init(global_param->interp_algorithm,face->stations().size() );
          d.interp_smoothing.init(interp_alg::tpspline,3,{ {"reuse_LU","true"}});
     }
@@ -102,8 +104,8 @@ void MS_wind::run(mesh& domain)
 
 		     // get an interpolated zonal U,V at our face
 		     auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-		     double zonal_u = face->get_module_data<data>(ID).interp(u, query);
-		     double zonal_v = face->get_module_data<data>(ID).interp(v, query);
+		     double zonal_u = _face_data[face].interp(u, query);
+		     double zonal_v = _face_data[face].interp(v, query);
 
 		     (*face)["interp_zonal_u"_s]= zonal_u;
 		     (*face)["interp_zonal_v"_s]= zonal_v;
@@ -215,10 +217,10 @@ void MS_wind::run(mesh& domain)
           {
             auto query =
                 boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-            new_u = face->get_module_data<data>(ID).interp_smoothing(u, query);
+            new_u = _face_data[face].interp_smoothing(u, query);
           }
 
-          face->get_module_data<data>(ID).temp_u = new_u;
+          _face_data[face].temp_u = new_u;
         }
 
 
@@ -228,7 +230,7 @@ void MS_wind::run(mesh& domain)
         {
             auto face = domain->face(i);
 
-		     (*face)["U_R"_s]= std::max(0.1, face->get_module_data<data>(ID).temp_u);
+		     (*face)["U_R"_s]= std::max(0.1, _face_data[face].temp_u);
         }
 
     }else
@@ -250,7 +252,7 @@ void MS_wind::run(mesh& domain)
 
                double theta = (*s)["vw_dir"_s] * M_PI / 180.;
 
-               auto f = domain->find_closest_face(s->x(),s->y());
+               auto f = domain->find_face(s->x(),s->y());
                //figure out which lookup map we need
                int d = int(theta*180/M_PI/45.);
                if (d == 0) d = 8;
@@ -273,8 +275,8 @@ void MS_wind::run(mesh& domain)
              //http://mst.nerc.ac.uk/wind_vect_convs.html
 
              auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-             double zonal_u = face->get_module_data<data>(ID).interp(u, query);
-             double zonal_v = face->get_module_data<data>(ID).interp(v, query);
+             double zonal_u = _face_data[face].interp(u, query);
+             double zonal_v = _face_data[face].interp(v, query);
 
              double theta = 3.0 * M_PI * 0.5 - atan2(zonal_v, zonal_u);
 
@@ -289,8 +291,8 @@ void MS_wind::run(mesh& domain)
 
              double W = sqrt(zonal_u * zonal_u + zonal_v * zonal_v);
 
-             face->get_module_data<data>(ID).corrected_theta = theta;
-             face->get_module_data<data>(ID).W = W;
+             _face_data[face].corrected_theta = theta;
+             _face_data[face].W = W;
 
         }
 
@@ -301,8 +303,8 @@ void MS_wind::run(mesh& domain)
             auto face = domain->face(i);
 
 
-		     double theta= face->get_module_data<data>(ID).corrected_theta;
-		     double W= face->get_module_data<data>(ID).W;
+		     double theta= _face_data[face].corrected_theta;
+		     double W= _face_data[face].W;
 
 		     //what liston calls 'wind slope'
 		     double omega_s = face->slope() * cos(theta - face->aspect());
@@ -386,10 +388,10 @@ void MS_wind::run(mesh& domain)
 		     if (u.size() > 0)
 		     {
 		       auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-		       new_u = face->get_module_data<data>(ID).interp_smoothing(u, query);
+		       new_u = _face_data[face].interp_smoothing(u, query);
 		     }
 
-		     face->get_module_data<data>(ID).temp_u = new_u;
+		     _face_data[face].temp_u = new_u;
 
         }
 
@@ -398,7 +400,7 @@ void MS_wind::run(mesh& domain)
         {
             auto face = domain->face(i);
 
-		     (*face)["U_R"_s]= std::max(0.1,face->get_module_data<data>(ID).temp_u) ;
+		     (*face)["U_R"_s]= std::max(0.1,_face_data[face].temp_u) ;
 
         }
 
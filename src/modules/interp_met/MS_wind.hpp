@@ -102,7 +102,7 @@ public:
     virtual void init(mesh& domain);
     double ys;
     double yc;
-    class data : public face_info
+    class data
     {
     public:
         double curvature;
@@ -112,6 +112,7 @@ public:
         double temp_u;
         interpolation interp_smoothing;
     };
+    module_data_slab<data> _face_data;
     double distance;
     bool use_ryan_dir;
     double speedup_height; // height at which the speedup is for
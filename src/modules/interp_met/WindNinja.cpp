@@ -77,11 +77,13 @@ WindNinja::WindNinja(config_file cfg)
 //Calculates the curvature required
 void WindNinja::init(mesh& domain)
 {
+    _face_data = make_module_data_slab<data>(domain);
+
     #pragma omp parallel for
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
         auto face = domain->face(i);
-        auto& d = face->make_module_data<data>(ID);
+        auto& d = _face_data[face];
         d.interp.init(global_param->interp_algorithm,face->stations().size() );
         d.interp_smoothing.init(interp_alg::tpspline,3,{ {"reuse_LU","true"}});
     }
@@ -241,6 +243,36 @@ void WindNinja::init(mesh& domain)
     }
 
 
+    // Load the wind field library into a dense table so run() never has to build parameter names
+    std::vector<std::string> W_names, U_names, V_names;
+    for (int d = 1; d <= N_windfield; d++)
+    {
+        if(L_avg == -1)
+        {
+            W_names.push_back("Ninja" + std::to_string(d));   // transfert function
+        }else
+        {
+            W_names.push_back("Ninja" + std::to_string(d) +'_' + std::to_string(L_avg));   // transfert function
+        }
+        U_names.push_back("Ninja" + std::to_string(d) + "_U");  // zonal component
+        V_names.push_back("Ninja" + std::to_string(d) + "_V");  // meridional component
+    }
+
+    _library.resize(domain->size_faces() * N_windfield * 3);
+
+    #pragma omp parallel for
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+        for (int d = 1; d <= N_windfield; d++)
+        {
+            float* lib = library(face, d);
+            lib[0] = face->parameter(W_names[d-1]);
+            lib[1] = face->parameter(U_names[d-1]);
+            lib[2] = face->parameter(V_names[d-1]);
+        }
+    }
+
     H_forc = cfg.get("H_forc",40.0);
     Max_spdup = cfg.get("Max_spdup",3.);
     Min_spdup = cfg.get("Min_spdup",0.1);
@@ -259,18 +291,25 @@ void WindNinja::init(mesh& domain)
             tmp.put("incl_snw",false);
         }
 
+        // the ray cache makes the per-timestep Sx a gather along precomputed paths
+        tmp.put("ray_cache", cfg.get("Sx_ray_cache", false));
+
         Sx = boost::dynamic_pointer_cast<Winstral_parameters>(module_factory::create("Winstral_parameters",tmp));
+        Sx->init(domain);
     }
 }
 
 
 void WindNinja::run(mesh& domain)
 {
+        if(compute_Sx)
+            Sx->release_stale_ray_cache(domain);
+
         double transf_max = -9999.0;
 
         double delta_angle = 360. / N_windfield;
 
-        #pragma omp parallel for
+        #pragma omp parallel for reduction(max:transf_max)
         for (size_t i = 0; i < domain->size_faces(); i++)
         {
             auto face = domain->face(i);
@@ -310,8 +349,8 @@ void WindNinja::run(mesh& domain)
 
             // get an interpolated zonal U,V at our face
             auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
-            double zonal_u = face->get_module_data<data>(ID).interp(u, query);
-            double zonal_v = face->get_module_data<data>(ID).interp(v, query);
+            double zonal_u = _face_data[face].interp(u, query);
+            double zonal_v = _face_data[face].interp(v, query);
 
             (*face)["interp_zonal_u"_s]= zonal_u;
             (*face)["interp_zonal_v"_s]= zonal_v;
@@ -341,15 +380,10 @@ void WindNinja::run(mesh& domain)
                 (*face)["lookup_d"_s]= d;
 
                 // get the transfert function and associated wind component for the interpolated wind direction
-		if(L_avg == -1)
-                {
-			W_transf = face->parameter("Ninja" + std::to_string(d));   // transfert function
-		}else
-		{
-			W_transf = face->parameter("Ninja" + std::to_string(d) +'_' + std::to_string(L_avg));   // transfert function
-                }
-                U = face->parameter("Ninja" + std::to_string(d) + "_U");  // zonal component
-                V = face->parameter("Ninja" + std::to_string(d) + "_V");  // meridional component
+                const float* lib = library(face, d);
+                W_transf = lib[0];   // transfert function
+                U = lib[1];  // zonal component
+                V = lib[2];  // meridional component
 
            }else // Linear interpolation between the closest 2 wind fields from the library
            {
@@ -367,29 +401,16 @@ void WindNinja::run(mesh& domain)
                 double d = d1*(theta2-theta)/(theta2-theta1)+d2*(theta-theta1)/(theta2-theta1);
                 (*face)["lookup_d"_s]= d;
 
-		double W_transf1 = 0.;
                 // get the transfert function and associated wind component for the interpolated wind direction
-		if(L_avg == -1)
-		{
-                	W_transf1 = face->parameter("Ninja" + std::to_string(d1));   // transfert function
-                }else
-		{
-			W_transf1 = face->parameter("Ninja" + std::to_string(d1)+'_' + std::to_string(L_avg));   // transfert function
-		}
-
-                double U_lib1 = face->parameter("Ninja" + std::to_string(d1) + "_U");  // zonal component
-                double V_lib1 = face->parameter("Ninja" + std::to_string(d1) + "_V");  // meridional component
-
-		double W_transf2 = 0.;
-		if(L_avg == -1)
-		{
-                	W_transf2 = face->parameter("Ninja" + std::to_string(d2));   // transfert function
-                }else
-		{
-			W_transf2 = face->parameter("Ninja" + std::to_string(d2)+'_' + std::to_string(L_avg));   // transfert function
-                }
-		double U_lib2 = face->parameter("Ninja" + std::to_string(d2) + "_U");  // zonal component
-                double V_lib2 = face->parameter("Ninja" + std::to_string(d2) + "_V");  // meridional component
+                const float* lib1 = library(face, d1);
+                double W_transf1 = lib1[0];   // transfert function
+                double U_lib1 = lib1[1];  // zonal component
+                double V_lib1 = lib1[2];  // meridional component
+
+                const float* lib2 = library(face, d2);
+                double W_transf2 = lib2[0];   // transfert function
+                double U_lib2 = lib2[1];  // zonal component
+                double V_lib2 = lib2[2];  // meridional component
 
                 // Determine wind component from the wind field library using a weighted mean
                 U = U_lib1*(theta2-theta)/(theta2-theta1)+U_lib2*(theta-theta1)/(theta2-theta1);
@@ -397,17 +418,16 @@ void WindNinja::run(mesh& domain)
                 W_transf = W_transf1*(theta2-theta)/(theta2-theta1)+W_transf2*(theta-theta1)/(theta2-theta1);
             }
 
-            if(fabs(W_transf)> transf_max )
-                     transf_max  = fabs(W_transf);
+            transf_max = std::max(transf_max, fabs(W_transf));
 
             // NEW wind direction from the wind field library
             theta = math::gis::zonal2dir(U, V);
 
             double W = sqrt(zonal_u * zonal_u + zonal_v * zonal_v);
 
-            face->get_module_data<data>(ID).corrected_theta = theta;
-            face->get_module_data<data>(ID).W = W;
-            face->get_module_data<data>(ID).W_transf = W_transf;
+            _face_data[face].corrected_theta = theta;
+            _face_data[face].W = W;
+            _face_data[face].W_transf = W_transf;
 
            }
 
@@ -417,9 +437,9 @@ void WindNinja::run(mesh& domain)
 
             auto face = domain->face(i);
 
-            double theta= face->get_module_data<data>(ID).corrected_theta;
-            double W= face->get_module_data<data>(ID).W;
-            double W_transf= face->get_module_data<data>(ID).W_transf;
+            double theta= _face_data[face].corrected_theta;
+            double W= _face_data[face].W;
+            double W_transf= _face_data[face].W_transf;
 
             (*face)["U_R_orig"_s]= W;   // Wind speed without downscaling
 
@@ -113,6 +113,14 @@
  *
  *    Reduce wind speed on the lee side of mountain crest identified by Sx>Sx_crit
  *
+ * .. confval:: Sx_ray_cache
+ *
+ *    :type: boolean
+ *    :default: false
+ *
+ *    Precompute the upwind search paths of ``compute_Sx`` at init, see ``ray_cache`` of ``Winstral_parameters``.
+ *    The cache is kept on the mesh and reused by any Sx computation with the same search parameters.
+ *
  * ..confval:: L_avg
  *
  *    :type: int
@@ -168,7 +176,7 @@ public:
     virtual void init(mesh& domain);
     double ys;
     double yc;
-    class data : public face_info
+    class data
     {
     public:
         double curvature;
@@ -179,6 +187,7 @@ public:
         interpolation interp_smoothing;
         double W_transf;
     };
+    module_data_slab<data> _face_data;
     double distance;
     int N_windfield; //  Number of wind fields in the library
     bool ninja_average; // Boolean to activate linear interpolation betweem the closest 2 wind fields from the library
@@ -192,4 +201,15 @@ public:
     bool compute_Sx; // uses the Sx module to influence the windspeeds so Sx needs to be computed during the windspeed evaluation, instead of a seperate module
     double Sx_crit;    // Critical values of the Winstral parameter to determine the occurence of flow separation.
     boost::shared_ptr<Winstral_parameters> Sx;
+
+private:
+    // Wind field library loaded at init as [face][direction][W_transf, U, V], face = storage_id
+    std::vector<float> _library;
+
+    // The {W_transf, U, V} entry of the face for library direction d on [1, N_windfield]
+    float* library(mesh_elem& face, int d)
+    {
+        d = (d - 1) % N_windfield + 1; // a direction of exactly 360 deg is the Nth field
+        return &_library[(face->storage_id * N_windfield + (d - 1)) * 3];
+    }
 };
@@ -64,13 +64,77 @@ Winstral_parameters::Winstral_parameters(config_file cfg)
     // Option to compute the elevation of the point considered to compute Sx
     use_subgridz = cfg.get("use_subgridz",true);
 
+    use_ray_cache = cfg.get("ray_cache",false);
+    ray_cache_resolution = cfg.get("ray_cache_resolution",delta_angle);
+    if(ray_cache_resolution <= 0)
+    {
+        CHM_THROW_EXCEPTION(config_error, "ray_cache_resolution must be > 0");
+    }
+    ray_cache_ndir = std::max<size_t>(1, std::lround(360.0 / ray_cache_resolution));
+    ray_cache_resolution = 360.0 / ray_cache_ndir;
+
 
     LOG_DEBUG << "Successfully instantiated module " << this->ID;
 }
 
-void Winstral_parameters::run(mesh& domain)
+void Winstral_parameters::init(mesh& domain)
+{
+    if(!use_ray_cache)
+        return;
+
+    // The search points only depend on the geometry and the wind direction, so walk every ray once here.
+    // Only the snow depth along them changes at runtime.
+    std::string key = "Winstral_parameters.ray_cache " + std::to_string(ray_cache_ndir) + " " + std::to_string(steps) +
+                      " " + std::to_string(size_of_step) + " " + std::to_string(incl_veg) + " " +
+                      std::to_string(use_subgridz);
+
+    ray_cache = domain->shared_data<std::vector<ray_sample>>(key, [&]()
+    {
+        size_t nface = domain->size_faces();
+        double mb = double(nface) * ray_cache_ndir * steps * sizeof(ray_sample) / (1024. * 1024.);
+        LOG_DEBUG << "Building Sx ray cache for " << ray_cache_ndir << " directions, " << steps << " steps (" << mb << " MB)";
+
+        auto cache = std::make_shared<std::vector<ray_sample>>(nface * ray_cache_ndir * steps);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < nface; i++)
+        {
+            auto face = domain->face(i);
+            auto face_centre = face->center();
+
+            for (size_t d = 0; d < ray_cache_ndir; ++d)
+            {
+                double wdir = d * ray_cache_resolution;
+                ray_sample* ray = &(*cache)[(face->cell_local_id * ray_cache_ndir + d) * steps];
+
+                mesh_elem f = face;
+                for (int j = 1; j <= this->steps; ++j)
+                {
+                    Point_2 pref = math::gis::point_from_bearing(face_centre, wdir, j * this->size_of_step);
+                    f = domain->find_face(pref, f);
+
+                    ray[j - 1].storage_id = f->storage_id;
+                    ray[j - 1].z = static_height(face_centre, f, pref);
+                }
+            }
+        }
+
+        return cache;
+    });
+}
+
+void Winstral_parameters::release_stale_ray_cache(const mesh& domain)
 {
+    if (ray_cache && domain->_terrain_deformed)
+    {
+        LOG_DEBUG << "Terrain has been deformed, releasing the Sx ray cache";
+        ray_cache.reset();
+    }
+}
 
+void Winstral_parameters::run(mesh& domain)
+{
+  release_stale_ray_cache(domain);
 
   #pragma omp parallel for
   for (size_t i = 0; i < domain->size_faces(); i++)
@@ -87,8 +151,83 @@ void Winstral_parameters::run(mesh& domain)
 
 }
 
+double Winstral_parameters::static_height(const Point_3& face_centre, mesh_elem& f, const Point_2& pref) const
+{
+    double Z_dist = 0.;
+    if(this->use_subgridz)
+    {
+       Z_dist = f->get_subgrid_z(pref);
+    }
+    else
+    {
+       Z_dist = face_centre.z();
+    }
+
+    if (this->incl_veg && f->has_vegetation())
+    {
+        Z_dist = Z_dist + f->veg_attribute("CanopyHeight");
+    }
+
+    return Z_dist;
+}
+
+double Winstral_parameters::Sx_cached(const mesh& domain, mesh_elem& face) const
+{
+    double Z_loc = face->center().z() + this->height_param;
+
+    if (this->incl_veg && face->has_vegetation())
+    {
+         Z_loc = Z_loc + face->veg_attribute("CanopyHeight");
+    }
+
+    const double* snow = nullptr;
+    if (this->incl_snw)
+    {
+         snow = domain->variable_column("snowdepthavg"_s).data;
+         Z_loc = Z_loc + snow[face->storage_id];
+    }
+
+    double sx_mean  = 0.;
+    double wind_dir = (*face)["vw_dir"_s] ;
+
+    for (int i = 1; i <= this->nangle; ++i)
+    {
+        double wdir = wind_dir - this->angular_window / 2.0 + (i - 1) * this->delta_angle;
+
+        // nearest cached direction
+        long d = std::lround(wdir / ray_cache_resolution) % static_cast<long>(ray_cache_ndir);
+        if (d < 0)
+            d += ray_cache_ndir;
+
+        const ray_sample* ray = &(*ray_cache)[(face->cell_local_id * ray_cache_ndir + d) * steps];
+
+        double max_tan_sx = 0.;
+        for (int j = 1; j <= this->steps; ++j)
+        {
+            double Z_dist = ray[j - 1].z;
+            if (snow)
+                Z_dist = Z_dist + snow[ray[j - 1].storage_id];
+
+            double tan_sx = (Z_dist-Z_loc) / (j * this->size_of_step);
+            if(std::abs(tan_sx) > std::abs(max_tan_sx))
+            {
+               max_tan_sx = tan_sx;
+            }
+        }
+
+        sx_mean = sx_mean + atan(max_tan_sx);
+    }
+
+    sx_mean = sx_mean / this->nangle;
+    return sx_mean*180/M_PI;
+}
+
 double Winstral_parameters::Sx(const mesh &domain, mesh_elem& face) const
 {
+    // The cached ray heights are only valid for the terrain they were built on
+    if (ray_cache && !domain->_terrain_deformed)
+        return Sx_cached(domain, face);
+
     // Reference point: center of the triangle
     auto face_centre = face->center();
 
@@ -119,29 +258,17 @@ double Winstral_parameters::Sx(const mesh &domain, mesh_elem& face) const
         double wdir = wind_dir - this->angular_window / 2.0 + (i - 1) * this->delta_angle;
 
        // search along wdir azimuth in j step increments
+        mesh_elem f = face;
         for (int j = 1; j <= this->steps; ++j)
         {
            double distance = j * this->size_of_step;
 
            // Select point along the line
            Point_2 pref =  math::gis::point_from_bearing(face_centre, wdir, distance);
-           // Find corresponding triangle
-           auto f = domain->find_closest_face (pref );
+           // Find corresponding triangle, walking from the previous step's
+           f = domain->find_face(pref, f);
 
-           double Z_dist = 0.;
-           if(this->use_subgridz)
-           {
-              Z_dist = f->get_subgrid_z(pref);
-           }
-           else
-           {
-              Z_dist = face_centre.z();
-           }
-
-           if (this->incl_veg && f->has_vegetation())
-           {
-               Z_dist = Z_dist + f->veg_attribute("CanopyHeight");
-            }
+           double Z_dist = static_height(face_centre, f, pref);
 
            if (this->incl_snw)
            {
@@ -27,8 +27,11 @@
 #include "triangulation.hpp"
 #include "module_base.hpp"
 #include "math/coordinates.hpp"
+#include <algorithm>
 #include <cstdlib>
+#include <cstdint>
 #include <string>
+#include <vector>
 
 #include <cmath>
 #include <armadillo>
@@ -63,8 +66,10 @@
  *       "angular_window": 30.0,
  *       "delta_angle" : 5.0,
  *       "incl_veg": false,
- *       "incl_snw": false
- *       "use_subgridz": true
+ *       "incl_snw": false,
+ *       "use_subgridz": true,
+ *       "ray_cache": false,
+ *       "ray_cache_resolution": 5.0
  *    }
  *
  * .. confval:: dmax
@@ -122,6 +127,26 @@
  *
  *    Use an interpolated height within the triangle instead of just the triangle cell centre. Avoids step function results.
  *
+ * .. confval:: ray_cache
+ *
+ *    :type: boolean
+ *    :default: false
+ *
+ *    Precompute, for every face and every cached wind direction, which triangle each step along the upwind search
+ *    lands in and its terrain (and vegetation) height. Each timestep then only adds the current snow depth along these
+ *    paths instead of searching the mesh again, which is much faster. The wind direction is rounded to
+ *    ``ray_cache_resolution``. Uses about ``8 * (360/ray_cache_resolution) * (dmax/size_of_step)`` bytes per face.
+ *    Other Sx computations on the mesh with the same ``ray_cache_resolution``, ``dmax``, ``size_of_step``,
+ *    ``incl_veg`` and ``use_subgridz`` reuse the same cache. It is freed once the terrain is deformed.
+ *
+ * .. confval:: ray_cache_resolution
+ *
+ *    :type: double
+ *    :default: delta_angle
+ *
+ *    Angular resolution [deg] of the cached wind directions. Should divide ``delta_angle`` so the window directions
+ *    fall on cached directions.
+ *
  * \endrst
  *
  * **References:**
@@ -140,6 +165,12 @@ public:
 
     virtual void run(mesh& domain);
 
+    /**
+     * Builds the ray cache if enabled
+     * @param domain
+     */
+    virtual void init(mesh& domain);
+
     //number of steps along the search vector to check for a higher point
     int steps;
     //max distance to search [m]
@@ -175,6 +206,36 @@ public:
     // Improve estimation of Sx when snow is accumulating during the snow season
     bool incl_snw;
 
+    // Precompute the upwind search for each face and wind direction, see init
+    bool use_ray_cache;
+    // angular resolution of the cached directions [deg]
+    double ray_cache_resolution;
+    // number of cached directions over 360 deg
+    size_t ray_cache_ndir;
+
+    // One step along an upwind search
+    struct ray_sample
+    {
+        uint32_t storage_id; // face variable row of the triangle the step landed in, for the snow depth
+        float z;             // static part of the height: terrain (subgrid) elevation + vegetation height
+    };
+
+    // [face cell_local_id][direction][step]. Held by the mesh too, so instances with the same search share one copy
+    std::shared_ptr<const std::vector<ray_sample>> ray_cache;
+
     // Calculates the Sx parameter
     double Sx(const mesh &domain, mesh_elem& face) const;
+
+    /**
+     * Drops the ray cache once the terrain has been deformed, as Sx no longer uses it. Call before a loop over Sx.
+     * @param domain
+     */
+    void release_stale_ray_cache(const mesh& domain);
+
+  private:
+    // Height of the search point pref, which lies in f, excluding the snow depth
+    double static_height(const Point_3& face_centre, mesh_elem& f, const Point_2& pref) const;
+
+    // Sx from the ray cache
+    double Sx_cached(const mesh& domain, mesh_elem& face) const;
 };
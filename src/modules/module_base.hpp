@@ -33,6 +33,7 @@ namespace pt = boost::property_tree;
 #include "global.hpp"
 #include "timeseries/netcdf.hpp"
 #include "factory.hpp"
+#include "module_data_slab.hpp"
 
 //Create a process modules group in the doxygen docs to add individual modules to
 /**
@@ -260,6 +261,18 @@ public:
 
     };
 
+    /**
+     * Allocates this module's per-face data as a contiguous slab, one default constructed T per locally owned face.
+     * Should be called in init. The module keeps the returned slab as a member; see module_data_slab.
+     * @param domain
+     * @return
+     */
+    template<typename T>
+    module_data_slab<T> make_module_data_slab(mesh& domain) const
+    {
+        return module_data_slab<T>(domain->size_faces());
+    }
+
     /*
      * Returns the module's parallel type
      * \return the parallel type
@@ -460,6 +473,28 @@ public:
             (*face)[itr.name]=-9999.;
         }
     }
+    /**
+     * Handle into the face variable storage for one of this module's provides, depends or found optionals.
+     * Resolved by core once the module dependency graph is built, so it is valid from init() onwards.
+     * Resolve once and use with face->get(h) in run().
+     */
+    var_handle var(const std::string& variable)
+    {
+        auto it = _var_handles.find(variable);
+        if(it == _var_handles.end())
+            BOOST_THROW_EXCEPTION(module_error() << errstr_info ("Module " + ID + " has no handle for variable " + variable));
+
+        return it->second;
+    }
+
+    /**
+     * Set the resolved handle for a variable. Called by core.
+     */
+    void set_var_handle(const std::string& variable, const var_handle& h)
+    {
+        _var_handles[variable] = h;
+    }
+
     /**
      * Set that an optional variable was found
      */
@@ -518,6 +553,9 @@ protected:
 
     // lists the options that were found
     std::map<std::string, bool> _optional_found;
+
+    // resolved face variable handles, see var()
+    std::map<std::string, var_handle> _var_handles;
 };
 
 /**
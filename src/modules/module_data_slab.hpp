@@ -0,0 +1,118 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#pragma once
+
+#include "triangulation.hpp"
+#include "timeseries/netcdf.hpp"
+#include "exception.hpp"
+
+#include <string>
+#include <vector>
+
+/**
+ * Per-face module data held by the module as one contiguous array, one T per locally owned face, indexed by the
+ * face's cell_local_id. This is the same index as domain->face(i), so a loop over i can use slab[i] directly.
+ *
+ * Compared to face::make_module_data, access is a plain index instead of a per-face hash lookup plus a dynamic_cast,
+ * and T does not need to derive from face_info or be heap allocated per face.
+ * Ghost faces do not have an entry.
+ *
+ * Create it with module_base::make_module_data_slab in the module's init, e.g.,
+ * @code
+ *     class data { public: double acc; };
+ *     module_data_slab<data> _face_data;
+ *
+ *     void my_module::init(mesh& domain) { _face_data = make_module_data_slab<data>(domain); }
+ *     void my_module::run(mesh_elem& face) { _face_data[face].acc += 1; }
+ * @endcode
+ */
+template<typename T>
+class module_data_slab
+{
+  public:
+    module_data_slab() = default;
+
+    /**
+     * @param nfaces Number of locally owned faces
+     */
+    explicit module_data_slab(size_t nfaces) : _data(nfaces) {}
+
+    /**
+     * Data of a locally owned face. Only checked if SAFE_CHECKS is defined.
+     * @param face
+     * @return
+     */
+    T& operator[](const mesh_elem& face)
+    {
+#ifdef SAFE_CHECKS
+        if (face->is_ghost || face->cell_local_id >= _data.size())
+            BOOST_THROW_EXCEPTION(module_error() << errstr_info("No module data for face " +
+                                                               std::to_string(face->cell_global_id) + "."));
+#endif
+        return _data[face->cell_local_id];
+    }
+
+    /**
+     * Data of the face domain->face(i). No checks are done.
+     * @param i
+     * @return
+     */
+    T& operator[](const size_t& i)
+    {
+        return _data[i];
+    }
+
+    size_t size() const { return _data.size(); }
+    T* data() { return _data.data(); }
+    typename std::vector<T>::iterator begin() { return _data.begin(); }
+    typename std::vector<T>::iterator end() { return _data.end(); }
+
+    /**
+     * Writes one member of every face's data as a checkpoint column
+     * @param chkpt
+     * @param var Checkpoint variable name, e.g., module:member
+     * @param member e.g., &data::acc
+     */
+    template<typename M>
+    void checkpoint(netcdf& chkpt, const std::string& var, M T::*member) const
+    {
+        chkpt.put_column(var, _data.size(), [&](size_t i) { return static_cast<double>(_data[i].*member); });
+    }
+
+    /**
+     * Reads one member of every face's data from a checkpoint column written by checkpoint
+     * @param chkpt
+     * @param var
+     * @param member
+     */
+    template<typename M>
+    void load_checkpoint(netcdf& chkpt, const std::string& var, M T::*member)
+    {
+        chkpt.get_column(var, _data.size(), [&](size_t i, double v) { _data.at(i).*member = static_cast<M>(v); });
+    }
+
+  private:
+    std::vector<T> _data;
+};
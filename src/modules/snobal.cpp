@@ -505,78 +505,55 @@ void snobal::run(mesh_elem &face)
 
 void snobal::checkpoint(mesh& domain,  netcdf& chkpt)
 {
-
-    chkpt.create_variable1D("snobal:m_s",domain->size_faces());
-    chkpt.create_variable1D("snobal:rho",domain->size_faces());
-    chkpt.create_variable1D("snobal:T_s",domain->size_faces());
-    chkpt.create_variable1D("snobal:T_s_0",domain->size_faces());
-    chkpt.create_variable1D("snobal:T_s_l",domain->size_faces());
-    chkpt.create_variable1D("snobal:z_s",domain->size_faces());
-    chkpt.create_variable1D("snobal:h2o_sat",domain->size_faces());
-    chkpt.create_variable1D("snobal:max_h2o_vol",domain->size_faces());
-    chkpt.create_variable1D("snobal:sum_runoff",domain->size_faces());
-    chkpt.create_variable1D("snobal:sum_melt",domain->size_faces());
-    chkpt.create_variable1D("snobal:sum_pcp_sno",domain->size_faces());
-    chkpt.create_variable1D("snobal:sum_subl",domain->size_faces());
-    chkpt.create_variable1D("snobal:E_s_sum",domain->size_faces());
-    chkpt.create_variable1D("snobal:melt_sum",domain->size_faces());
-    chkpt.create_variable1D("snobal:ro_pred_sum",domain->size_faces());
-    chkpt.create_variable1D("snobal:h2o_total",domain->size_faces());
-
-//netcdf puts are not threadsafe.
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        auto& g = face->get_module_data<snodata>(ID);
-        auto *sbal = &(g.data);
-
-        chkpt.put_var1D("snobal:m_s",i,sbal->m_s);
-        chkpt.put_var1D("snobal:rho",i,sbal->rho);
-        chkpt.put_var1D("snobal:T_s",i,sbal->T_s);
-        chkpt.put_var1D("snobal:T_s_0",i,sbal->T_s_0);
-        chkpt.put_var1D("snobal:T_s_l",i,sbal->T_s_l);
-        chkpt.put_var1D("snobal:z_s",i, sbal->z_s);
-        chkpt.put_var1D("snobal:h2o_sat",i,sbal->h2o_sat);
-        chkpt.put_var1D("snobal:max_h2o_vol",i,sbal->max_h2o_vol);
-
-        chkpt.put_var1D("snobal:sum_runoff",i,g.sum_runoff);
-        chkpt.put_var1D("snobal:sum_melt",i,g.sum_melt);
-        chkpt.put_var1D("snobal:sum_subl",i,g.sum_subl);
-        chkpt.put_var1D("snobal:sum_pcp_sno",i,g.sum_pcp_sno);
-        chkpt.put_var1D("snobal:E_s_sum",i,sbal->E_s_sum);
-        chkpt.put_var1D("snobal:melt_sum",i,sbal->melt_sum);
-        chkpt.put_var1D("snobal:ro_pred_sum",i,sbal->ro_pred_sum);
-        chkpt.put_var1D("snobal:h2o_total",i,sbal->h2o_total);
-    }
-
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> snodata& { return domain->face(i)->get_module_data<snodata>(ID); };
+
+    chkpt.put_column("snobal:m_s", n, [&](size_t i) { return face_data(i).data.m_s; });
+    chkpt.put_column("snobal:rho", n, [&](size_t i) { return face_data(i).data.rho; });
+    chkpt.put_column("snobal:T_s", n, [&](size_t i) { return face_data(i).data.T_s; });
+    chkpt.put_column("snobal:T_s_0", n, [&](size_t i) { return face_data(i).data.T_s_0; });
+    chkpt.put_column("snobal:T_s_l", n, [&](size_t i) { return face_data(i).data.T_s_l; });
+    chkpt.put_column("snobal:z_s", n, [&](size_t i) { return face_data(i).data.z_s; });
+    chkpt.put_column("snobal:h2o_sat", n, [&](size_t i) { return face_data(i).data.h2o_sat; });
+    chkpt.put_column("snobal:max_h2o_vol", n, [&](size_t i) { return face_data(i).data.max_h2o_vol; });
+    chkpt.put_column("snobal:sum_runoff", n, [&](size_t i) { return face_data(i).sum_runoff; });
+    chkpt.put_column("snobal:sum_melt", n, [&](size_t i) { return face_data(i).sum_melt; });
+    chkpt.put_column("snobal:sum_subl", n, [&](size_t i) { return face_data(i).sum_subl; });
+    chkpt.put_column("snobal:sum_pcp_sno", n, [&](size_t i) { return face_data(i).sum_pcp_sno; });
+    chkpt.put_column("snobal:E_s_sum", n, [&](size_t i) { return face_data(i).data.E_s_sum; });
+    chkpt.put_column("snobal:melt_sum", n, [&](size_t i) { return face_data(i).data.melt_sum; });
+    chkpt.put_column("snobal:ro_pred_sum", n, [&](size_t i) { return face_data(i).data.ro_pred_sum; });
+    chkpt.put_column("snobal:h2o_total", n, [&](size_t i) { return face_data(i).data.h2o_total; });
 }
 
 void snobal::load_checkpoint(mesh& domain, netcdf& chkpt)
 {
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> snodata& { return domain->face(i)->get_module_data<snodata>(ID); };
+
+    chkpt.get_column("snobal:m_s", n, [&](size_t i, double v) { face_data(i).data.m_s = v; });
+    chkpt.get_column("snobal:rho", n, [&](size_t i, double v) { face_data(i).data.rho = v; });
+    chkpt.get_column("snobal:T_s", n, [&](size_t i, double v) { face_data(i).data.T_s = v; });
+    chkpt.get_column("snobal:T_s_0", n, [&](size_t i, double v) { face_data(i).data.T_s_0 = v; });
+    chkpt.get_column("snobal:T_s_l", n, [&](size_t i, double v) { face_data(i).data.T_s_l = v; });
+    chkpt.get_column("snobal:z_s", n, [&](size_t i, double v) { face_data(i).data.z_s = v; });
+    chkpt.get_column("snobal:h2o_sat", n, [&](size_t i, double v) { face_data(i).data.h2o_sat = v; });
+    chkpt.get_column("snobal:max_h2o_vol", n, [&](size_t i, double v) { face_data(i).data.max_h2o_vol = v; });
+    chkpt.get_column("snobal:sum_runoff", n, [&](size_t i, double v) { face_data(i).sum_runoff = v; });
+    chkpt.get_column("snobal:sum_melt", n, [&](size_t i, double v) { face_data(i).sum_melt = v; });
+    chkpt.get_column("snobal:sum_subl", n, [&](size_t i, double v) { face_data(i).sum_subl = v; });
+    chkpt.get_column("snobal:sum_pcp_sno", n, [&](size_t i, double v) { face_data(i).sum_pcp_sno = v; });
+    chkpt.get_column("snobal:E_s_sum", n, [&](size_t i, double v) { face_data(i).data.E_s_sum = v; });
+    chkpt.get_column("snobal:melt_sum", n, [&](size_t i, double v) { face_data(i).data.melt_sum = v; });
+    chkpt.get_column("snobal:ro_pred_sum", n, [&](size_t i, double v) { face_data(i).data.ro_pred_sum = v; });
+    chkpt.get_column("snobal:h2o_total", n, [&](size_t i, double v) { face_data(i).data.h2o_total = v; });
+
     for (size_t i = 0; i < domain->size_faces(); i++)
     {
         auto face = domain->face(i);
         auto& g = face->get_module_data<snodata>(ID);
         auto *sbal = &(g.data);
 
-        sbal->m_s = chkpt.get_var1D("snobal:m_s",i);
-        sbal->rho = chkpt.get_var1D("snobal:rho",i);
-        sbal->T_s = chkpt.get_var1D("snobal:T_s",i);
-        sbal->T_s_0 = chkpt.get_var1D("snobal:T_s_0",i);
-        sbal->T_s_l = chkpt.get_var1D("snobal:T_s_l",i);
-        sbal->z_s =  chkpt.get_var1D("snobal:z_s",i);
-        sbal->h2o_sat =  chkpt.get_var1D("snobal:h2o_sat",i);
-        sbal->max_h2o_vol = chkpt.get_var1D("snobal:max_h2o_vol",i);
-
-        g.sum_runoff = chkpt.get_var1D("snobal:sum_runoff",i);
-        g.sum_melt = chkpt.get_var1D("snobal:sum_melt",i);
-        g.sum_subl = chkpt.get_var1D("snobal:sum_subl",i);
-        g.sum_pcp_sno = chkpt.get_var1D("snobal:sum_pcp_sno",i);
-        sbal->E_s_sum = chkpt.get_var1D("snobal:E_s_sum",i);
-        sbal->melt_sum = chkpt.get_var1D("snobal:melt_sum",i);
-        sbal->ro_pred_sum = chkpt.get_var1D("snobal:ro_pred_sum",i);
-        sbal->h2o_total = chkpt.get_var1D("snobal:h2o_total",i);
-
         sbal->init_snow();
 
         (*face)["dead"_s]=g.dead;
@@ -58,52 +58,48 @@ snow_slide::~snow_slide()
 
 void snow_slide::checkpoint(mesh& domain,  netcdf& chkpt)
 {
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> data& { return domain->face(i)->get_module_data<data>(ID); };
 
-    chkpt.create_variable1D("snow_slide:delta_avalanche_snowdepth", domain->size_faces());
-    chkpt.create_variable1D("snow_slide:delta_avalanche_mass", domain->size_faces());
-
-    chkpt.create_variable1D("snow_slide:delta_avalanche_snowdepth_sum", domain->size_faces());
-    chkpt.create_variable1D("snow_slide:delta_avalanche_mass_sum", domain->size_faces());
-
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        chkpt.put_var1D("snow_slide:delta_avalanche_snowdepth",i,face->get_module_data<data>(ID).delta_avalanche_snowdepth);
-        chkpt.put_var1D("snow_slide:delta_avalanche_mass",i,face->get_module_data<data>(ID).delta_avalanche_mass);
-
-        chkpt.put_var1D("snow_slide:delta_avalanche_snowdepth_sum",i,  (*face)["delta_avalanche_snowdepth_sum"_s]);
-        chkpt.put_var1D("snow_slide:delta_avalanche_mass_sum",i, (*face)["delta_avalanche_mass_sum"_s]);
-
-    }
+    chkpt.put_column("snow_slide:delta_avalanche_snowdepth", n, [&](size_t i) { return face_data(i).delta_avalanche_snowdepth; });
+    chkpt.put_column("snow_slide:delta_avalanche_mass", n, [&](size_t i) { return face_data(i).delta_avalanche_mass; });
+    chkpt.put_column("snow_slide:delta_avalanche_snowdepth_sum", n, [&](size_t i) { return (*domain->face(i))["delta_avalanche_snowdepth_sum"_s]; });
+    chkpt.put_column("snow_slide:delta_avalanche_mass_sum", n, [&](size_t i) { return (*domain->face(i))["delta_avalanche_mass_sum"_s]; });
 }
 
 void snow_slide::load_checkpoint(mesh& domain,  netcdf& chkpt)
 {
-    for (size_t i = 0; i < domain->size_faces(); i++)
-    {
-        auto face = domain->face(i);
-        face->get_module_data<data>(ID).delta_avalanche_snowdepth = chkpt.get_var1D("snow_slide:delta_avalanche_snowdepth",i);
-        face->get_module_data<data>(ID).delta_avalanche_mass = chkpt.get_var1D("snow_slide:delta_avalanche_mass",i);
+    size_t n = domain->size_faces();
+    auto face_data = [&](size_t i) -> data& { return domain->face(i)->get_module_data<data>(ID); };
 
-        (*face)["delta_avalanche_snowdepth_sum"_s] = chkpt.get_var1D("snow_slide:delta_avalanche_snowdepth_sum",i);
-        (*face)["delta_avalanche_mass_sum"_s] = chkpt.get_var1D("snow_slide:delta_avalanche_mass_sum",i);
-
-    }
+    chkpt.get_column("snow_slide:delta_avalanche_snowdepth", n, [&](size_t i, double v) { face_data(i).delta_avalanche_snowdepth = v; });
+    chkpt.get_column("snow_slide:delta_avalanche_mass", n, [&](size_t i, double v) { face_data(i).delta_avalanche_mass = v; });
+    chkpt.get_column("snow_slide:delta_avalanche_snowdepth_sum", n, [&](size_t i, double v) { (*domain->face(i))["delta_avalanche_snowdepth_sum"_s] = v; });
+    chkpt.get_column("snow_slide:delta_avalanche_mass_sum", n, [&](size_t i, double v) { (*domain->face(i))["delta_avalanche_mass_sum"_s] = v; });
 }
 
 void snow_slide::run(mesh& domain)
 {
+    // ghost transfer columns, zeroed wholesale each iteration instead of per face and per ghost neighbour
+    auto snowdepthavg_to_xfer = domain->variable_column("ghost_ss_snowdepthavg_to_xfer"_s);
+    auto swe_to_xfer = domain->variable_column("ghost_ss_swe_to_xfer"_s);
+    auto xfer_delta_snowdepth = domain->variable_column("ghost_ss_delta_avalanche_snowdepth"_s);
+    auto xfer_delta_swe = domain->variable_column("ghost_ss_delta_avalanche_swe"_s);
+
+    // snow surface (elevation + vertical snowdepth), which orders the transport from highest to lowest
+    auto surface = [](mesh_elem& face, snow_slide::data& d)
+    {
+        return face->center().z() + d.snowdepthavg_vert_copy;
+    };
+
+    // Faces over their holding capacity. Only these, and the faces they route snow to, are ever visited.
+    tbb::concurrent_vector<size_t> unstable;
 
     int done = 1; // int because we run a global reduce on it to determine a min global state
 
     int iterations = 0; // number of iterations we've run
     do
     {
-
-        int this_iter_moved_snow = false;
-        // Make a vector of pairs (elevation + snowdepth, pointer to face)
-        tbb::concurrent_vector<std::pair<double, mesh_elem>> sorted_z(domain->size_faces());
-
         // only init these on the first iteration
         if(iterations ==0)
         {
@@ -123,50 +119,22 @@ void snow_slide::run(mesh& domain)
                     data.delta_avalanche_snowdepth = 0.0;
                     data.delta_avalanche_mass = 0.0; // m
 
+                    if (data.snowdepthavg_copy > data.maxDepth)
+                        unstable.push_back(i);
             }
         }
 
-
-        //#ifdef USE_MPI
-//        // update our ghosts from other ranks values
-////        // first iteration this will be 0
-////        domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_to_xfer"_s);
-//        domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_vert_copy"_s);
-//#endif
+        // Use these placeholders to store the copy as we can then access it on the neighbours
+        std::fill(snowdepthavg_to_xfer.begin(), snowdepthavg_to_xfer.end(), 0);
+        std::fill(swe_to_xfer.begin(), swe_to_xfer.end(), 0);
+        std::fill(xfer_delta_snowdepth.begin(), xfer_delta_snowdepth.end(), 0);
+        std::fill(xfer_delta_swe.begin(), xfer_delta_swe.end(), 0);
 
 #pragma omp parallel for
         for (size_t i = 0; i < domain->size_faces(); i++)
         {
-            auto face = domain->face(i); // Get face
-            auto& data = face->get_module_data<snow_slide::data>(ID); // Get data
-
-            // Use these placeholders to store the copy as we can then access it on the neighbours
-            // vert missing as we can reconstruct it easily
-            (*face)["ghost_ss_snowdepthavg_to_xfer"] = 0; // snowdepth to transfer this timestep
-            (*face)["ghost_ss_swe_to_xfer"] = 0;
-
-            (*face)["ghost_ss_snowdepthavg_vert_copy"] = data.snowdepthavg_vert_copy;
-            (*face)["ghost_ss_delta_avalanche_snowdepth"] = 0;
-            (*face)["ghost_ss_delta_avalanche_swe"] = 0;
-
-            for (int j = 0; j < 3; ++j)
-            {
-                auto n = face->neighbor(j);
-                if (n!=nullptr && n->is_ghost)
-                {
-                    #pragma omp critical
-                    {
-                        (*n)["ghost_ss_snowdepthavg_to_xfer"] = 0;
-                        (*n)["ghost_ss_swe_to_xfer"] = 0;
-                        (*n)["ghost_ss_delta_avalanche_snowdepth"] = 0;
-                        (*n)["ghost_ss_delta_avalanche_swe"] = 0;
-                    }
-                }
-            }
-
-            sorted_z.at(i) = std::make_pair(
-                face->center().z() + data.snowdepthavg_vert_copy, face);
-
+            auto face = domain->face(i);
+            (*face)["ghost_ss_snowdepthavg_vert_copy"_s] = face->get_module_data<snow_slide::data>(ID).snowdepthavg_vert_copy;
         }
 
 #ifdef USE_MPI
@@ -174,160 +142,177 @@ void snow_slide::run(mesh& domain)
         domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_vert_copy"_s);
 #endif
 
-        // Sort faces by elevation + snowdepth
-        tbb::parallel_sort(sorted_z.begin(), sorted_z.end(),
-                           [](const std::pair<double, mesh_elem>& a, const std::pair<double, mesh_elem>& b)
-                           { return b.first < a.first; });
+        // max-heap on the snow surface. Entries are (surface when queued, face index). A face that receives snow
+        // while queued is pushed again with its new surface, so an entry that no longer matches is stale.
+        std::priority_queue<std::pair<double, size_t>> queue;
+        for (auto i : unstable)
+        {
+            auto face = domain->face(i);
+            queue.emplace(surface(face, face->get_module_data<snow_slide::data>(ID)), i);
+        }
+        unstable.clear();
+
+        // mass always moves downhill so this terminates, but guard against a pathological mesh
+        const size_t max_events = 100 * domain->size_faces();
+        size_t events = 0;
 
-        // Loop through each face, from highest to lowest triangle surface
-        for (size_t i = 0; i < sorted_z.size(); i++)
+        // Process faces from highest to lowest snow surface
+        while (!queue.empty())
         {
-            auto face = sorted_z[i].second;                           // Get pointer to face
-            double cen_area = face->get_area();                       // Area of center triangle
+            auto top = queue.top();
+            queue.pop();
+
+            auto face = domain->face(top.second);                    // Get pointer to face
             auto& data = face->get_module_data<snow_slide::data>(ID); // Get stored data for face
 
-            // Get current triangle snow info at beginning of time step
+            // stale, or already brought back under capacity
+            if (top.first != surface(face, data) || data.snowdepthavg_copy <= data.maxDepth)
+                continue;
+
+            if (++events > max_events)
+            {
+                LOG_ERROR << "SnowSlide did not settle after " << max_events << " transport events";
+                break;
+            }
+
+            double cen_area = face->get_area();                       // Area of center triangle
+
+            // Get current triangle snow info
             double maxDepth = data.maxDepth;
 
             double snowdepthavg = data.snowdepthavg_copy;           // m - Snow depth perpendicular to the surface
             double snowdepthavg_vert = data.snowdepthavg_vert_copy; // m - Vertical snow depth
             double swe = data.swe_copy;                             // m
 
-            // Check if face normal snowdepth have exceeded normal maxDepth
-            if ( snowdepthavg > maxDepth)
-            {
-                done = 0;
-                this_iter_moved_snow = true;
+            double del_depth = snowdepthavg - maxDepth;           // Amount to be removed (positive) [m]
+            double del_swe = swe * (1 - maxDepth / snowdepthavg); // Amount of swe to be removed (positive) [m]
+            double orig_mass = del_swe * cen_area;
 
-                double del_depth = snowdepthavg - maxDepth;           // Amount to be removed (positive) [m]
-                double del_swe = swe * (1 - maxDepth / snowdepthavg); // Amount of swe to be removed (positive) [m]
-                double orig_mass = del_swe * cen_area;
+            double z_s = face->center().z() + snowdepthavg_vert; // Current face elevation + vertical snowdepth
+            std::vector<double> w = {0, 0, 0};                   // Weights for each face neighbor to route snow to
+            double w_dem = 0;                                    // Denomenator for weights (sum of all elev diffs)
 
-                double z_s = face->center().z() + snowdepthavg_vert; // Current face elevation + vertical snowdepth
-                std::vector<double> w = {0, 0, 0};                   // Weights for each face neighbor to route snow to
-                double w_dem = 0;                                    // Denomenator for weights (sum of all elev diffs)
 
+            // Calc weights for routing snow
+            // Possible Cases:
+            //      1) edge cell, then edge_flag is true, and snow is dumped off mesh
+            //      2) non-edge cell, w_dem is greater than 0 -> there is at least one lower neighbor, route so to it/them 3) non-edge cell, w_dem = 0, "sink" case. Don't route any snow.
+            // Calc weighting based on height diff
+            // std::max insures that if one neighbor is higher, its weight will be zero
+            for (int i = 0; i < 3; ++i)
+            {
+                auto n = face->neighbor(i); // Pointer to neighbor face
 
-                // Calc weights for routing snow
-                // Possible Cases:
-                //      1) edge cell, then edge_flag is true, and snow is dumped off mesh
-                //      2) non-edge cell, w_dem is greater than 0 -> there is at least one lower neighbor, route so to it/them 3) non-edge cell, w_dem = 0, "sink" case. Don't route any snow.
-                // Calc weighting based on height diff
-                // std::max insures that if one neighbor is higher, its weight will be zero
-                for (int i = 0; i < 3; ++i)
+                // this is a domain edge
+                if (n == nullptr)
                 {
-                    auto n = face->neighbor(i); // Pointer to neighbor face
-
-                    // this is a domain edge
-                    if (n == nullptr)
-                    {
-                        // pretend our missing face has the same elevation as us, but has no snow so it take can some transport
-                        w[i] = std::max(0.0, z_s - face->center().z());
+                    // pretend our missing face has the same elevation as us, but has no snow so it take can some transport
+                    w[i] = std::max(0.0, z_s - face->center().z());
 
-                    }
-                    else if (n->is_ghost)
-                    {
-                        w[i] = std::max(0.0, z_s - (n->center().z() + (*n)["ghost_ss_snowdepthavg_vert_copy"_s]));
-                    }
-                    // Only non-ghost will have these
-                    else
-                    {
-                        auto& n_data = n->get_module_data<snow_slide::data>(ID); // pointer to face's data
-                        w[i] = std::max(0.0, z_s - (n->center().z() + n_data.snowdepthavg_vert_copy));
-                    }
-                    w_dem += w[i]; // Store weight denominator
                 }
-
-                // Case 2) Non-Edge cell, but w_dem=0, "sink" cell. Don't route snow.
-                if (w_dem == 0)
+                else if (n->is_ghost)
                 {
-                    continue; // Restart to next iteration.
+                    w[i] = std::max(0.0, z_s - (n->center().z() + (*n)["ghost_ss_snowdepthavg_vert_copy"_s]));
                 }
-
-                // Must be Case 3), Divide by sum height differences to create weights that sum to unity
-                if (w_dem != 0)
+                // Only non-ghost will have these
+                else
                 {
-                    std::transform(w.begin(), w.end(), w.begin(), [w_dem](double cw) { return cw / w_dem; });
+                    auto& n_data = n->get_module_data<snow_slide::data>(ID); // pointer to face's data
+                    w[i] = std::max(0.0, z_s - (n->center().z() + n_data.snowdepthavg_vert_copy));
                 }
+                w_dem += w[i]; // Store weight denominator
+            }
+
+            // Case 2) Non-Edge cell, but w_dem=0, "sink" cell. Don't route snow.
+            if (w_dem == 0)
+            {
+                continue; // Restart to next iteration.
+            }
 
-                // Case 3), Non-Edge cell, w_dem>0, route snow to down slope neighbor(s).
-                double out_mass = 0; // Mass balance check
-                // Route snow to each neighbor based on weights
-                for (int j = 0; j < 3; ++j)
+            // Must be Case 3), Divide by sum height differences to create weights that sum to unity
+            std::transform(w.begin(), w.end(), w.begin(), [w_dem](double cw) { return cw / w_dem; });
+
+            // Case 3), Non-Edge cell, w_dem>0, route snow to down slope neighbor(s).
+            double out_mass = 0; // Mass balance check
+            // Route snow to each neighbor based on weights
+            for (int j = 0; j < 3; ++j)
+            {
+                auto n = face->neighbor(j);
+                if (n == nullptr)
                 {
-                    auto n = face->neighbor(j);
-                    if (n == nullptr)
+                    // Special case: dump snow out of domain (loosing mass) by just removing from current edge cell.
+                    out_mass += del_swe * cen_area * w[j];
+                }
+                else //move the mass to a non domain edge neighbour triangle
+                {
+                    double n_area = n->get_area(); // Area of neighbor triangle
+
+                    double delta_sd_avg = del_depth * (cen_area / n_area) * w[j]; // (m)
+                    double delta_swe = del_swe * (cen_area / n_area) * w[j]; // (m)
+
+                    // Fraction of snowdepth (m) *center triangle area (m^2) = volume of snow depth (m^3)
+                    double delta_sd_avg_m3 = del_depth * cen_area * w[j]; // (m3)
+                    double delta_swe_m3 = del_swe * cen_area * w[j]; // (m3)
+
+                    if (n->is_ghost)
                     {
-                        // Special case: dump snow out of domain (loosing mass) by just removing from current edge cell.
-                        out_mass += del_swe * cen_area * w[j];
+                        // amounts to move to ghosts. SD Vert is calculated for normal sd
+                        (*n)["ghost_ss_snowdepthavg_to_xfer"_s] += delta_sd_avg;
+                        (*n)["ghost_ss_swe_to_xfer"_s] += delta_swe;
+
+                        (*n)["ghost_ss_delta_avalanche_snowdepth"_s] += delta_sd_avg_m3;
+                        (*n)["ghost_ss_delta_avalanche_swe"_s] += delta_swe_m3;
                     }
-                    else //move the mass to a non domain edge neighbour triangle
+                    else
                     {
-                        double n_area = n->get_area(); // Area of neighbor triangle
-
-                        double delta_sd_avg = del_depth * (cen_area / n_area) * w[j]; // (m)
-                        double delta_swe = del_swe * (cen_area / n_area) * w[j]; // (m)
-
-                        // Fraction of snowdepth (m) *center triangle area (m^2) = volume of snow depth (m^3)
-                        double delta_sd_avg_m3 = del_depth * cen_area * w[j]; // (m3)
-                        double delta_swe_m3 = del_swe * cen_area * w[j]; // (m3)
-
-                        if (n->is_ghost)
-                        {
-                            // amounts to move to ghosts. SD Vert is calculated for normal sd
-                            (*n)["ghost_ss_snowdepthavg_to_xfer"_s] += delta_sd_avg;
-                            (*n)["ghost_ss_swe_to_xfer"_s] += delta_swe;
-
-                            (*n)["ghost_ss_delta_avalanche_snowdepth"] += delta_sd_avg_m3;
-                            (*n)["ghost_ss_delta_avalanche_swe"] += delta_swe_m3;
-                        }
-                        else
-                        {
-                            auto& n_data = n->get_module_data<snow_slide::data>(ID); // pointer to face's data
-
-                            // Update neighbor snowdepth and swe (copies only for internal snowSlide use)
-                            // Here we must make an assumption of the pack density (because we do not have access to
-                            // layer information (if exists (i.e. snowpack is running), or it doesn't
-                            // (i.e. snobal is running)) Therefore, we assume uniform density. The (cen_area/n_area)
-                            // term converts depth change from orig cell to volume, then back to a depth term using
-                            // the neighbor's area.
-                            n_data.snowdepthavg_copy += delta_sd_avg; // (m)
-                            n_data.swe_copy += delta_swe;            // (m)
-                            // Update vertical snow depth
-                            n_data.snowdepthavg_vert_copy = n_data.snowdepthavg_copy / std::max(0.001, cos(face->slope()));
-
-                            // Update mass transport to neighbor
-                            // Fraction of snowdepth (m) *center triangle area (m^2) = volune of snow depth (m^3)
-                            n_data.delta_avalanche_snowdepth += delta_sd_avg_m3;
-                            n_data.delta_avalanche_mass += delta_swe_m3; // (m) * (m^2) = (m^3) of swe
-                          }
-
-
-                        out_mass += del_swe * cen_area * w[j];
+                        auto& n_data = n->get_module_data<snow_slide::data>(ID); // pointer to face's data
+
+                        // Update neighbor snowdepth and swe (copies only for internal snowSlide use)
+                        // Here we must make an assumption of the pack density (because we do not have access to
+                        // layer information (if exists (i.e. snowpack is running), or it doesn't
+                        // (i.e. snobal is running)) Therefore, we assume uniform density. The (cen_area/n_area)
+                        // term converts depth change from orig cell to volume, then back to a depth term using
+                        // the neighbor's area.
+                        n_data.snowdepthavg_copy += delta_sd_avg; // (m)
+                        n_data.swe_copy += delta_swe;            // (m)
+                        // Update vertical snow depth
+                        n_data.snowdepthavg_vert_copy = n_data.snowdepthavg_copy / std::max(0.001, cos(face->slope()));
+
+                        // Update mass transport to neighbor
+                        // Fraction of snowdepth (m) *center triangle area (m^2) = volune of snow depth (m^3)
+                        n_data.delta_avalanche_snowdepth += delta_sd_avg_m3;
+                        n_data.delta_avalanche_mass += delta_swe_m3; // (m) * (m^2) = (m^3) of swe
+
+                        // the receiver may now be over capacity itself
+                        if (n_data.snowdepthavg_copy > n_data.maxDepth)
+                            queue.emplace(surface(n, n_data), n->cell_local_id);
                     }
 
+
+                    out_mass += del_swe * cen_area * w[j];
                 }
-                // Remove snow from initial face
-                // here we are using the snowmodel normal depth and then covert it to a vert equivalent
-                data.snowdepthavg_copy = maxDepth; // data refers to current/center cell
-                data.snowdepthavg_vert_copy = data.snowdepthavg_copy / std::max(0.001, cos(face->slope()));
-                data.swe_copy = swe * maxDepth / snowdepthavg; // Uses ratio of depth change to calc new swe
-                // This relies on the assumption of uniform density.
-
-                // Update mass transport (m^3)
-                data.delta_avalanche_snowdepth -= del_depth * cen_area;
-                data.delta_avalanche_mass -= del_swe * cen_area;
-
-                // Check mass transport balances for current avalanche cell
-                if (std::abs(orig_mass - out_mass) > 0.0001)
-                {
-                    LOG_ERROR << "Moved mass total is " << out_mass;
-                    LOG_ERROR << "diff = " << orig_mass - out_mass;
-                    LOG_ERROR << "Mass balance of avalanche times step was not conserved.";
-                    CHM_THROW_EXCEPTION(module_error, "Snowslide did not conserve mass");
-                }
-            } // end if snowdepth > maxdepth
-        } // End of each face
+
+            }
+            // Remove snow from initial face
+            // here we are using the snowmodel normal depth and then covert it to a vert equivalent
+            data.snowdepthavg_copy = maxDepth; // data refers to current/center cell
+            data.snowdepthavg_vert_copy = data.snowdepthavg_copy / std::max(0.001, cos(face->slope()));
+            data.swe_copy = swe * maxDepth / snowdepthavg; // Uses ratio of depth change to calc new swe
+            // This relies on the assumption of uniform density.
+
+            // Update mass transport (m^3)
+            data.delta_avalanche_snowdepth -= del_depth * cen_area;
+            data.delta_avalanche_mass -= del_swe * cen_area;
+
+            // Check mass transport balances for current avalanche cell
+            if (std::abs(orig_mass - out_mass) > 0.0001)
+            {
+                LOG_ERROR << "Moved mass total is " << out_mass;
+                LOG_ERROR << "diff = " << orig_mass - out_mass;
+                LOG_ERROR << "Mass balance of avalanche times step was not conserved.";
+                CHM_THROW_EXCEPTION(module_error, "Snowslide did not conserve mass");
+            }
+        } // End of queue
 
 #ifdef USE_MPI
         // At this point we've set values on the our ghost faces. These correspond with actual faces on other ranks
@@ -341,27 +326,28 @@ void snow_slide::run(mesh& domain)
 
 
         size_t ghost_transport = 0;
-        #pragma omp parallel for
+        #pragma omp parallel for reduction(+:ghost_transport)
         for (size_t i = 0; i < domain->size_faces(); i++)
         {
             auto face = domain->face(i); // Get face                        // Get pointer to face
             auto& data = face->get_module_data<snow_slide::data>(ID); // Get stored data for face
 
             // these will be != on the triangles owned as ghosts by another rank
-            data.snowdepthavg_copy += (*face)["ghost_ss_snowdepthavg_to_xfer"];
-            data.snowdepthavg_vert_copy += (*face)["ghost_ss_snowdepthavg_to_xfer"] / std::max(0.001, cos(face->slope()));
-            data.swe_copy += (*face)["ghost_ss_swe_to_xfer"_s];
+            data.snowdepthavg_copy += snowdepthavg_to_xfer[i];
+            data.snowdepthavg_vert_copy += snowdepthavg_to_xfer[i] / std::max(0.001, cos(face->slope()));
+            data.swe_copy += swe_to_xfer[i];
 
-            data.delta_avalanche_snowdepth += (*face)["ghost_ss_delta_avalanche_snowdepth"_s];
-            data.delta_avalanche_mass += (*face)["ghost_ss_delta_avalanche_swe"_s]; // (m) * (m^2) = (m^3) of swe
+            data.delta_avalanche_snowdepth += xfer_delta_snowdepth[i];
+            data.delta_avalanche_mass += xfer_delta_swe[i]; // (m) * (m^2) = (m^3) of swe
 
-            if((*face)["ghost_ss_delta_avalanche_snowdepth"_s] > 0)
+            if(xfer_delta_snowdepth[i] > 0)
             {
-#pragma omp atomic
                 ++ghost_transport;
-            }
 
-            (*face)["ghost_ss_snowdepthavg_vert_copy"] = data.snowdepthavg_vert_copy;
+                // incoming snow from another rank may push us over capacity, handle it next iteration
+                if (data.snowdepthavg_copy > data.maxDepth)
+                    unstable.push_back(i);
+            }
 
             // Save state variables at end of time step
             (*face)["delta_avalanche_snowdepth"_s] = data.delta_avalanche_snowdepth;
@@ -372,9 +358,8 @@ void snow_slide::run(mesh& domain)
 
         }
 
-        // only do another iteration if we have incoming mass transport from the ghosts or if we have moved mass this itr
-        // this algorithm tends to need a couple passes to make sure there are no straglers
-        if(ghost_transport > 0) // || this_iter_moved_snow)
+        // only do another iteration if we have incoming mass transport from the ghosts
+        if(ghost_transport > 0)
             done = 0;
         else
             done = 1;
@@ -396,13 +381,6 @@ void snow_slide::run(mesh& domain)
             LOG_ERROR << "SnowSlide did not converge after 500 iterations";
         }
 
-#ifdef USE_MPI
-        if(!done)
-            // because we don't have access to ndata.snowdepthavg_copy, pass it through here
-            // only used for obtaining transport weights, but only do this comms if we are expecting another iter
-            domain->ghost_neighbors_communicate_variable("ghost_ss_snowdepthavg_vert_copy"_s);
-#endif
-
     }while(!done);
 
     LOG_DEBUG << "[SnowSlide] needed " << iterations << " iterations";
@@ -25,12 +25,13 @@
 
 #include <boost/shared_ptr.hpp>
 #include <tbb/concurrent_vector.h>
-#include <tbb/parallel_sort.h>
 #include "logger.hpp"
 #include "triangulation.hpp"
 #include "module_base.hpp"
 
 #include <string>
+#include <queue>
+#include <algorithm>
 
 /**
  * \ingroup modules snow
@@ -22,6 +22,10 @@
 //
 
 #include "solar.hpp"
+
+#include <algorithm>
+#include <numeric>
+
 REGISTER_MODULE_CPP(solar);
 
 solar::solar(config_file cfg)
@@ -36,35 +40,20 @@ solar::~solar()
 {
 
 }
-void solar::run(mesh_elem &face)
+solar::ephemeris solar::compute_ephemeris(boost::posix_time::ptime time, int utc_offset)
 {
-    double Lon = 0;
-    double Lat = 0;
-    if(global_param->is_geographic())
-    {
-        Lon = face->center().x();
-        Lat = face->center().y();
-    }
-    else{
-        auto& data = face->get_module_data<solar::data>(ID);
-        Lon = data.lng;
-        Lat = data.lat;
-    }
-
-
     //Following the RA DEC to Az Alt conversion sequence explained here:
     //http://www.stargazing.net/kepler/altaz.html
 
     //UTC offset. Don't know how to use datetime's UTC converter yet....
-    boost::posix_time::time_duration UTC_offset = boost::posix_time::hours(global_param->_utc_offset);
-    std::tm tm = boost::posix_time::to_tm(global_param->posix_time()+UTC_offset);
+    boost::posix_time::time_duration UTC_offset = boost::posix_time::hours(utc_offset);
+    std::tm tm = boost::posix_time::to_tm(time+UTC_offset);
     double year =  tm.tm_year + 1900.; //convert from epoch
     double month =  tm.tm_mon + 1.;//conert jan == 0
     double day =   tm.tm_mday; //starts at 1, ok
     double hour = tm.tm_hour; // 0 = midnight, ok
     double min = tm.tm_min; // 0, ok
     double sec = tm.tm_sec; // [0,60] in c++11, ok http://en.cppreference.com/w/cpp/chrono/c/tm
-    double Alt = face->center().z();//0.; //TODO: fix this?
 
     if (month <= 2.0)
     {
@@ -79,7 +68,6 @@ void solar::run(mesh_elem &face)
     double d = jd-2451543.5;
     // Keplerian Elements for the Sun (geocentric)
     double w = 282.9404+4.70935*pow(10,-5)*d; //    (longitude of perihelion degrees)
-    double a = 1.000000;          //    (mean distance, a.u.)
     double e = 0.016709- 1.151*pow(10.,-9.)*d;  //    (eccentricity)
     double M = fmod(356.0470+0.9856002585*d,360.0); //  (mean anomaly degrees)
     double L = w + M;                     //(Sun's mean longitude degrees)
@@ -111,39 +99,84 @@ void solar::run(mesh_elem &face)
     double yequat = yeclip*cos(oblecl*(M_PI/180.))+zeclip*sin(oblecl*(M_PI/180.));
     double zequat = yeclip*sin(23.4406*(M_PI/180.))+zeclip*cos(oblecl*(M_PI/180.));
 
-    //convert equatorial rectangular coordinates to RA and Decl:
-    r = sqrt(xequat*xequat + yequat*yequat + zequat*zequat)-(Alt/149598000.0); //roll up the altitude correction
-    double RA = atan2(yequat,xequat)*(180./M_PI);
-    double delta = asin(zequat/r)*(180./M_PI);
+    ephemeris eph;
 
-    //Find the J2000 value
-    double J2000 = jd - 2451545.0;
+    //convert equatorial rectangular coordinates to RA. Decl needs the per-point altitude correction
+    eph.r = sqrt(xequat*xequat + yequat*yequat + zequat*zequat);
+    eph.RA = atan2(yequat,xequat)*(180./M_PI);
+    eph.zequat = zequat;
 
-    double UTH = hour+min/60.0+sec/3600.0;   //Calculate local siderial time
+    double UTH = hour+min/60.0+sec/3600.0;   //Calculate local siderial time, less the Lon/15 term
     double GMST0=fmod(L+180.,360.)/15.;
-    double SIDTIME = GMST0 + UTH + Lon/15.;
-
-    //Replace RA with hour angle HA
-    double HA = (SIDTIME*15. - RA);
+    eph.sidtime = GMST0 + UTH;
 
-    //convert to rectangular coordinate system
-    x = cos(HA*(M_PI/180.))*cos(delta*(M_PI/180.));
-    y = sin(HA*(M_PI/180.))*cos(delta*(M_PI/180.));
-    double z = sin(delta*(M_PI/180.));
+    return eph;
+}
 
-    //rotate this along an axis going east-west.
-    double xhor = x*cos((90.-Lat)*(M_PI/180.))-z*sin((90.-Lat)*(M_PI/180.));
-    double yhor = y;
-    double zhor = x*sin((90.-Lat)*(M_PI/180.))+z*cos((90.-Lat)*(M_PI/180.));
+void solar::run(mesh_elem &face)
+{
+    // point mode only
+    auto eph = compute_ephemeris(global_param->posix_time(), global_param->_utc_offset);
 
-    //Find the h and AZ
-    double Az = atan2(yhor,xhor)*(180./M_PI) + 180.;
-    double El = asin(zhor)*(180./M_PI);
+    size_t i = face->cell_local_id;
+    double Az, El;
+    position(eph, _sin_lat[i], _cos_lat[i], _lon[i], _alt[i], Az, El);
 
     (*face)["solar_az"_s]=Az;
     (*face)["solar_el"_s]=El;
 
 }
+
+void solar::run(mesh& domain)
+{
+    auto eph = compute_ephemeris(global_param->posix_time(), global_param->_utc_offset);
+
+    auto az = domain->variable_column("solar_az"_s);
+    auto el = domain->variable_column("solar_el"_s);
+
+    const size_t n = _lon.size();
+    const double* sin_lat = _sin_lat.data();
+    const double* cos_lat = _cos_lat.data();
+    const double* lon = _lon.data();
+    const double* alt = _alt.data();
+    double* paz = az.data;
+    double* pel = el.data;
+
+    if(_centroid_hour_angle)
+    {
+        // hour angle and declination are fixed for the domain, so the sun's direction is one vector that is
+        // rotated into each face's horizon by latitude
+        double x, y, z;
+        {
+            double r = eph.r - (_centroid_alt / 149598000.0);
+            double sin_delta = eph.zequat / r;
+            double cos_delta = sqrt(1. - sin_delta * sin_delta);
+            double HA = (eph.sidtime * 15. + _centroid_lon - eph.RA) * (M_PI / 180.);
+
+            x = cos(HA) * cos_delta;
+            y = sin(HA) * cos_delta;
+            z = sin_delta;
+        }
+
+        #pragma omp parallel for simd
+        for (size_t i = 0; i < n; i++)
+        {
+            double xhor = x * sin_lat[i] - z * cos_lat[i];
+            double zhor = x * cos_lat[i] + z * sin_lat[i];
+
+            paz[i] = atan2(y, xhor) * (180. / M_PI) + 180.;
+            pel[i] = asin(zhor) * (180. / M_PI);
+        }
+        return;
+    }
+
+    #pragma omp parallel for simd
+    for (size_t i = 0; i < n; i++)
+    {
+        position(eph, sin_lat[i], cos_lat[i], lon[i], alt[i], paz[i], pel[i]);
+    }
+}
+
 void solar::init(mesh& domain)
 {
 
@@ -162,6 +195,11 @@ void solar::init(mesh& domain)
 
     bool svf_compute = cfg.get("svf.compute",true);
 
+    _sin_lat.resize(domain->size_faces());
+    _cos_lat.resize(domain->size_faces());
+    _lon.resize(domain->size_faces());
+    _alt.resize(domain->size_faces());
+
     #pragma omp parallel
     {
         OGRSpatialReference monUtm, monGeo;
@@ -186,23 +224,24 @@ void solar::init(mesh& domain)
 
             auto face = domain->face(i);
 
+            double x = face->center().x();
+            double y = face->center().y();
+
             // we are UTM and need to convert internally to lat long to calc the solar position
             if (!domain->is_geographic())
             {
-                double x = face->center().x();
-                double y = face->center().y();
-
                 // do the transform with the enforce x/y ordering
                 if(!coordTrans->Transform(1, &x, &y))
                 {
                     CHM_THROW_EXCEPTION(module_error,"Unable to covert face coordinates to lat long for solar rad calcuation.");
                 }
-
-                auto& d = face->make_module_data<solar::data>(ID);
-                d.lat = y;
-                d.lng = x;
             }
 
+            _sin_lat[i] = sin(y * M_PI / 180.);
+            _cos_lat[i] = cos(y * M_PI / 180.);
+            _lon[i] = x;
+            _alt[i] = face->center().z();
+
             double svf = 0.0;
 
             if (svf_compute)
@@ -215,13 +254,13 @@ void solar::init(mesh& domain)
                 for (int k = 0; k < N; k++)
                 {
                     double phi = 0.;
+                    mesh_elem f = face;
                     // search along each azimuth in j step increments to find horizon angle
                     for (int j = 1; j <= steps; ++j)
                     {
                         double distance = j * size_of_step;
 
-                        auto f =
-                            domain->find_closest_face(math::gis::point_from_bearing(me, k * azimuthal_width, distance));
+                        f = domain->find_face(math::gis::point_from_bearing(me, k * azimuthal_width, distance), f);
 
                         double z_diff = (f->center().z() - me.z());
                         if (z_diff > 0)
@@ -251,6 +290,35 @@ void solar::init(mesh& domain)
         OGRCoordinateTransformation::DestroyCT(coordTrans);
     }
 
+    _centroid_hour_angle = false;
+    _centroid_lon = 0;
+    _centroid_alt = 0;
+
+    double tolerance = cfg.get("hour_angle_tolerance", 0.0);
+    if (tolerance > 0 && !_lon.empty())
+    {
+        auto lon_range = std::minmax_element(_lon.begin(), _lon.end());
+
+        // the hour angle error at a face is its longitude offset from the centroid
+        double error = (*lon_range.second - *lon_range.first) / 2.0;
+        if (error <= tolerance)
+        {
+            _centroid_hour_angle = true;
+            _centroid_lon = (*lon_range.second + *lon_range.first) / 2.0;
+            _centroid_alt = std::accumulate(_alt.begin(), _alt.end(), 0.0) / _alt.size();
+            LOG_DEBUG << "solar: using the domain centroid hour angle, max error " << error << " deg";
+        }
+        else
+        {
+            LOG_DEBUG << "solar: domain is too wide for hour_angle_tolerance (" << error << " deg), using per-face hour angles";
+        }
+    }
+
+    // outside of point mode every face is done at once from the per timestep ephemeris
+    if (!global_param->is_point_mode())
+    {
+        _parallel_type = parallel::domain;
+    }
 
 
 }
@@ -26,6 +26,8 @@
 #include "module_base.hpp"
 #include <ogr_spatialref.h>
 
+#include <vector>
+
 
 /**
  * \ingroup modules iswr
@@ -33,6 +35,10 @@
  * \class solar
  * Calculates solar position
  *
+ * The time-only part of the ephemeris is computed once per timestep and the per-face part is a vectorized loop over
+ * the face coordinates. For small domains, ``hour_angle_tolerance`` allows the whole domain to use the hour angle and
+ * declination of the domain centroid, leaving only the latitude rotation per face.
+ *
  * **Depends:**
  * - None
  *
@@ -55,7 +61,8 @@
  *          "max_distance": 1000.0,
  *          "nsectors": 12,
  *          "compute": true
- *       }
+ *       },
+ *       "hour_angle_tolerance": 0
  *    }
  *
  * .. confval:: steps
@@ -84,6 +91,14 @@
  *
  *    Compute the sky view factor
  *
+ * .. confval:: hour_angle_tolerance
+ *
+ *    :type: double
+ *    :default: 0
+ *
+ *    Maximum error, in degrees, allowed in the hour angle (and thus the azimuth) by using the domain centroid's
+ *    hour angle for every face. The error is half the longitudinal extent of the domain. If the domain is wider than
+ *    this allows, every face uses its own hour angle. 0 disables.
  *
  * \endrst
  *
@@ -95,15 +110,75 @@ class solar : public module_base
 REGISTER_MODULE_HPP(solar);
 public:
 
-    //if we have a UTM mesh, cache the calculated lat and long
-    struct data : public face_info
+    /**
+     * Part of the solar position that only depends on time
+     */
+    struct ephemeris
     {
-        double lat;
-        double lng;
+        double RA; // right ascension [degrees]
+        double zequat; // equatorial z of the sun
+        double r; // distance to the sun [au], before the altitude correction
+        double sidtime; // siderial time at Greenwich [hours]
     };
 
+    /**
+     * Computes the time-only part of the solar position
+     * @param time Model time
+     * @param utc_offset Hours
+     * @return
+     */
+    static ephemeris compute_ephemeris(boost::posix_time::ptime time, int utc_offset);
+
+    /**
+     * Solar position for a point, given the ephemeris for the timestep
+     * @param eph
+     * @param sin_lat sine of latitude
+     * @param cos_lat cosine of latitude
+     * @param lon longitude [degrees]
+     * @param alt altitude [m]
+     * @param az solar azimuth [degrees]
+     * @param el solar elevation [degrees]
+     */
+    static inline void position(const ephemeris& eph, double sin_lat, double cos_lat, double lon, double alt,
+                                double& az, double& el)
+    {
+        //roll up the altitude correction
+        double r = eph.r - (alt / 149598000.0);
+        double sin_delta = eph.zequat / r;
+        double cos_delta = sqrt(1. - sin_delta * sin_delta);
+
+        //hour angle
+        double HA = (eph.sidtime * 15. + lon - eph.RA) * (M_PI / 180.);
+
+        //convert to rectangular coordinate system
+        double x = cos(HA) * cos_delta;
+        double y = sin(HA) * cos_delta;
+        double z = sin_delta;
+
+        //rotate this along an axis going east-west. cos(90-lat) = sin(lat)
+        double xhor = x * sin_lat - z * cos_lat;
+        double yhor = y;
+        double zhor = x * cos_lat + z * sin_lat;
+
+        az = atan2(yhor, xhor) * (180. / M_PI) + 180.;
+        el = asin(zhor) * (180. / M_PI);
+    }
+
     solar(config_file cfg);
     ~solar();
     void run(mesh_elem &face);
+    void run(mesh& domain);
     void init(mesh& domain);
+
+  private:
+    // per face, in face(i) order
+    std::vector<double> _sin_lat;
+    std::vector<double> _cos_lat;
+    std::vector<double> _lon;
+    std::vector<double> _alt;
+
+    // use the centroid hour angle and declination for the whole domain
+    bool _centroid_hour_angle;
+    double _centroid_lon;
+    double _centroid_alt;
 };
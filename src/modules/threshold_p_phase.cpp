@@ -45,24 +45,34 @@ threshold_p_phase::~threshold_p_phase()
 
 }
 
+void threshold_p_phase::init(mesh& domain)
+{
+    _t = var("t");
+    _p = var("p");
+    _frac_precip_rain = var("frac_precip_rain");
+    _frac_precip_snow = var("frac_precip_snow");
+    _p_rain = var("p_rain");
+    _p_snow = var("p_snow");
+}
+
 void threshold_p_phase::run(mesh_elem &face)
 {
-    double p = (*face)["p"_s];
+    double p = face->get(_p);
 
-    if( (*face)["t"_s] >= t_thresh)
+    if( face->get(_t) >= t_thresh)
     {
-        (*face)["frac_precip_rain"_s]= 1;
-        (*face)["frac_precip_snow"_s]= 0;
+        face->get(_frac_precip_rain)= 1;
+        face->get(_frac_precip_snow)= 0;
 
-        (*face)["p_rain"_s]= p;
-        (*face)["p_snow"_s]= 0 ;
+        face->get(_p_rain)= p;
+        face->get(_p_snow)= 0 ;
     } else
     {
-        (*face)["frac_precip_rain"_s]= 0;
-        (*face)["frac_precip_snow"_s]= 1;
+        face->get(_frac_precip_rain)= 0;
+        face->get(_frac_precip_snow)= 1;
 
-        (*face)["p_rain"_s]= 0;
-        (*face)["p_snow"_s]= p ;
+        face->get(_p_rain)= 0;
+        face->get(_p_snow)= p ;
     }
 
 
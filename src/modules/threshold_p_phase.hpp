@@ -78,9 +78,19 @@ public:
 
     virtual void run(mesh_elem &face);
 
+    void init(mesh& domain);
+
 private:
 
     // the air temperature threshold above which the precip phase is liquid
     double t_thresh;
 
+    // face variable handles, resolved in init
+    var_handle _t;
+    var_handle _p;
+    var_handle _frac_precip_rain;
+    var_handle _frac_precip_snow;
+    var_handle _p_rain;
+    var_handle _p_snow;
+
 };
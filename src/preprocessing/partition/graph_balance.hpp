@@ -0,0 +1,206 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+/*
+ * Weighted load balancing of the face adjacency graph.
+ *
+ * A CHM partition is described only by local_sizes: rank r owns the next local_sizes[r] faces of the (permuted)
+ * global face order. So a partition has to be a set of contiguous ranges of that order. Within that constraint this
+ * does a recursive bisection: each split point is placed so both halves carry their share of the face weight, and
+ * within the allowed imbalance it is moved to where the fewest graph edges cross it.
+ */
+namespace graph_balance
+{
+    // face index -> up to 3 neighbour face indices, -1 for none
+    typedef std::vector<std::array<int, 3>> adjacency;
+
+    struct statistics
+    {
+        size_t edge_cut = 0;            // # of graph edges between faces on different ranks
+        double imbalance = 0;           // max rank weight / mean rank weight
+        double min_weight = 0;          // smallest rank weight
+        double max_weight = 0;          // largest rank weight
+        std::vector<size_t> rank_cut;   // edges leaving each rank, i.e., its halo size
+    };
+
+    namespace detail
+    {
+        inline void bisect(const std::vector<size_t>& order,
+                           const std::vector<size_t>& position,
+                           const adjacency& neighbors,
+                           const std::vector<double>& prefix_weight,
+                           double tolerance,
+                           size_t lo, size_t hi, size_t first_part, size_t nparts,
+                           std::vector<int>& sizes)
+        {
+            if (nparts == 1)
+            {
+                sizes.at(first_part) = static_cast<int>(hi - lo);
+                return;
+            }
+
+            size_t nleft = nparts / 2;
+            double fraction = static_cast<double>(nleft) / nparts;
+            double total = prefix_weight[hi] - prefix_weight[lo];
+            double target = prefix_weight[lo] + total * fraction;
+
+            // every part needs at least one face
+            size_t k_min = lo + nleft;
+            size_t k_max = hi - (nparts - nleft);
+
+            // split k puts positions [lo, k) on the left. The balanced split is where the prefix weight crosses target
+            size_t k_balanced = std::lower_bound(prefix_weight.begin() + k_min, prefix_weight.begin() + k_max + 1,
+                                                 target) - prefix_weight.begin();
+            k_balanced = std::min(std::max(k_balanced, k_min), k_max);
+
+            // any split whose left weight is within tolerance of the target is acceptable
+            double slack = tolerance * total * std::min(fraction, 1.0 - fraction);
+            size_t k_lo = std::lower_bound(prefix_weight.begin() + k_min, prefix_weight.begin() + k_balanced + 1,
+                                           target - slack) - prefix_weight.begin();
+            size_t k_hi = std::upper_bound(prefix_weight.begin() + k_balanced, prefix_weight.begin() + k_max + 1,
+                                           target + slack) - prefix_weight.begin();
+            k_lo = std::min(std::max(k_lo, k_min), k_balanced);
+            k_hi = std::max(std::min(k_hi == k_balanced ? k_hi : k_hi - 1, k_max), k_balanced);
+
+            // cut[k - lo] = # of edges inside [lo, hi) that cross split k, built from a difference array
+            std::vector<long> cut(hi - lo + 1, 0);
+            for (size_t p = lo; p < hi; ++p)
+            {
+                for (auto n : neighbors[order[p]])
+                {
+                    if (n < 0)
+                        continue;
+                    size_t q = position[n];
+                    // count each edge once, from its lower end
+                    if (q <= p || q >= hi)
+                        continue;
+                    cut[p + 1 - lo] += 1;
+                    cut[q + 1 - lo] -= 1;
+                }
+            }
+            std::partial_sum(cut.begin(), cut.end(), cut.begin());
+
+            size_t best = k_balanced;
+            for (size_t k = k_lo; k <= k_hi; ++k)
+            {
+                long c = cut[k - lo];
+                long c_best = cut[best - lo];
+                if (c < c_best ||
+                    (c == c_best && std::abs(static_cast<long>(k) - static_cast<long>(k_balanced)) <
+                                        std::abs(static_cast<long>(best) - static_cast<long>(k_balanced))))
+                    best = k;
+            }
+
+            bisect(order, position, neighbors, prefix_weight, tolerance, lo, best, first_part, nleft, sizes);
+            bisect(order, position, neighbors, prefix_weight, tolerance, best, hi, first_part + nleft, nparts - nleft,
+                   sizes);
+        }
+    }
+
+    /**
+     * Split the face order into nparts contiguous ranges.
+     * @param order Position -> face index, i.e., the global face order (_global_IDs)
+     * @param neighbors Face adjacency, indexed by face index
+     * @param weights Per-face cost, indexed by face index
+     * @param nparts Number of ranks
+     * @param tolerance Allowed relative deviation of a split from its ideal weight, e.g., 0.03
+     * @return # of faces for each rank, in rank order (local_sizes)
+     */
+    inline std::vector<int> partition(const std::vector<size_t>& order,
+                                      const adjacency& neighbors,
+                                      const std::vector<double>& weights,
+                                      size_t nparts,
+                                      double tolerance)
+    {
+        const size_t n = order.size();
+
+        std::vector<size_t> position(n);
+        std::vector<double> prefix_weight(n + 1, 0.0);
+        for (size_t p = 0; p < n; ++p)
+        {
+            position[order[p]] = p;
+            prefix_weight[p + 1] = prefix_weight[p] + weights[order[p]];
+        }
+
+        std::vector<int> sizes(nparts, 0);
+        if (nparts == 0 || n < nparts)
+            return sizes;
+
+        detail::bisect(order, position, neighbors, prefix_weight, tolerance, 0, n, 0, nparts, sizes);
+        return sizes;
+    }
+
+    /**
+     * Edge cut and load imbalance of a partition given by local sizes
+     */
+    inline statistics evaluate(const std::vector<size_t>& order,
+                               const adjacency& neighbors,
+                               const std::vector<double>& weights,
+                               const std::vector<int>& sizes)
+    {
+        statistics s;
+
+        std::vector<int> owner(order.size());
+        std::vector<double> rank_weight(sizes.size(), 0.0);
+        size_t p = 0;
+        for (size_t r = 0; r < sizes.size(); ++r)
+        {
+            for (int i = 0; i < sizes[r]; ++i, ++p)
+            {
+                owner[order[p]] = static_cast<int>(r);
+                rank_weight[r] += weights[order[p]];
+            }
+        }
+
+        s.rank_cut.assign(sizes.size(), 0);
+        for (size_t f = 0; f < neighbors.size(); ++f)
+        {
+            for (auto n : neighbors[f])
+            {
+                if (n < 0 || owner[n] == owner[f])
+                    continue;
+                s.rank_cut[owner[f]] += 1;
+                if (static_cast<size_t>(n) > f)
+                    s.edge_cut += 1;
+            }
+        }
+
+        if (!rank_weight.empty())
+        {
+            double mean = std::accumulate(rank_weight.begin(), rank_weight.end(), 0.0) / rank_weight.size();
+            s.min_weight = *std::min_element(rank_weight.begin(), rank_weight.end());
+            s.max_weight = *std::max_element(rank_weight.begin(), rank_weight.end());
+            s.imbalance = mean > 0 ? s.max_weight / mean : 0;
+        }
+
+        return s;
+    }
+}
@@ -25,6 +25,7 @@
 #include "core.hpp"
 #include "logger.hpp"
 #include "sort_perm.hpp"
+#include "graph_balance.hpp"
 #include "triangulation.hpp"
 
 #include <boost/filesystem.hpp>
@@ -32,6 +33,8 @@
 #include <boost/property_tree/ptree.hpp>
 
 #include <algorithm>
+#include <cmath>
+#include <fstream>
 #include <numeric>
 #include <string>
 #include <vector>
@@ -83,6 +86,15 @@ std::vector<std::vector<T>> array_split(const std::vector<T>& source, size_t chu
     return result;
 }
 
+// How to recompute local_sizes from the face adjacency graph instead of using the ones in the mesh
+struct balance_options
+{
+    bool enabled = false;
+    std::string weight_param; // per-face cost from this parameter
+    std::string weight_file;  // or from a measured profile, one value per face in cell_global_id order
+    double tolerance = 0.03;  // allowed imbalance of each split
+};
+
 typedef struct _MeshParameters
 {
     std::vector<std::string> names;
@@ -558,9 +570,128 @@ class preprocessingTriangulation : public triangulation
                   << " ghosted nearest neighbors.";
     }
 
+    /**
+     * Per-face cost used to balance the partition, indexed by face. 1 for every face unless a cost parameter or
+     * profile is given.
+     */
+    std::vector<double> read_face_weights(const std::vector<std::string>& param_filenames, const balance_options& balance)
+    {
+        std::vector<double> weights(_faces.size(), 1.0);
+
+        if (!balance.weight_param.empty())
+        {
+            bool found = false;
+            for (auto const& param_filename : param_filenames)
+            {
+                try
+                {
+                    Exception::dontPrint();
+                    H5File file(param_filename, H5F_ACC_RDONLY);
+                    DataSet dataset = file.openGroup("parameters").openDataSet(balance.weight_param);
+
+                    hsize_t nelem;
+                    dataset.getSpace().getSimpleExtentDims(&nelem);
+                    if (nelem != weights.size())
+                        CHM_THROW_EXCEPTION(mesh_error, "Weight parameter " + balance.weight_param + " has " +
+                                                            std::to_string(nelem) + " values, expected " +
+                                                            std::to_string(weights.size()));
+
+                    dataset.read(weights.data(), PredType::NATIVE_DOUBLE);
+                    found = true;
+                    break;
+                }
+                catch (FileIException& error)
+                {
+                }
+                catch (GroupIException& error)
+                {
+                }
+                catch (DataSetIException& error)
+                {
+                }
+            }
+
+            if (!found)
+                CHM_THROW_EXCEPTION(mesh_error, "Weight parameter " + balance.weight_param + " not found in the parameter files");
+        }
+        else if (!balance.weight_file.empty())
+        {
+            std::ifstream in(balance.weight_file);
+            if (!in)
+                CHM_THROW_EXCEPTION(mesh_error, "Unable to open weight file " + balance.weight_file);
+
+            size_t i = 0;
+            double w;
+            while (in >> w)
+            {
+                if (i < weights.size())
+                    weights[i] = w;
+                ++i;
+            }
+
+            if (i != weights.size())
+                CHM_THROW_EXCEPTION(mesh_error, "Weight file " + balance.weight_file + " has " + std::to_string(i) +
+                                                    " values, expected " + std::to_string(weights.size()));
+        }
+
+        for (size_t i = 0; i < weights.size(); ++i)
+        {
+            if (!std::isfinite(weights[i]) || weights[i] < 0)
+                CHM_THROW_EXCEPTION(mesh_error, "Face " + std::to_string(i) + " has an invalid weight of " +
+                                                    std::to_string(weights[i]) + ". Weights must be finite and >= 0");
+        }
+
+        return weights;
+    }
+
+    /**
+     * Optionally recompute _local_sizes with graph_balance, then report the edge cut and load imbalance of the
+     * partition that will be written.
+     */
+    void balance_partition(const std::vector<std::string>& param_filenames, size_t MPI_ranks,
+                           const balance_options& balance)
+    {
+        std::vector<size_t> order(_global_IDs.begin(), _global_IDs.end());
+
+        graph_balance::adjacency neighbors(_faces.size());
+#pragma omp parallel for
+        for (size_t i = 0; i < _faces.size(); ++i)
+        {
+            for (int j = 0; j < 3; ++j)
+            {
+                auto n = _faces[i]->neighbor(j);
+                neighbors[i][j] = n != nullptr ? static_cast<int>(n->cell_global_id) : -1;
+            }
+        }
+
+        auto weights = read_face_weights(param_filenames, balance);
+
+        if (balance.enabled)
+        {
+            LOG_DEBUG << "Balancing partition for #ranks=" << MPI_ranks << " with tolerance " << balance.tolerance;
+            _local_sizes = graph_balance::partition(order, neighbors, weights, MPI_ranks, balance.tolerance);
+        }
+
+        if (_local_sizes.size() != MPI_ranks)
+            return; // caught by the caller
+
+        auto stats = graph_balance::evaluate(order, neighbors, weights, _local_sizes);
+        auto halo = std::minmax_element(stats.rank_cut.begin(), stats.rank_cut.end());
+
+        if (real_comm_world.rank() == 0)
+        {
+            LOG_INFO << "Partition statistics for #ranks=" << MPI_ranks << (balance.enabled ? " (balanced)" : "");
+            LOG_INFO << "\tedge cut:           " << stats.edge_cut;
+            LOG_INFO << "\timbalance:          " << stats.imbalance << " (max/mean rank weight)";
+            LOG_INFO << "\trank weight:        min " << stats.min_weight << ", max " << stats.max_weight;
+            LOG_INFO << "\tcut edges per rank: min " << *halo.first << ", max " << *halo.second;
+        }
+    }
+
     void from_file_and_partition(const std::string& mesh_filename, const std::vector<std::string>& param_filenames,
                                  size_t MPI_ranks, double max_ghost_distance, int standalone_rank,
-                                 std::vector<int> ranks_to_keep, bool output_vtu)
+                                 std::vector<int> ranks_to_keep, bool output_vtu,
+                                 const balance_options& balance = balance_options())
     {
 
         // all the _comm_world here in are "faked" and not real MPI. These are used to force a domain decomp at a
@@ -649,12 +780,19 @@ class preprocessingTriangulation : public triangulation
             }
             catch (pt::ptree_bad_path& e)
             {
-
-                LOG_WARNING
-                    << "No face permutation was found in the mesh file. This will result in poor MPI performance"
-                       " due to increased communications. \nPlease see the mesh permutation documentation for more "
-                       "details\n"
-                       "https://mesher-hydro.readthedocs.io/en/latest/tools.html#mesherpermuation-py";
+                if (_face_ordering == math::space_filling_curve::curve::none)
+                {
+                    LOG_WARNING
+                        << "No face permutation was found in the mesh file. This will result in poor MPI performance"
+                           " due to increased communications. \nPlease see the mesh permutation documentation for more "
+                           "details\n"
+                           "https://mesher-hydro.readthedocs.io/en/latest/tools.html#mesherpermuation-py";
+                }
+                else
+                {
+                    LOG_INFO << "No face permutation was found in the mesh file. Faces will be ordered along a "
+                                "space-filling curve instead (--face-ordering).";
+                }
             }
             from_json(mesh);
 
@@ -671,6 +809,8 @@ class preprocessingTriangulation : public triangulation
             return;
         }
 
+        balance_partition(param_filenames, MPI_ranks, balance);
+
         if(_local_sizes.size() != MPI_ranks)
         {
             CHM_THROW_EXCEPTION(mesh_error, "Mesh was partitioned for " + std::to_string(_local_sizes.size()) + " partitions but was requested split into " + std::to_string(MPI_ranks));
@@ -782,11 +922,12 @@ class preprocessingTriangulation : public triangulation
                 LOG_DEBUG << "Writting partition.vtu";
                 // init the datastructs to hold information for outputting to VTU
                 std::set< std::string > vtu_outputs = { "owner", "is_ghost", "ghost_type", "global_id","local_id"};
+                _init_face_variables(_faces, vtu_outputs);
+
 #pragma omp parallel for
                 for (size_t i = 0; i < _faces.size(); ++i)
                 {
                     auto f = _faces.at(i);
-                    f->init_time_series(vtu_outputs);
                     (*f)["owner"] = f->owner;
                 }
 
@@ -1453,6 +1594,8 @@ int main(int argc, char* argv[])
 
     int standalone_rank = -1;
     bool output_vtu=false;
+    balance_options balance;
+    std::string face_ordering = "none";
 
     po::options_description desc("Allowed options.");
     desc.add_options()("help", "This message")
@@ -1463,6 +1606,17 @@ int main(int argc, char* argv[])
         "standalone,s", po::value<int>(&standalone_rank),
         "Write the paritioned mesh so-as to be loadable standalone. Advanced debugging feature. Arg is rank to do")(
             "write-vtu", po::bool_switch(&output_vtu),"Output the rank partitions as vtu")(
+        "balance", po::bool_switch(&balance.enabled),
+        "Recompute the partition sizes from the face adjacency graph to balance the per-face cost and reduce the edge cut")(
+        "weight-param", po::value<std::string>(&balance.weight_param),
+        "Parameter holding the per-face cost used by --balance")(
+        "weight-file", po::value<std::string>(&balance.weight_file),
+        "Text file with a measured per-face cost, one value per face in cell_global_id order, used by --balance")(
+        "imbalance-tolerance", po::value<double>(&balance.tolerance),
+        "Allowed imbalance of each split used by --balance. Default 0.03")(
+        "face-ordering", po::value<std::string>(&face_ordering),
+        "Space-filling curve (none, hilbert, morton) used to order the faces of a json mesh that has no "
+        "permutation when converting it to h5. Default none")(
         "mpi-ranks", po::value<size_t>(&MPI_ranks), "Number of MPI ranks to partition for");
 
     po::variables_map vm;
@@ -1510,6 +1664,24 @@ int main(int argc, char* argv[])
         LOG_WARNING << "Using default max ghost distance of 100 m";
     }
 
+    if (!balance.weight_param.empty() && !balance.weight_file.empty())
+    {
+        LOG_ERROR << "Only one of --weight-param and --weight-file can be given";
+        exit(-1);
+    }
+
+    math::space_filling_curve::curve ordering;
+    if (!math::space_filling_curve::from_string(face_ordering, ordering))
+    {
+        LOG_ERROR << "Unknown --face-ordering " << face_ordering << ". Must be one of none, hilbert, morton";
+        exit(-1);
+    }
+
+    if ((!balance.weight_param.empty() || !balance.weight_file.empty()) && !balance.enabled)
+    {
+        LOG_WARNING << "Face weights are only used to report the partition statistics without --balance";
+    }
+
     std::vector<int> valid_ranks;
     if(vm.count("valid-ranks"))
     {
@@ -1543,6 +1715,7 @@ int main(int argc, char* argv[])
 
         {
             preprocessingTriangulation* tri = new preprocessingTriangulation();
+            tri->_face_ordering = ordering;
 
             // need to process the json file in serial, only rank 0 can do it
             if(is_json_mesh && real_comm_world.size() > 1)
@@ -1551,13 +1724,13 @@ int main(int argc, char* argv[])
                 {
                     LOG_DEBUG << "Rank 0 doing json -> h5 conversation";
                     tri->from_file_and_partition(mesh_filename, param_filenames, MPI_ranks, max_ghost_distance,
-                                                 standalone_rank, valid_ranks, output_vtu);
+                                                 standalone_rank, valid_ranks, output_vtu, balance);
                 }
             }
             else // not a json file or in serial mode and json, we can let the MPI logic in here proceed as normal
             {
                 tri->from_file_and_partition(mesh_filename, param_filenames, MPI_ranks, max_ghost_distance,
-                                             standalone_rank, valid_ranks, output_vtu);
+                                             standalone_rank, valid_ranks, output_vtu, balance);
             }
 
         }
@@ -1576,7 +1749,7 @@ int main(int argc, char* argv[])
                                                       "_param.h5"};
 
             preprocessingTriangulation* tri = new preprocessingTriangulation();
-            tri->from_file_and_partition(h5_mesh_name, h5_param_name, MPI_ranks, max_ghost_distance, standalone_rank, valid_ranks, output_vtu);
+            tri->from_file_and_partition(h5_mesh_name, h5_param_name, MPI_ranks, max_ghost_distance, standalone_rank, valid_ranks, output_vtu, balance);
 
         }
     }
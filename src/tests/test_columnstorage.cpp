@@ -0,0 +1,153 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "columnstorage.hpp"
+#include "gtest/gtest.h"
+
+class ColumnStorageTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        // some test variables
+        variables.insert("t");
+        variables.insert("rh");
+        variables.insert("vw");
+        variables.insert("p");
+    }
+
+    std::set< std::string> variables;
+    size_t ncells = 10;
+};
+
+//basic default init sanity checks
+TEST_F(ColumnStorageTest, DefaultInit)
+{
+    columnstorage<double> c;
+    ASSERT_EQ(c.size() , 0);
+    ASSERT_EQ(c.ncells() , 0);
+    ASSERT_EQ(c.variables().size() , 0);
+    ASSERT_FALSE(c.has("t"));
+}
+
+// check if init correctly allocates and defaults every column
+TEST_F(ColumnStorageTest, Init)
+{
+    columnstorage<double> c;
+    c.init(variables, ncells);
+
+    ASSERT_EQ(c.size() , 4);
+    ASSERT_EQ(c.ncells() , ncells);
+    ASSERT_EQ(c.variables().size() , 4);
+
+    for(size_t i = 0; i < ncells; ++i)
+    {
+        ASSERT_EQ(c.at("t", i) , -9999);
+        ASSERT_EQ(c.at("rh"_s, i) , -9999);
+    }
+}
+
+TEST_F(ColumnStorageTest, valueAccess)
+{
+    columnstorage<double> c;
+    c.init(variables, ncells);
+
+    for(size_t i = 0; i < ncells; ++i)
+    {
+        c.at("t", i) = i;
+        c.at("p"_s, i) = 2.0 * i;
+    }
+
+    for(size_t i = 0; i < ncells; ++i)
+    {
+        ASSERT_EQ(c.at("t"_s, i) , i);
+        ASSERT_EQ(c.at("p", i) , 2.0 * i);
+        ASSERT_EQ(c.at("rh", i) , -9999);
+    }
+}
+
+// a column view must alias the same memory as the per-cell accessors
+TEST_F(ColumnStorageTest, column)
+{
+    columnstorage<double> c;
+    c.init(variables, ncells);
+
+    auto col = c.column(c.index("vw"));
+    ASSERT_EQ(col.size , ncells);
+
+    for(size_t i = 0; i < col.size; ++i)
+    {
+        col[i] = 100 + i;
+    }
+
+    for(size_t i = 0; i < ncells; ++i)
+    {
+        ASSERT_EQ(c.at("vw", i) , 100 + i);
+        ASSERT_EQ(c(c.index("vw"_s), i) , 100 + i);
+    }
+
+    ASSERT_ANY_THROW(c.column(c.size()));
+}
+
+TEST_F(ColumnStorageTest, has)
+{
+    columnstorage<double> c;
+    c.init(variables, ncells);
+
+    ASSERT_TRUE(c.has("t"));
+    ASSERT_TRUE(c.has("rh"));
+    ASSERT_TRUE(c.has("vw"));
+    ASSERT_TRUE(c.has("p"));
+}
+
+TEST_F(ColumnStorageTest, uninit)
+{
+    columnstorage<double> c;
+    ASSERT_ANY_THROW(c.at("t", 0) = 1);
+}
+
+// handles resolved from the variable set alone must match the allocated storage
+TEST_F(ColumnStorageTest, handle)
+{
+    columnstorage<double> c;
+    c.init(variables, ncells);
+
+    for(auto& v : variables)
+    {
+        auto h = c.handle(v);
+        ASSERT_TRUE(h.valid());
+        ASSERT_EQ(h.column, columnstorage<double>::layout_handle(variables, v).column);
+        ASSERT_EQ(h.column, c.index(v));
+    }
+
+    auto h = c.handle("rh"_s);
+    c(h, 3) = 42;
+    ASSERT_EQ(c.at("rh", 3), 42);
+
+    ASSERT_FALSE(var_handle().valid());
+    ASSERT_ANY_THROW(columnstorage<double>::layout_handle(variables, "swe"));
+}
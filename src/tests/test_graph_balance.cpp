@@ -0,0 +1,123 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "preprocessing/partition/graph_balance.hpp"
+#include "gtest/gtest.h"
+
+// A strip of n triangles, face i neighbours i-1 and i+1
+class GraphBalanceTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        n = 100;
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0);
+
+        neighbors.assign(n, {-1, -1, -1});
+        for (size_t i = 0; i < n; ++i)
+        {
+            if (i > 0)
+                neighbors[i][0] = i - 1;
+            if (i + 1 < n)
+                neighbors[i][1] = i + 1;
+        }
+    }
+
+    size_t n;
+    std::vector<size_t> order;
+    graph_balance::adjacency neighbors;
+};
+
+TEST_F(GraphBalanceTest, UniformWeightsSplitEvenly)
+{
+    std::vector<double> weights(n, 1.0);
+    auto sizes = graph_balance::partition(order, neighbors, weights, 4, 0.0);
+
+    ASSERT_EQ(sizes.size(), 4);
+    for (auto s : sizes)
+        EXPECT_EQ(s, 25);
+
+    auto stats = graph_balance::evaluate(order, neighbors, weights, sizes);
+    EXPECT_EQ(stats.edge_cut, 3);
+    EXPECT_DOUBLE_EQ(stats.imbalance, 1.0);
+    EXPECT_EQ(stats.rank_cut[0], 1);
+    EXPECT_EQ(stats.rank_cut[1], 2);
+}
+
+TEST_F(GraphBalanceTest, WeightsShiftTheSplit)
+{
+    // the first quarter of the faces cost 3x as much
+    std::vector<double> weights(n, 1.0);
+    for (size_t i = 0; i < n / 4; ++i)
+        weights[i] = 3.0;
+
+    auto sizes = graph_balance::partition(order, neighbors, weights, 2, 0.0);
+
+    // total = 75 + 75 = 150, so the first rank takes the 25 heavy faces
+    EXPECT_EQ(sizes[0], 25);
+    EXPECT_EQ(sizes[1], 75);
+
+    auto stats = graph_balance::evaluate(order, neighbors, weights, sizes);
+    EXPECT_DOUBLE_EQ(stats.imbalance, 1.0);
+}
+
+TEST_F(GraphBalanceTest, SplitAvoidsDenseRegionWithinTolerance)
+{
+    // faces 48..51 are all connected to each other, so splitting near the middle of them cuts more edges
+    for (size_t i = 48; i < 52; ++i)
+        neighbors[i][2] = i < 50 ? i + 2 : i - 2;
+
+    std::vector<double> weights(n, 1.0);
+
+    auto strict = graph_balance::partition(order, neighbors, weights, 2, 0.0);
+    auto relaxed = graph_balance::partition(order, neighbors, weights, 2, 0.1);
+
+    auto strict_stats = graph_balance::evaluate(order, neighbors, weights, strict);
+    auto relaxed_stats = graph_balance::evaluate(order, neighbors, weights, relaxed);
+
+    EXPECT_EQ(strict[0], 50);
+    EXPECT_LT(relaxed_stats.edge_cut, strict_stats.edge_cut);
+    EXPECT_LE(relaxed_stats.imbalance, 1.1);
+    EXPECT_EQ(relaxed[0] + relaxed[1], n);
+}
+
+TEST_F(GraphBalanceTest, EveryRankGetsAFace)
+{
+    // all of the weight is on one face
+    std::vector<double> weights(n, 0.0);
+    weights[0] = 1.0;
+
+    auto sizes = graph_balance::partition(order, neighbors, weights, 8, 0.03);
+
+    int total = 0;
+    for (auto s : sizes)
+    {
+        EXPECT_GE(s, 1);
+        total += s;
+    }
+    EXPECT_EQ(total, n);
+}
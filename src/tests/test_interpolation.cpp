@@ -23,15 +23,23 @@
 
 
 #include "interpolation.hpp"
+#include "interpolation/interp_plan.hpp"
+#include "triangulation.hpp"
+#include "station.hpp"
 #include "logger.hpp"
 #include <vector>
 #include <boost/tuple/tuple.hpp>
 
+#include "test_mesh_helpers.hpp"
 #include "gtest/gtest.h"
 #include <stdlib.h>
+#include <cmath>
+#include <map>
 #include <string>
 #include <utility>
 
+#include <boost/make_shared.hpp>
+
 
 class InterpTest : public testing::Test
 {
@@ -165,3 +173,167 @@ TEST_F(InterpTest,interpolation_class_static_size2)
 
 
 }
+
+TEST_F(InterpTest,spline_cached_factorization)
+{
+    thin_plate_spline cached(5);
+    thin_plate_spline uncached(5, {{"reuse_LU","false"}});
+
+    std::vector<boost::tuple<double,double,double> > xy;
+
+    xy.push_back( boost::make_tuple(69.,76.,20.820));
+    xy.push_back( boost::make_tuple(59.,64.,10.910 ));
+    xy.push_back( boost::make_tuple(75.,52.,10.380 ));
+    xy.push_back( boost::make_tuple(86.,73.,14.600 ));
+    xy.push_back( boost::make_tuple(88.,53.,10.560 ));
+
+    auto query = boost::make_tuple(69.,67.,0.);
+
+    ASSERT_DOUBLE_EQ(cached(xy,query), uncached(xy,query));
+
+    // new values, same stations: cached weights are reused
+    xy[0].get<2>() = 5.0;
+    ASSERT_DOUBLE_EQ(cached(xy,query), uncached(xy,query));
+
+    // a station drops out (e.g., NaN), so the factorization must change
+    auto dropped = xy;
+    dropped.erase(dropped.begin() + 2);
+    ASSERT_DOUBLE_EQ(cached(dropped,query), uncached(dropped,query));
+
+    // and back again
+    ASSERT_DOUBLE_EQ(cached(xy,query), uncached(xy,query));
+
+    // a different query point on the same stations
+    auto query2 = boost::make_tuple(80.,60.,0.);
+    ASSERT_DOUBLE_EQ(cached(xy,query2), uncached(xy,query2));
+}
+
+class InterpPlanTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        domain = boost::make_shared<triangulation>();
+        load_granger1m(*domain);
+
+        // stations around the domain, and the last one exactly at the centre of face 7
+        auto f = domain->face(7);
+        std::vector<std::pair<double, double>> xy = {{-1500, -900}, {1200, -300}, {200, 1700}, {-600, 800}};
+        for (size_t i = 0; i < xy.size(); ++i)
+        {
+            stations.push_back(std::make_shared<station>("s" + std::to_string(i), f->get_x() + xy[i].first,
+                                                         f->get_y() + xy[i].second, 0));
+            values[stations.back().get()] = 10.0 + 3.0 * i;
+        }
+        stations.push_back(std::make_shared<station>("on_face", f->get_x(), f->get_y(), 0));
+        values[stations.back().get()] = -4.0;
+
+        for (size_t i = 0; i < domain->size_faces(); ++i)
+        {
+            auto face = domain->face(i);
+            face->stations() = stations;
+
+            double best = std::numeric_limits<double>::max();
+            for (auto& s : stations)
+            {
+                double d = std::hypot(s->x() - face->get_x(), s->y() - face->get_y());
+                if (d < best)
+                {
+                    best = d;
+                    face->nearest_station() = s;
+                }
+            }
+        }
+    }
+
+    // what the interp_met modules do: skip the missing stations, then interpolate over the rest
+    double reference(interp_alg ia, size_t i)
+    {
+        auto face = domain->face(i);
+        std::vector<boost::tuple<double, double, double>> samples;
+
+        if (ia == interp_alg::nearest_sta)
+        {
+            auto& s = face->nearest_station();
+            samples.push_back(boost::make_tuple(s->x(), s->y(), values[s.get()]));
+        }
+        else
+        {
+            for (auto& s : face->stations())
+            {
+                if (std::isnan(values[s.get()]))
+                    continue;
+                samples.push_back(boost::make_tuple(s->x(), s->y(), values[s.get()]));
+            }
+        }
+
+        interpolation interp(ia);
+        auto query = boost::make_tuple(face->get_x(), face->get_y(), face->get_z());
+        return interp(samples, query);
+    }
+
+    void check(interp_alg ia)
+    {
+        interp_plan plan;
+        plan.init(ia, domain);
+        ASSERT_EQ(domain->size_faces(), plan.nfaces());
+
+        auto v = plan.station_values([&](station& s) { return values[&s]; });
+        std::vector<double> out(plan.nfaces());
+        plan.apply(v, out.data());
+
+        for (size_t i = 0; i < domain->size_faces(); ++i)
+        {
+            double expected = reference(ia, i);
+            ASSERT_NEAR(expected, out[i], 1e-12 * std::fabs(expected)) << "face " << i;
+            ASSERT_DOUBLE_EQ(out[i], plan.apply(i, v));
+        }
+    }
+
+    mesh domain;
+    std::vector<std::shared_ptr<station>> stations;
+    std::map<station*, double> values;
+};
+
+TEST_F(InterpPlanTest, IdwMatchesInvDist)
+{
+    check(interp_alg::idw);
+
+    // the station on face 7 is last in its list, the only order where inv_dist gives it all of the weight
+    interp_plan plan;
+    plan.init(interp_alg::idw, domain);
+    auto v = plan.station_values([&](station& s) { return values[&s]; });
+    ASSERT_DOUBLE_EQ(-4.0, plan.apply(7, v));
+}
+
+TEST_F(InterpPlanTest, NearestMatches)
+{
+    check(interp_alg::nearest_sta);
+}
+
+TEST_F(InterpPlanTest, MissingStationsAreSkipped)
+{
+    values[stations[1].get()] = std::nan("nan");
+    check(interp_alg::idw);
+
+    // face 7 falls back to IDW over the other stations
+    values[stations.back().get()] = std::nan("nan");
+    check(interp_alg::idw);
+}
+
+TEST_F(InterpPlanTest, AllStationsMissingThrows)
+{
+    interp_plan plan;
+    plan.init(interp_alg::idw, domain);
+
+    for (auto& s : stations)
+        values[s.get()] = std::nan("nan");
+
+    auto v = plan.station_values([&](station& s) { return values[&s]; });
+    std::vector<double> out(plan.nfaces());
+    ASSERT_THROW(plan.apply(v, out.data()), interpolation_error);
+    ASSERT_THROW(plan.apply(0, v), interpolation_error);
+}
@@ -0,0 +1,132 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "math/LinearAlgebra.hpp"
+#include "triangulation.hpp"
+#include "test_mesh_helpers.hpp"
+#include "gtest/gtest.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+namespace la = math::LinearAlgebra;
+
+class LinearAlgebraTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        domain = boost::make_shared<triangulation>();
+        load_granger1m(*domain);
+        std::set<std::string> variables = {"t"};
+        domain->init_timeseries(variables);
+    }
+
+    // Deterministic, diagonally dominant coefficient of a stencil entry so the system is solvable
+    static double coefficient(la::global_ordinal_type row, la::StencilSlot slot)
+    {
+        if (slot == la::self)
+            return 10.0;
+        return -0.1 * (1 + (row * 7 + slot) % 5);
+    }
+
+    mesh domain;
+};
+
+// The cached-stencil path must assemble exactly what the global-index path does
+TEST_F(LinearAlgebraTest, LocalStencilMatchesGlobalAssembly)
+{
+    const int nLayer = 3;
+    la::NearestNeighborProblem global_problem(domain, nLayer);
+    la::NearestNeighborProblem local_problem(domain, nLayer);
+
+    global_problem.zeroSystem();
+    local_problem.zeroSystem();
+
+    const size_t n_global_tri = domain->size_global_faces();
+    for (size_t i = 0; i < domain->size_faces(); ++i)
+    {
+        auto face = domain->face(i);
+        for (int layer = 0; layer < nLayer; ++layer)
+        {
+            la::global_ordinal_type gid[la::stencil_size];
+            for (int f = 0; f < 3; ++f)
+            {
+                auto neighbor = face->neighbor(f);
+                gid[f] = neighbor != nullptr ? n_global_tri * layer + neighbor->cell_global_id : -1;
+            }
+            gid[la::above] = layer < nLayer - 1 ? n_global_tri * (layer + 1) + face->cell_global_id : -1;
+            gid[la::below] = layer > 0 ? n_global_tri * (layer - 1) + face->cell_global_id : -1;
+            gid[la::self] = n_global_tri * layer + face->cell_global_id;
+
+            size_t row = local_problem.localRow(face->cell_local_id, layer);
+            for (int s = 0; s < la::stencil_size; ++s)
+            {
+                auto slot = static_cast<la::StencilSlot>(s);
+                if (gid[s] < 0)
+                {
+                    // e.g., the missing neighbour of an edge face
+                    ASSERT_ANY_THROW(local_problem.matrixSumIntoLocalRow(row, slot, 1.0));
+                    continue;
+                }
+
+                double v = coefficient(gid[la::self], slot);
+                global_problem.matrixSumIntoGlobalValues(gid[la::self], gid[s], v);
+                local_problem.matrixSumIntoLocalRow(row, slot, v);
+            }
+
+            // twice, so accumulation into the same entry is covered
+            for (int k = 0; k < 2; ++k)
+            {
+                double r = 1.0 + 0.01 * gid[la::self];
+                global_problem.rhsSumIntoGlobalValue(gid[la::self], r);
+                local_problem.rhsSumIntoLocalRow(row, r);
+            }
+        }
+    }
+
+    global_problem.Solve();
+    local_problem.Solve();
+
+    // both matrices are built on the same graph, so their local values line up entry for entry
+    auto global_values = global_problem.getMatrix()->getLocalValuesHost(Tpetra::Access::ReadOnly);
+    auto local_values = local_problem.getMatrix()->getLocalValuesHost(Tpetra::Access::ReadOnly);
+    ASSERT_EQ(global_values.extent(0), local_values.extent(0));
+    for (size_t k = 0; k < global_values.extent(0); ++k)
+        ASSERT_DOUBLE_EQ(global_values(k), local_values(k));
+
+    auto global_rhs = global_problem.getRhs()->get1dView();
+    auto local_rhs = local_problem.getRhs()->get1dView();
+    ASSERT_EQ(global_rhs.size(), local_rhs.size());
+    for (int k = 0; k < global_rhs.size(); ++k)
+        ASSERT_DOUBLE_EQ(global_rhs[k], local_rhs[k]);
+
+    auto global_solution = global_problem.getSolutionView();
+    auto local_solution = local_problem.getSolutionView();
+    for (int k = 0; k < global_solution.size(); ++k)
+        ASSERT_DOUBLE_EQ(global_solution[k], local_solution[k]);
+}
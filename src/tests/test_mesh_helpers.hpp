@@ -0,0 +1,49 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+// Helpers shared by the test fixtures
+
+#pragma once
+
+#include "triangulation.hpp"
+#include "readjson.hpp"
+
+#include <string>
+
+/**
+ * Loads the granger1m test mesh with its parameters merged in, as CHM does for a mesh with a separate parameter file.
+ * The caller still has to call init_timeseries.
+ * @param domain
+ */
+inline void load_granger1m(triangulation& domain)
+{
+    auto mesh_json = read_json("meshes/granger1m.mesh");
+    auto param_json = read_json("meshes/granger1m.param");
+    for (auto& ktr : param_json)
+    {
+        std::string key = ktr.first.data();
+        mesh_json.put_child("parameters." + key, ktr.second);
+    }
+    domain.from_json(mesh_json);
+}
@@ -117,4 +117,42 @@ TEST_F(NetCDFTest, access_time_offset)
     value = nc.get_var("t",time,150,150);
     ASSERT_DOUBLE_EQ(value, -11.3069305419921875);
 
-}
\ No newline at end of file
+}
+TEST_F(NetCDFTest, access_window)
+{
+    auto time = boost::posix_time::from_iso_string("20180115T060000");
+    auto window = nc.get_var("t",time,148,149,5,3);
+
+    ASSERT_EQ(3, window.shape()[0]);
+    ASSERT_EQ(5, window.shape()[1]);
+
+    // window is indexed [y-y0][x-x0]
+    ASSERT_DOUBLE_EQ(window[1][2], -18.4973678588867188);
+
+    for(size_t y = 0; y < 3; y++)
+        for(size_t x = 0; x < 5; x++)
+            ASSERT_DOUBLE_EQ(window[y][x], nc.get_var("t",time,148+x,149+y));
+
+    ASSERT_ANY_THROW(nc.get_var("t",time,nc.get_xsize()-1,0,2,1));
+}
+
+TEST(NetCDFColumn, length_mismatch)
+{
+    std::string file = "test_netcdf_column.nc";
+    {
+        netcdf out;
+        out.stage();
+        out.put_column("a", 10, [](size_t i) { return static_cast<double>(i); });
+        out.write_staged(file);
+    }
+
+    netcdf in;
+    in.open(file);
+
+    std::vector<double> values(10);
+    in.get_column("a", 10, [&](size_t i, double v) { values[i] = v; });
+    ASSERT_DOUBLE_EQ(values[9], 9);
+
+    // e.g., a checkpoint from a mesh with more faces
+    ASSERT_THROW(in.get_column("a", 12, [&](size_t i, double v) { values.at(i) = v; }), model_init_error);
+}
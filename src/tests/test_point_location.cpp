@@ -0,0 +1,164 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+
+#include "math/point_location.hpp"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using math::point_location::grid_index;
+
+namespace
+{
+    // n x n grid of jittered vertices, two triangles per cell. Stretched in x so the triangles are skinny
+    grid_index make_mesh(int n, std::vector<grid_index::triangle>& tri)
+    {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<double> jitter(-0.3, 0.3);
+        std::vector<double> vx((n + 1) * (n + 1)), vy((n + 1) * (n + 1));
+        for (int i = 0; i <= n; ++i)
+        {
+            for (int j = 0; j <= n; ++j)
+            {
+                bool edge = i == 0 || j == 0 || i == n || j == n;
+                vx[i * (n + 1) + j] = 10.0 * (i + (edge ? 0 : jitter(gen)));
+                vy[i * (n + 1) + j] = j + (edge ? 0 : jitter(gen));
+            }
+        }
+
+        auto v = [&](int i, int j) { return i * (n + 1) + j; };
+        auto id = [n](int i, int j, int t) { return 2 * (i * n + j) + t; };
+        tri.resize(2 * n * n);
+        std::vector<std::array<int, 3>> neighbors(2 * n * n);
+        for (int i = 0; i < n; ++i)
+        {
+            for (int j = 0; j < n; ++j)
+            {
+                int p00 = v(i, j), p10 = v(i + 1, j), p11 = v(i + 1, j + 1), p01 = v(i, j + 1);
+                tri[id(i, j, 0)] = {vx[p00], vy[p00], vx[p10], vy[p10], vx[p11], vy[p11]};
+                tri[id(i, j, 1)] = {vx[p00], vy[p00], vx[p11], vy[p11], vx[p01], vy[p01]};
+
+                // neighbour k is across the edge opposite vertex k
+                neighbors[id(i, j, 0)] = {i + 1 < n ? id(i + 1, j, 1) : -1, id(i, j, 1), j > 0 ? id(i, j - 1, 1) : -1};
+                neighbors[id(i, j, 1)] = {j + 1 < n ? id(i, j + 1, 0) : -1, i > 0 ? id(i - 1, j, 0) : -1, id(i, j, 0)};
+            }
+        }
+
+        grid_index index;
+        index.build(tri, neighbors);
+        return index;
+    }
+}
+
+TEST(PointLocation, LocateFindsContainingTriangle)
+{
+    std::vector<grid_index::triangle> tri;
+    auto index = make_mesh(40, tri);
+
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<double> x(0, 400), y(0, 40);
+    for (int k = 0; k < 10000; ++k)
+    {
+        double px = x(gen), py = y(gen);
+        int t = index.locate(px, py);
+        ASSERT_GE(t, 0);
+        EXPECT_TRUE(index.contains(t, px, py));
+    }
+
+    // vertices and the domain corners are on edges
+    EXPECT_GE(index.locate(0, 0), 0);
+    EXPECT_GE(index.locate(400, 40), 0);
+    EXPECT_GE(index.locate(tri[100][2], tri[100][3]), 0);
+}
+
+TEST(PointLocation, OutsideIsNotFound)
+{
+    std::vector<grid_index::triangle> tri;
+    auto index = make_mesh(10, tri);
+
+    EXPECT_EQ(index.locate(-1, 5), -1);
+    EXPECT_EQ(index.locate(50, 10.5), -1);
+    EXPECT_EQ(index.walk(-1, 5, 3), -1);
+}
+
+TEST(PointLocation, WalkAgreesWithLocate)
+{
+    std::vector<grid_index::triangle> tri;
+    auto index = make_mesh(40, tri);
+
+    // short steps along a ray, as the ray-marching callers do, and arbitrary far-away hints
+    int hint = index.locate(1, 1);
+    for (int k = 0; k < 1000; ++k)
+    {
+        double px = 1 + k * 0.39, py = 1 + k * 0.037;
+        hint = index.walk(px, py, hint);
+        ASSERT_GE(hint, 0);
+        EXPECT_TRUE(index.contains(hint, px, py));
+    }
+
+    std::mt19937 gen(2);
+    std::uniform_real_distribution<double> x(0, 400), y(0, 40);
+    std::uniform_int_distribution<int> t(0, static_cast<int>(tri.size()) - 1);
+    for (int k = 0; k < 1000; ++k)
+    {
+        double px = x(gen), py = y(gen);
+        int found = index.walk(px, py, t(gen), 8);
+        ASSERT_GE(found, 0);
+        EXPECT_TRUE(index.contains(found, px, py));
+    }
+}
+
+TEST(PointLocation, NearestCentroidMatchesBruteForce)
+{
+    std::vector<grid_index::triangle> tri;
+    auto index = make_mesh(30, tri);
+
+    std::mt19937 gen(3);
+    // includes queries off the mesh
+    std::uniform_real_distribution<double> x(-50, 350), y(-5, 35);
+    for (int k = 0; k < 2000; ++k)
+    {
+        double px = x(gen), py = y(gen);
+
+        double best = 1e300;
+        for (auto& v : tri)
+        {
+            double cx = (v[0] + v[2] + v[4]) / 3.0 - px;
+            double cy = (v[1] + v[3] + v[5]) / 3.0 - py;
+            best = std::min(best, cx * cx + cy * cy);
+        }
+
+        int t = index.nearest_centroid(px, py);
+        ASSERT_GE(t, 0);
+        auto& v = tri[t];
+        double cx = (v[0] + v[2] + v[4]) / 3.0 - px;
+        double cy = (v[1] + v[3] + v[5]) / 3.0 - py;
+        EXPECT_DOUBLE_EQ(cx * cx + cy * cy, best);
+    }
+}
@@ -0,0 +1,181 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "solar.hpp"
+#include "gtest/gtest.h"
+
+// The per-face solar position as solar::run computed it before the ephemeris was split out, kept as the reference
+static void reference_position(boost::posix_time::ptime time, int utc_offset,
+                               double Lat, double Lon, double Alt, double& Az, double& El)
+{
+    boost::posix_time::time_duration UTC_offset = boost::posix_time::hours(utc_offset);
+    std::tm tm = boost::posix_time::to_tm(time+UTC_offset);
+    double year =  tm.tm_year + 1900.;
+    double month =  tm.tm_mon + 1.;
+    double day =   tm.tm_mday;
+    double hour = tm.tm_hour;
+    double min = tm.tm_min;
+    double sec = tm.tm_sec;
+
+    if (month <= 2.0)
+    {
+        year = year -1.0;
+        month = month +12.0;
+    }
+
+    double jd = floor( 365.25*(year + 4716.0)) + floor( 30.6001*( month + 1.0)) + 2.0 -
+        floor( year/100.0 ) + floor( floor( year/100.0 )/4.0 ) + day - 1524.5 +
+        (hour + min/60. + sec/3600.)/24.;
+
+    double d = jd-2451543.5;
+    double w = 282.9404+4.70935*pow(10,-5)*d;
+    double e = 0.016709- 1.151*pow(10.,-9.)*d;
+    double M = fmod(356.0470+0.9856002585*d,360.0);
+    double L = w + M;
+    double oblecl = 23.4393-3.563e-7*d;
+
+    double E = M+(180./M_PI)*e*sin(M*(M_PI/180.))*(1+e*cos(M*(M_PI/180.)));
+
+    double x = cos(E*(M_PI/180.))-e;
+    double y = sin(E*(M_PI/180.))*sqrt(1.-e*e);
+
+    double r = sqrt(x*x + y*y);
+    double v = atan2(y,x)*(180./M_PI);
+
+    double lon = v + w;
+
+    double xeclip = r*cos(lon*(M_PI/180.));
+    double yeclip = r*sin(lon*(M_PI/180.));
+    double zeclip = 0.0;
+
+    double xequat = xeclip;
+    double yequat = yeclip*cos(oblecl*(M_PI/180.))+zeclip*sin(oblecl*(M_PI/180.));
+    double zequat = yeclip*sin(23.4406*(M_PI/180.))+zeclip*cos(oblecl*(M_PI/180.));
+
+    r = sqrt(xequat*xequat + yequat*yequat + zequat*zequat)-(Alt/149598000.0);
+    double RA = atan2(yequat,xequat)*(180./M_PI);
+    double delta = asin(zequat/r)*(180./M_PI);
+
+    double UTH = hour+min/60.0+sec/3600.0;
+    double GMST0=fmod(L+180.,360.)/15.;
+    double SIDTIME = GMST0 + UTH + Lon/15.;
+
+    double HA = (SIDTIME*15. - RA);
+
+    x = cos(HA*(M_PI/180.))*cos(delta*(M_PI/180.));
+    y = sin(HA*(M_PI/180.))*cos(delta*(M_PI/180.));
+    double z = sin(delta*(M_PI/180.));
+
+    double xhor = x*cos((90.-Lat)*(M_PI/180.))-z*sin((90.-Lat)*(M_PI/180.));
+    double yhor = y;
+    double zhor = x*sin((90.-Lat)*(M_PI/180.))+z*cos((90.-Lat)*(M_PI/180.));
+
+    Az = atan2(yhor,xhor)*(180./M_PI) + 180.;
+    El = asin(zhor)*(180./M_PI);
+}
+
+class SolarTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        // a year of 5 hourly steps, so every hour of the day and season is hit
+        auto t = boost::posix_time::time_from_string("2017-01-01 00:00:00");
+        for (size_t i = 0; i < 365 * 24 / 5; ++i)
+        {
+            times.push_back(t + boost::posix_time::hours(5 * i));
+        }
+    }
+
+    std::vector<boost::posix_time::ptime> times;
+    int utc_offset = 7;
+};
+
+// the split ephemeris + per-point kernel reproduces the original per-face computation
+TEST_F(SolarTest, EphemerisMatchesPerFace)
+{
+    double lats[] = {-60, -15, 0, 35.5, 51.0, 70};
+    double lons[] = {-179, -115.2, -20, 0, 45, 170};
+    double alts[] = {0, 1500, 4000};
+
+    for (auto& t : times)
+    {
+        auto eph = solar::compute_ephemeris(t, utc_offset);
+
+        for (auto lat : lats)
+        {
+            for (auto lon : lons)
+            {
+                for (auto alt : alts)
+                {
+                    double az_ref, el_ref;
+                    reference_position(t, utc_offset, lat, lon, alt, az_ref, el_ref);
+
+                    double az, el;
+                    solar::position(eph, sin(lat * M_PI / 180.), cos(lat * M_PI / 180.), lon, alt, az, el);
+
+                    ASSERT_NEAR(el, el_ref, 1e-8);
+
+                    // azimuth is ill defined with the sun at the zenith
+                    if (el_ref < 89.9)
+                        ASSERT_NEAR(az, az_ref, 1e-8);
+                }
+            }
+        }
+    }
+}
+
+// using the centroid hour angle over a small domain stays within the requested tolerance in elevation
+TEST_F(SolarTest, CentroidHourAngleBounded)
+{
+    // ~15 km wide domain in the Rockies
+    double lon_min = -115.3;
+    double lon_max = -115.1;
+    double tolerance = (lon_max - lon_min) / 2.0;
+    double lon_c = (lon_max + lon_min) / 2.0;
+    double alt = 2000;
+
+    for (auto& t : times)
+    {
+        auto eph = solar::compute_ephemeris(t, utc_offset);
+
+        for (double lat = 50.8; lat <= 51.2; lat += 0.1)
+        {
+            for (double lon = lon_min; lon <= lon_max + 1e-9; lon += 0.05)
+            {
+                double az_ref, el_ref;
+                reference_position(t, utc_offset, lat, lon, alt, az_ref, el_ref);
+
+                double az, el;
+                solar::position(eph, sin(lat * M_PI / 180.), cos(lat * M_PI / 180.), lon_c, alt, az, el);
+
+                ASSERT_LE(std::fabs(el - el_ref), tolerance);
+            }
+        }
+    }
+}
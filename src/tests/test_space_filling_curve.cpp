@@ -0,0 +1,105 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+#include "math/space_filling_curve.hpp"
+#include "gtest/gtest.h"
+
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <set>
+
+namespace sfc = math::space_filling_curve;
+
+TEST(SpaceFillingCurve, HilbertVisitsGridCellsAsAPath)
+{
+    // the first n*n keys fill the n x n corner of the grid, and consecutive keys are always edge neighbours
+    const uint32_t n = 16;
+    std::vector<std::array<uint32_t, 2>> cell(n * n);
+    for (uint32_t i = 0; i < n; ++i)
+    {
+        for (uint32_t j = 0; j < n; ++j)
+        {
+            auto key = sfc::hilbert_key(i, j);
+            ASSERT_LT(key, n * n);
+            cell[key] = {i, j};
+        }
+    }
+
+    for (size_t k = 1; k < cell.size(); ++k)
+    {
+        int d = std::abs(int(cell[k][0]) - int(cell[k - 1][0])) + std::abs(int(cell[k][1]) - int(cell[k - 1][1]));
+        EXPECT_EQ(d, 1) << "step " << k;
+    }
+}
+
+TEST(SpaceFillingCurve, OrderingIsAPermutation)
+{
+    std::vector<double> x, y;
+    for (int i = 0; i < 1000; ++i)
+    {
+        x.push_back(std::sin(i * 0.37) * 1e3 + 5e5);
+        y.push_back(std::cos(i * 0.91) * 2e3 + 5.6e6);
+    }
+
+    for (auto c : {sfc::curve::hilbert, sfc::curve::morton})
+    {
+        auto order = sfc::ordering(x, y, c);
+        ASSERT_EQ(order.size(), x.size());
+        EXPECT_EQ(std::set<size_t>(order.begin(), order.end()).size(), x.size());
+    }
+}
+
+TEST(SpaceFillingCurve, KeysAreUnique)
+{
+    std::set<uint64_t> hilbert, morton;
+    for (uint32_t i = 0; i < 64; ++i)
+    {
+        for (uint32_t j = 0; j < 64; ++j)
+        {
+            hilbert.insert(sfc::hilbert_key(i, j));
+            morton.insert(sfc::morton_key(i, j));
+        }
+    }
+    EXPECT_EQ(hilbert.size(), 64 * 64);
+    EXPECT_EQ(morton.size(), 64 * 64);
+
+    EXPECT_EQ(sfc::morton_key(0, 0), 0);
+    EXPECT_EQ(sfc::morton_key(1, 0), 1);
+    EXPECT_EQ(sfc::morton_key(0, 1), 2);
+    EXPECT_EQ(sfc::morton_key(3, 3), 15);
+}
+
+TEST(SpaceFillingCurve, NoneIsIdentity)
+{
+    std::vector<double> x = {3, 1, 2}, y = {0, 5, 1};
+    auto order = sfc::ordering(x, y, sfc::curve::none);
+    EXPECT_EQ(order, (std::vector<size_t>{0, 1, 2}));
+
+    sfc::curve c;
+    EXPECT_TRUE(sfc::from_string("morton", c));
+    EXPECT_EQ(c, sfc::curve::morton);
+    EXPECT_FALSE(sfc::from_string("peano", c));
+}
@@ -0,0 +1,134 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+// The precomputed per-direction tables of fast_shadow and fetchr must agree with the per-timestep search along the
+// directions they were built for
+
+#include "modules/fast_shadow.hpp"
+#include "modules/fetchr.hpp"
+#include "triangulation.hpp"
+#include "test_mesh_helpers.hpp"
+#include "gtest/gtest.h"
+
+#include <boost/make_shared.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+class TerrainTableTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        domain = boost::make_shared<triangulation>();
+        load_granger1m(*domain);
+
+        std::set<std::string> variables = {"solar_az", "solar_el", "shadow", "vw_dir", "fetch"};
+        domain->init_timeseries(variables);
+    }
+
+    mesh domain;
+};
+
+TEST_F(TerrainTableTest, HorizonTableMatchesSearch)
+{
+    const int bins = 72;
+
+    config_file table_cfg;
+    table_cfg.put("azimuth_bins", bins);
+    fast_shadow table(table_cfg);
+    table.init(domain);
+
+    config_file search_cfg;
+    search_cfg.put("azimuth_bins", 0);
+    fast_shadow search(search_cfg);
+    search.init(domain);
+
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+        for (int b = 0; b < bins; b++)
+        {
+            for (double el : {2.0, 5.0, 10.0, 20.0})
+            {
+                (*face)["solar_az"_s] = b * 360.0 / bins;
+                (*face)["solar_el"_s] = el;
+
+                table.run(face);
+                double table_shadow = (*face)["shadow"_s];
+                search.run(face);
+                double search_shadow = (*face)["shadow"_s];
+
+                ASSERT_EQ(search_shadow, table_shadow) << "face " << i << " azimuth " << b * 360.0 / bins << " el " << el;
+            }
+        }
+    }
+}
+
+TEST_F(TerrainTableTest, FetchTableMatchesSearch)
+{
+    const int bins = 72;
+
+    config_file table_cfg;
+    table_cfg.put("direction_bins", bins);
+    table_cfg.put("incl_veg", false);
+    fetchr table(table_cfg);
+    table.init(domain);
+
+    config_file search_cfg;
+    search_cfg.put("direction_bins", 0);
+    search_cfg.put("incl_veg", false);
+    fetchr search(search_cfg);
+    search.init(domain);
+
+    for (size_t i = 0; i < domain->size_faces(); i++)
+    {
+        auto face = domain->face(i);
+        for (int b = 0; b < bins; b++)
+        {
+            (*face)["vw_dir"_s] = b * 360.0 / bins;
+
+            table.run(face);
+            double table_fetch = (*face)["fetch"_s];
+            search.run(face);
+            double search_fetch = (*face)["fetch"_s];
+
+            // both are a whole number of steps, so exact
+            ASSERT_EQ(search_fetch, table_fetch) << "face " << i << " direction " << b * 360.0 / bins;
+        }
+
+        // between bins the table interpolates the fetch of the neighbouring directions
+        (*face)["vw_dir"_s] = 2.5;
+        table.run(face);
+        double mid = (*face)["fetch"_s];
+        (*face)["vw_dir"_s] = 0;
+        search.run(face);
+        double f0 = (*face)["fetch"_s];
+        (*face)["vw_dir"_s] = 5;
+        search.run(face);
+        double f1 = (*face)["fetch"_s];
+        ASSERT_DOUBLE_EQ(0.5 * (f0 + f1), mid);
+    }
+}
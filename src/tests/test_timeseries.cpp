@@ -24,8 +24,15 @@
 
 
 #include "timeseries.hpp"
+#include "timeseries/timeseries_writer.hpp"
+#include "test_mesh_helpers.hpp"
 #include "gtest/gtest.h"
 
+#include <boost/algorithm/string.hpp>
+#include <boost/filesystem.hpp>
+
+#include <fstream>
+
 
 class TimeseriesTest : public testing::Test
 {
@@ -385,4 +392,197 @@ TEST_F(TimeseriesTest, Init_at_1ts)
     ASSERT_EQ(dates.size(),1);
     ASSERT_EQ(dates.back(),"20051001T010000");
 
-}
\ No newline at end of file
+}
+
+class TimeseriesWriterTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        logging::core::get()->set_logging_enabled(false);
+
+        load_granger1m(mesh);
+        mesh.init_timeseries(variables);
+    }
+
+    timeseries_writer::point make_point(const std::string& name, const std::string& file, size_t face,
+                                        timeseries_writer::format fmt = timeseries_writer::format::csv)
+    {
+        return timeseries_writer::point{name, file, fmt, mesh.face(face), -115.2, 60.9};
+    }
+
+    // value of variable k at point p on step t, exact in the csv output
+    static double value(size_t t, size_t p, size_t k)
+    {
+        return 1000.0 * t + 10.0 * p + k;
+    }
+
+    // sets the variables of every point's face for step t, then records it
+    void step(timeseries_writer& writer, const std::vector<size_t>& faces, size_t t)
+    {
+        for (size_t p = 0; p < faces.size(); ++p)
+        {
+            size_t k = 0;
+            for (auto& v : variables)
+                (*mesh.face(faces[p]))[v] = value(t, p, k++);
+        }
+        writer.record(start + boost::posix_time::hours(t));
+    }
+
+    static std::vector<std::vector<std::string>> read_csv(const std::string& file)
+    {
+        std::vector<std::vector<std::string>> rows;
+        std::ifstream in(file);
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::vector<std::string> row;
+            boost::split(row, line, boost::is_any_of(","));
+            rows.push_back(row);
+        }
+        return rows;
+    }
+
+    void check_csv(size_t queue_depth)
+    {
+        // not a multiple of the batch size, so the last batch is partial
+        const size_t batch_size = 5;
+        const size_t nsteps = 23;
+        std::vector<size_t> faces = {0, 17};
+
+        {
+            timeseries_writer writer(mesh, variables,
+                                     {make_point("a", "test_ts_writer_a.csv", faces[0]),
+                                      make_point("b", "test_ts_writer_b.csv", faces[1])},
+                                     batch_size, queue_depth);
+            for (size_t t = 0; t < nsteps; ++t)
+                step(writer, faces, t);
+            writer.finish();
+        }
+
+        for (size_t p = 0; p < faces.size(); ++p)
+        {
+            auto rows = read_csv(p == 0 ? "test_ts_writer_a.csv" : "test_ts_writer_b.csv");
+            ASSERT_EQ(nsteps + 1, rows.size());
+
+            // variables follow the std::set order
+            std::vector<std::string> header = {"datetime", "rh", "t", "u"};
+            ASSERT_EQ(header, rows[0]);
+
+            for (size_t t = 0; t < nsteps; ++t)
+            {
+                auto& row = rows[t + 1];
+                ASSERT_EQ(header.size(), row.size());
+                ASSERT_EQ(boost::posix_time::to_iso_string(start + boost::posix_time::hours(t)), row[0]);
+                for (size_t k = 0; k < variables.size(); ++k)
+                    ASSERT_DOUBLE_EQ(value(t, p, k), std::stod(row[k + 1]));
+            }
+        }
+
+        boost::filesystem::remove("test_ts_writer_a.csv");
+        boost::filesystem::remove("test_ts_writer_b.csv");
+    }
+
+    void check_netcdf(size_t queue_depth)
+    {
+        const size_t batch_size = 5;
+        const size_t nsteps = 23;
+        std::vector<size_t> faces = {0, 17};
+        std::vector<std::string> files = {"test_ts_writer_a.nc", "test_ts_writer_b.nc"};
+
+        {
+            timeseries_writer writer(mesh, variables,
+                                     {make_point("a", files[0], faces[0], timeseries_writer::format::netcdf),
+                                      make_point("b", files[1], faces[1], timeseries_writer::format::netcdf)},
+                                     batch_size, queue_depth);
+            for (size_t t = 0; t < nsteps; ++t)
+                step(writer, faces, t);
+            writer.finish();
+        }
+
+        static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+
+        for (size_t p = 0; p < faces.size(); ++p)
+        {
+            {
+                netCDF::NcFile nc(files[p], netCDF::NcFile::read);
+
+                // every batch was appended along the unlimited time dimension
+                auto time_dim = nc.getDim("time");
+                ASSERT_TRUE(time_dim.isUnlimited());
+                ASSERT_EQ(nsteps, time_dim.getSize());
+
+                std::vector<long long> time(nsteps);
+                nc.getVar("time").getVar(time.data());
+                for (size_t t = 0; t < nsteps; ++t)
+                    ASSERT_EQ((start + boost::posix_time::hours(t) - epoch).total_seconds(), time[t]);
+
+                size_t k = 0;
+                for (auto& v : variables)
+                {
+                    std::vector<double> values(nsteps);
+                    nc.getVar(v).getVar(values.data());
+                    for (size_t t = 0; t < nsteps; ++t)
+                        ASSERT_DOUBLE_EQ(value(t, p, k), values[t]) << v << " at step " << t;
+                    ++k;
+                }
+            }
+            boost::filesystem::remove(files[p]);
+        }
+    }
+
+    // writes to a file that always fails, e.g., a full disk, and returns true if the error reached the caller
+    bool write_fails(size_t queue_depth)
+    {
+        std::vector<size_t> faces = {0};
+        timeseries_writer writer(mesh, variables, {make_point("full", "/dev/full", faces[0])}, 2, queue_depth);
+        try
+        {
+            for (size_t t = 0; t < 20; ++t)
+                step(writer, faces, t);
+            writer.finish();
+        }
+        catch (const file_write_error&)
+        {
+            // later calls keep failing
+            EXPECT_THROW(step(writer, faces, 20), file_write_error);
+            EXPECT_THROW(writer.finish(), file_write_error);
+            return true;
+        }
+        return false;
+    }
+
+    std::set<std::string> variables = {"t", "rh", "u"};
+    boost::posix_time::ptime start = boost::posix_time::from_iso_string("20180115T060000");
+    triangulation mesh;
+};
+
+TEST_F(TimeseriesWriterTest, CsvSynchronous)
+{
+    check_csv(0);
+}
+
+TEST_F(TimeseriesWriterTest, CsvBackground)
+{
+    check_csv(2);
+}
+
+TEST_F(TimeseriesWriterTest, NetcdfSynchronous)
+{
+    check_netcdf(0);
+}
+
+TEST_F(TimeseriesWriterTest, NetcdfBackground)
+{
+    check_netcdf(2);
+}
+
+TEST_F(TimeseriesWriterTest, WriteErrorIsRethrown)
+{
+    if (!boost::filesystem::exists("/dev/full"))
+        return;
+
+    ASSERT_TRUE(write_fails(0));
+    ASSERT_TRUE(write_fails(2));
+}
@@ -0,0 +1,168 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+// The sun-view depth buffer behind Marsh_shading_iswr's zbuffer method, checked on a synthetic ridge where the shadow
+// can be worked out by hand
+
+#include "math/zbuffer.hpp"
+#include "gtest/gtest.h"
+
+#include <cmath>
+
+// A north-south ridge on flat ground: a triangular profile of height H and half-width w centred at x = xr, on a grid of
+// spacing dx, two triangles per grid cell. The profile breaks fall on grid lines, so a face centroid lies on the profile.
+class ZbufferTest : public testing::Test
+{
+  protected:
+
+    virtual void SetUp()
+    {
+        H = 20;
+        w = 20;
+        xr = 100;
+        dx = 2;
+        nx = 100; // 200 m east-west
+        ny = 50;  // 100 m north-south
+    }
+
+    double height(double x)
+    {
+        return H * std::max(0.0, 1.0 - std::fabs(x - xr) / w);
+    }
+
+    std::vector<double> ridge(double x_offset = 0, double y_offset = 0)
+    {
+        std::vector<double> xyz;
+        auto push = [&](double x, double y)
+        {
+            xyz.push_back(x + x_offset);
+            xyz.push_back(y + y_offset);
+            xyz.push_back(height(x));
+        };
+
+        for (size_t j = 0; j < ny; j++)
+        {
+            for (size_t i = 0; i < nx; i++)
+            {
+                double x0 = i * dx, x1 = (i + 1) * dx;
+                double y0 = j * dx, y1 = (j + 1) * dx;
+
+                push(x0, y0); push(x1, y0); push(x1, y1);
+                push(x0, y0); push(x1, y1); push(x0, y1);
+            }
+        }
+        return xyz;
+    }
+
+    static double centroid_x(const std::vector<double>& xyz, size_t t)
+    {
+        return (xyz[9 * t] + xyz[9 * t + 3] + xyz[9 * t + 6]) / 3.0;
+    }
+
+    double H, w, xr, dx;
+    size_t nx, ny;
+};
+
+// Sun low in the east: the lee slope and the ground out to H / tan(elevation) west of the crest are shadowed,
+// everything else is lit. Faces within a couple of cells of the shadow edge are left out.
+TEST_F(ZbufferTest, RidgeShadowMatchesGeometry)
+{
+    auto xyz = ridge();
+    double elevation = 20;
+    double shadow_end = xr - H / std::tan(elevation * M_PI / 180.0); // ~45 m
+
+    math::shading::zbuffer zb;
+    std::vector<int> shadow;
+    std::vector<double> z_prime;
+    zb.compute(xyz, 90, elevation, shadow, z_prime);
+
+    ASSERT_EQ(shadow.size(), xyz.size() / 9);
+
+    size_t nshadowed = 0;
+    for (size_t t = 0; t < shadow.size(); t++)
+    {
+        double x = centroid_x(xyz, t);
+
+        if (x > shadow_end + 2 * dx && x < xr - dx)
+        {
+            EXPECT_EQ(shadow[t], 1) << "face " << t << " at x = " << x;
+            nshadowed++;
+        }
+        else if (x < shadow_end - 2 * dx || x > xr + dx)
+        {
+            EXPECT_EQ(shadow[t], 0) << "face " << t << " at x = " << x;
+        }
+    }
+    EXPECT_GT(nshadowed, 0);
+}
+
+// The mirror image, sun in the west
+TEST_F(ZbufferTest, RidgeShadowFollowsAzimuth)
+{
+    auto xyz = ridge();
+    double elevation = 20;
+    double shadow_end = xr + H / std::tan(elevation * M_PI / 180.0);
+
+    math::shading::zbuffer zb;
+    std::vector<int> shadow;
+    std::vector<double> z_prime;
+    zb.compute(xyz, 270, elevation, shadow, z_prime);
+
+    for (size_t t = 0; t < shadow.size(); t++)
+    {
+        double x = centroid_x(xyz, t);
+
+        if (x > xr + dx && x < shadow_end - 2 * dx)
+            EXPECT_EQ(shadow[t], 1) << "face " << t << " at x = " << x;
+        else if (x < xr - dx || x > shadow_end + 2 * dx)
+            EXPECT_EQ(shadow[t], 0) << "face " << t << " at x = " << x;
+    }
+}
+
+// Sun steeper than the lee slope: nothing occludes anything, so nothing may shadow itself or its neighbours
+TEST_F(ZbufferTest, HighSunNoSelfShadow)
+{
+    auto xyz = ridge();
+
+    math::shading::zbuffer zb;
+    std::vector<int> shadow;
+    std::vector<double> z_prime;
+    zb.compute(xyz, 90, 60, shadow, z_prime);
+
+    for (size_t t = 0; t < shadow.size(); t++)
+        EXPECT_EQ(shadow[t], 0) << "face " << t << " at x = " << centroid_x(xyz, t);
+}
+
+// UTM sized coordinates give the same shadows
+TEST_F(ZbufferTest, LargeCoordinates)
+{
+    math::shading::zbuffer zb;
+    std::vector<int> local, utm;
+    std::vector<double> z_prime;
+
+    zb.compute(ridge(), 90, 20, local, z_prime);
+    zb.compute(ridge(500000, 5600000), 90, 20, utm, z_prime);
+
+    EXPECT_EQ(local, utm);
+}
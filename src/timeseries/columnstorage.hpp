@@ -0,0 +1,325 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+#pragma once
+
+#include "timeseries/variablestorage.hpp"
+
+#include "logger.hpp"
+#include "exception.hpp"
+
+#include <string>
+#include <vector>
+#include <set>
+#include <limits>
+
+/**
+ * Resolved reference to a variable's column in a columnstorage. Obtain it once (e.g., in a module's init) so that
+ * per-face access is a direct indexed load instead of a hash lookup.
+ */
+struct var_handle
+{
+    size_t column = std::numeric_limits<size_t>::max();
+
+    bool valid() const
+    {
+        return column != std::numeric_limits<size_t>::max();
+    }
+};
+
+/**
+ * Structure-of-arrays storage for a set of variables over many cells (e.g., every face in the mesh).
+ * Each variable is one contiguous column of ncells values. The variable -> column mapping is resolved by
+ * the same perfect hash that variablestorage uses, but is held once for the whole mesh instead of once per face.
+ *
+ * Cell i of column c is stored at c*ncells + i, so a column can be handed directly to a vectorized loop.
+ */
+template<typename T = double>
+class columnstorage
+{
+  public:
+
+    /**
+     * Non-owning view over one variable's column. Valid until the next call to init.
+     */
+    struct column_view
+    {
+        T* data;
+        size_t size;
+
+        T* begin() { return data; }
+        T* end() { return data + size; }
+        T& operator[](const size_t& i) { return data[i]; }
+    };
+
+    columnstorage();
+
+    /// Initialize the storage with a set of variables, each with ncells entries. Values default to -9999.
+    /// Any previous contents are discarded.
+    /// @param variables
+    /// @param ncells
+    void init(std::set<std::string>& variables, size_t ncells);
+
+    /// Column index of a variable. Use _s for compile-time hash.
+    /// Throws if not found or init not yet called.
+    /// @param hash
+    /// @return
+    size_t index(const uint64_t& hash);
+
+    /// Column index of a variable.
+    /// Throws if not found or init not yet called.
+    /// @param variable
+    /// @return
+    size_t index(const std::string& variable);
+
+    /// Handle to a variable's column. Use _s for compile-time hash.
+    /// Throws if not found or init not yet called.
+    /// @param hash
+    /// @return
+    var_handle handle(const uint64_t& hash);
+
+    /// Handle to a variable's column.
+    /// Throws if not found or init not yet called.
+    /// @param variable
+    /// @return
+    var_handle handle(const std::string& variable);
+
+    /// Handle a variable will have once a columnstorage is initialized with this set of variables.
+    /// Allows handles to be resolved before the columns are allocated.
+    /// Throws if the variable is not in the set.
+    /// @param variables
+    /// @param variable
+    /// @return
+    static var_handle layout_handle(const std::set<std::string>& variables, const std::string& variable);
+
+    /// Get and set the variable of a cell via a resolved handle. Only checked if SAFE_CHECKS is defined.
+    /// @param h
+    /// @param cell
+    /// @return
+    T& operator()(const var_handle& h, const size_t& cell)
+    {
+#ifdef SAFE_CHECKS
+        if (h.column >= _names.size() || cell >= _ncells)
+            BOOST_THROW_EXCEPTION(module_error() << errstr_info("Invalid variable handle " + std::to_string(h.column) +
+                                                               " or cell " + std::to_string(cell) + "."));
+#endif
+        return _data[h.column * _ncells + cell];
+    }
+
+    /// Direct access to a cell in a previously resolved column. No checks are done.
+    /// @param column Column index from index()
+    /// @param cell
+    /// @return
+    T& operator()(const size_t& column, const size_t& cell)
+    {
+        return _data[column * _ncells + cell];
+    }
+
+    /// Get and set the variable of a cell. Use _s for compile-time hash.
+    /// @param hash
+    /// @param cell
+    /// @return
+    T& at(const uint64_t& hash, const size_t& cell);
+
+    /// Get and set the variable of a cell.
+    /// @param variable
+    /// @param cell
+    /// @return
+    T& at(const std::string& variable, const size_t& cell);
+
+    /// Returns a view over the full column
+    /// @param column Column index from index()
+    /// @return
+    column_view column(const size_t& column);
+
+    /// Returns a view over the full column
+    /// @param h
+    /// @return
+    column_view column(const var_handle& h);
+
+    /// Determine if a variable is in the storage. Uses _s for compile time hash
+    /// @param hash
+    /// @return
+    bool has(const uint64_t& hash);
+
+    /// Determine if a variable is in the storage.
+    /// @param variable
+    /// @return
+    bool has(const std::string& variable);
+
+    /// Returns a list of the variables stored, in column order
+    /// @return
+    std::vector<std::string> variables();
+
+    /// Returns the number of variables stored
+    /// @return
+    size_t size();
+
+    /// Returns the number of cells in each column
+    /// @return
+    size_t ncells();
+
+  private:
+
+    // sets the default value of newly created variables
+    T get_default_value();
+
+    // variable -> column index
+    variablestorage<size_t> _columns;
+    std::vector<std::string> _names;
+
+    std::vector<T> _data;
+    size_t _ncells;
+};
+
+template<typename T>
+columnstorage<T>::columnstorage()
+{
+    _ncells = 0;
+}
+
+template<typename T>
+void columnstorage<T>::init(std::set<std::string>& variables, size_t ncells)
+{
+    _columns.init(variables);
+    _ncells = ncells;
+
+    // column order follows the std::set order so it is deterministic across ranks
+    _names.assign(variables.begin(), variables.end());
+    for (size_t i = 0; i < _names.size(); ++i)
+    {
+        _columns[_names[i]] = i;
+    }
+
+    _data.assign(_names.size() * _ncells, get_default_value());
+}
+
+template<typename T>
+size_t columnstorage<T>::index(const uint64_t& hash)
+{
+    return _columns[hash];
+}
+
+template<typename T>
+size_t columnstorage<T>::index(const std::string& variable)
+{
+    return _columns[variable];
+}
+
+template<typename T>
+var_handle columnstorage<T>::handle(const uint64_t& hash)
+{
+    var_handle h;
+    h.column = index(hash);
+    return h;
+}
+
+template<typename T>
+var_handle columnstorage<T>::handle(const std::string& variable)
+{
+    var_handle h;
+    h.column = index(variable);
+    return h;
+}
+
+template<typename T>
+var_handle columnstorage<T>::layout_handle(const std::set<std::string>& variables, const std::string& variable)
+{
+    // must match the column order used by init
+    auto it = variables.find(variable);
+    if (it == variables.end())
+        BOOST_THROW_EXCEPTION(module_error() << errstr_info("Variable " + variable + " does not exist."));
+
+    var_handle h;
+    h.column = std::distance(variables.begin(), it);
+    return h;
+}
+
+template<typename T>
+T& columnstorage<T>::at(const uint64_t& hash, const size_t& cell)
+{
+    return (*this)(index(hash), cell);
+}
+
+template<typename T>
+T& columnstorage<T>::at(const std::string& variable, const size_t& cell)
+{
+    return (*this)(index(variable), cell);
+}
+
+template<typename T>
+typename columnstorage<T>::column_view columnstorage<T>::column(const size_t& column)
+{
+    if (column >= _names.size())
+        BOOST_THROW_EXCEPTION(module_error() << errstr_info("Column " + std::to_string(column) + " does not exist."));
+
+    return column_view{_data.data() + column * _ncells, _ncells};
+}
+
+template<typename T>
+typename columnstorage<T>::column_view columnstorage<T>::column(const var_handle& h)
+{
+    return column(h.column);
+}
+
+template<typename T>
+bool columnstorage<T>::has(const uint64_t& hash)
+{
+    return _columns.has(hash);
+}
+
+template<typename T>
+bool columnstorage<T>::has(const std::string& variable)
+{
+    return _columns.has(variable);
+}
+
+template<typename T>
+std::vector<std::string> columnstorage<T>::variables()
+{
+    return _names;
+}
+
+template<typename T>
+size_t columnstorage<T>::size()
+{
+    return _names.size();
+}
+
+template<typename T>
+size_t columnstorage<T>::ncells()
+{
+    return _ncells;
+}
+
+template<typename T> inline
+T columnstorage<T>::get_default_value()
+{
+    return T{};
+}
+
+template<> inline
+double columnstorage<double>::get_default_value()
+{
+    return -9999;
+}
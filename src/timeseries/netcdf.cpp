@@ -28,18 +28,39 @@
 netcdf::netcdf()
 {
     _is_open = false;
+    _deflate_level = 0;
+    _chunk_size = 0;
+    _staging = false;
 }
 netcdf::~netcdf()
 {
+    // close under the lock so a background reader on another file isn't in the library at the same time
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+    _data.close();
+}
 
+std::recursive_mutex& netcdf::lib_mutex()
+{
+    static std::recursive_mutex m;
+    return m;
 }
+
  void netcdf::add_dim1D(const std::string& var, size_t length)
  {
+     std::lock_guard<std::recursive_mutex> lock(lib_mutex());
      auto nTri = _data.addDim(var, length);
      _dimVector.push_back(nTri);
  }
 void netcdf::create_variable1D( const std::string& var, size_t length)
 {
+    if(_staging)
+    {
+        _staged[var].resize(length, -9999);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
     //only create the dim and variables once
     try
     {
@@ -54,6 +75,17 @@ void netcdf::create_variable1D( const std::string& var, size_t length)
     try
     {
         auto nc_var = _data.addVar(var.c_str(), netCDF::ncDouble, _dimVector);
+
+        if(_chunk_size > 0)
+        {
+            std::vector<size_t> chunks{std::min(_chunk_size, length)};
+            nc_var.setChunking(netCDF::NcVar::nc_CHUNKED, chunks);
+        }
+
+        if(_deflate_level > 0)
+        {
+            nc_var.setCompression(true, true, _deflate_level);
+        }
     }
     catch(netCDF::exceptions::NcNameInUse& e)
     {
@@ -63,6 +95,27 @@ void netcdf::create_variable1D( const std::string& var, size_t length)
 
 }
 
+void netcdf::stage()
+{
+    _staged.clear();
+    _staging = true;
+}
+
+void netcdf::write_staged(const std::string& file)
+{
+    _staging = false;
+
+    // create and put_var1D each hold the library lock only for their own call, so a checkpoint being written on a
+    // background thread lets the forcing and timeseries output threads in between variables
+    create(file);
+
+    for (auto& itr : _staged)
+    {
+        put_var1D(itr.first, std::move(itr.second));
+    }
+    _staged.clear();
+}
+
 netCDF::NcFile& netcdf::get_ncfile()
 {
     return _data;
@@ -70,6 +123,18 @@ netCDF::NcFile& netcdf::get_ncfile()
 
 void netcdf::put_var1D(const std::string& var, size_t index, double value)
 {
+    if(_staging)
+    {
+        auto itr = _staged.find(var);
+        if(itr == _staged.end() || index >= itr->second.size())
+        {
+            BOOST_THROW_EXCEPTION(forcing_error() << errstr_info("Variable not initialized: " + var));
+        }
+        itr->second[index] = value;
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
     auto vars = _data.getVars();
 
     auto itr = vars.find(var);
@@ -91,17 +156,87 @@ void netcdf::put_var1D(const std::string& var, size_t index, double value)
 
 }
 
+void netcdf::put_var1D(const std::string& var, std::vector<double> values)
+{
+    if(_staging)
+    {
+        _staged[var] = std::move(values);
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
+    create_variable1D(var, values.size());
+
+    auto nc_var = _data.getVar(var);
+    if(nc_var.isNull())
+    {
+        BOOST_THROW_EXCEPTION(forcing_error() << errstr_info("Variable not initialized: " + var));
+    }
+
+    std::vector<size_t> startp{0};
+    std::vector<size_t> countp{values.size()};
+
+    nc_var.putVar(startp, countp, values.data());
+}
+
+std::vector<double> netcdf::get_var1D(const std::string& var)
+{
+    std::vector<double> values;
+    double fill_value = -9999;
+
+    {
+        std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
+        auto nc_var = _data.getVar(var);
+        if(nc_var.isNull())
+        {
+            BOOST_THROW_EXCEPTION(forcing_error() << errstr_info("Variable " + var + " does not exist in the NetCDF file."));
+        }
+
+        values.resize(nc_var.getDim(0).getSize());
+        nc_var.getVar(values.data());
+
+        fill_value = get_fillvalue(nc_var);
+    }
+
+    for(auto& v : values)
+    {
+        if( v == fill_value)
+            v = std::nan("nan");
+    }
+
+    return values;
+}
+
+void netcdf::set_compression(int deflate_level, size_t chunk_size)
+{
+    if(deflate_level < 0 || deflate_level > 9)
+    {
+        BOOST_THROW_EXCEPTION(config_error() << errstr_info("NetCDF deflate level must be on [0,9]"));
+    }
+
+    _deflate_level = deflate_level;
+    _chunk_size = chunk_size;
+}
+
 void netcdf::create(const std::string& file)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+    _file = file;
     _data.open(file.c_str(), netCDF::NcFile::replace);
 
 }
 void netcdf::open(const std::string &file)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+    _file = file;
     _data.open(file.c_str(), netCDF::NcFile::read);
 }
 void netcdf::open_GEM(const std::string &file)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+    _file = file;
     _data.open(file.c_str(), netCDF::NcFile::read);
 
     // gem netcdf files have 1 coordinate, datetime
@@ -384,6 +519,8 @@ double netcdf::get_fillvalue(const netCDF::NcVar& var)
 
 double netcdf::get_var1D(std::string var, size_t index)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
     std::vector<size_t> startp, countp;
 
     startp.push_back(index);
@@ -409,6 +546,8 @@ double netcdf::get_var1D(std::string var, size_t index)
 
 netcdf::data netcdf::get_var2D(std::string var)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
     std::vector<size_t> startp, countp;
 
     startp.push_back(0);
@@ -439,6 +578,8 @@ netcdf::data netcdf::get_var2D(std::string var)
 
 double netcdf::get_var2D(std::string var, size_t x, size_t y)
 {
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
     std::vector<size_t> startp, countp;
 
     startp.push_back(y);
@@ -509,15 +650,15 @@ double netcdf::get_var(std::string var, size_t timestep, size_t x, size_t y)
     // Read the data one record at a time.
     startp[0] = timestep;
 
+    std::lock_guard<std::recursive_mutex> lock(lib_mutex());
+
     auto vars = _data.getVars();
 
     double val=-9999;
 
     auto itr = vars.find(var);
-#pragma omp critical
-    {
-        itr->second.getVar(startp, countp, &val);
-    }
+    itr->second.getVar(startp, countp, &val);
+
     double fill_value = get_fillvalue(itr->second);
 
     if(val == fill_value)
@@ -528,36 +669,49 @@ double netcdf::get_var(std::string var, size_t timestep, size_t x, size_t y)
 
 netcdf::data netcdf::get_var(std::string var, size_t timestep)
 {
-    std::vector<size_t> startp, countp;
-    startp.push_back(0);
-    startp.push_back(0);
-    startp.push_back(0);
-
-    countp.push_back(1);
-    countp.push_back(ygrid);
-    countp.push_back(xgrid);
+    return get_var(var, timestep, 0, 0, xgrid, ygrid);
+}
 
-    // Read the data one record at a time.
-    startp[0] = timestep;
+netcdf::data netcdf::get_var(std::string var, size_t timestep, size_t x0, size_t y0, size_t nx, size_t ny)
+{
+    if( x0 + nx > xgrid || y0 + ny > ygrid)
+    {
+        BOOST_THROW_EXCEPTION(forcing_error() << errstr_info("Requested window for " + var + " is outside of the grid."));
+    }
 
-    auto vars = _data.getVars();
+    std::vector<size_t> startp, countp;
+    startp.push_back(timestep);
+    startp.push_back(y0);
+    startp.push_back(x0);
 
+    countp.push_back(1);
+    countp.push_back(ny);
+    countp.push_back(nx);
 
-    netcdf::data array(boost::extents[ygrid][xgrid]);
+    netcdf::data array(boost::extents[ny][nx]);
+    double fill_value = -9999;
 
-    auto itr = vars.find(var);
-    itr->second.getVar(startp,countp, array.data());
+    {
+        std::lock_guard<std::recursive_mutex> lock(lib_mutex());
 
-    double fill_value = get_fillvalue(itr->second);
+        auto vars = _data.getVars();
+        auto itr = vars.find(var);
+        if(itr == vars.end())
+        {
+            BOOST_THROW_EXCEPTION(forcing_error() << errstr_info("Variable " + var + " does not exist in the NetCDF file."));
+        }
 
+        // the whole window is read in one call
+        itr->second.getVar(startp, countp, array.data());
+        fill_value = get_fillvalue(itr->second);
+    }
 
-    for(size_t i =0; i< array.shape()[0]; i++)
+    // the fill value replacement doesn't need to hold the lock
+    double* d = array.data();
+    for(size_t i = 0; i < array.num_elements(); i++)
     {
-        for(size_t j =0; j< array.shape()[1]; j++)
-        {
-            if (array[i][j] == fill_value)
-                array[i][j] = std::nan("nan");
-        }
+        if (d[i] == fill_value)
+            d[i] = std::nan("nan");
     }
 
     return array;
@@ -579,4 +733,13 @@ netcdf::data netcdf::get_var(std::string var, boost::posix_time::ptime timestep)
     auto offset = diff.total_seconds() / _timestep.total_seconds();
 
     return get_var(var, offset);
+}
+
+netcdf::data netcdf::get_var(std::string var, boost::posix_time::ptime timestep, size_t x0, size_t y0, size_t nx, size_t ny)
+{
+    auto diff = timestep - _start; // a duration
+
+    auto offset = diff.total_seconds() / _timestep.total_seconds();
+
+    return get_var(var, offset, x0, y0, nx, ny);
 }
\ No newline at end of file
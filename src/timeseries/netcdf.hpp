@@ -28,6 +28,9 @@
 #include <boost/date_time/posix_time/posix_time.hpp> // for boost::posix
 #include <netcdf>
 #include <string>
+#include <vector>
+#include <map>
+#include <mutex>
 
 #include "logger.hpp"
 #include "exception.hpp"
@@ -83,9 +86,107 @@ public:
     double get_var(std::string var, size_t timestep, size_t x, size_t y);
     double get_var(std::string var, boost::posix_time::ptime timestep, size_t x, size_t y);
 
+    /**
+     * Reads the [y0, y0+ny) x [x0, x0+nx) window of a variable for one timestep with a single read.
+     * The returned array is indexed [y-y0][x-x0]. Fill values are replaced with NaN.
+     * @param var
+     * @param timestep
+     * @param x0
+     * @param y0
+     * @param nx
+     * @param ny
+     * @return
+     */
+    data get_var(std::string var, size_t timestep, size_t x0, size_t y0, size_t nx, size_t ny);
+    data get_var(std::string var, boost::posix_time::ptime timestep, size_t x0, size_t y0, size_t nx, size_t ny);
+
     void add_dim1D(const std::string& var, size_t length);
     void create_variable1D(const std::string& var,  size_t length);
     void put_var1D(const std::string& var, size_t index, double value);
+
+    /**
+     * Writes a whole 1D variable with a single put, creating it if needed.
+     * @param var
+     * @param values
+     */
+    void put_var1D(const std::string& var, std::vector<double> values);
+
+    /**
+     * Reads a whole 1D variable with a single get. Fill values are replaced with NaN.
+     * @param var
+     * @return
+     */
+    std::vector<double> get_var1D(const std::string& var);
+
+    /**
+     * Builds a column of length entries from f(i), in parallel, and writes it with one put.
+     * f is called from multiple threads.
+     * @param var
+     * @param length
+     * @param f double(size_t i)
+     */
+    template<typename F>
+    void put_column(const std::string& var, size_t length, F f)
+    {
+        std::vector<double> values(length);
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < length; i++)
+        {
+            values[i] = f(i);
+        }
+
+        put_var1D(var, std::move(values));
+    }
+
+    /**
+     * Reads a whole column with one get and hands each entry to f(i, value), in parallel.
+     * f is called from multiple threads.
+     * Throws if the column does not have length entries, e.g., a checkpoint from a different mesh or partition.
+     * @param var
+     * @param length
+     * @param f void(size_t i, double value)
+     */
+    template<typename F>
+    void get_column(const std::string& var, size_t length, F f)
+    {
+        auto values = get_var1D(var);
+
+        if (values.size() != length)
+        {
+            CHM_THROW_EXCEPTION(model_init_error,
+                                "Variable " + var + " in " + _file + " has " + std::to_string(values.size()) +
+                                    " entries but " + std::to_string(length) + " were expected. Was it written for a "
+                                    "different mesh or partition?");
+        }
+
+        #pragma omp parallel for
+        for (size_t i = 0; i < values.size(); i++)
+        {
+            f(i, values[i]);
+        }
+    }
+
+    /**
+     * Compression and chunking for 1D variables created after this call. Requires a netCDF-4 file.
+     * @param deflate_level 0 (off) to 9
+     * @param chunk_size Entries per chunk, 0 lets the library decide
+     */
+    void set_compression(int deflate_level, size_t chunk_size = 0);
+
+    /**
+     * Redirects the 1D variable writes (create_variable1D, put_var1D, put_column) into an in-memory staging buffer
+     * instead of a file. This does not touch the netCDF library, so it is fast and the file can then be written
+     * with write_staged on another thread while the model continues.
+     */
+    void stage();
+
+    /**
+     * Creates file and writes every staged 1D variable to it, one put per variable, then clears the staging buffer.
+     * Attributes may be added to get_ncfile() afterwards.
+     * @param file
+     */
+    void write_staged(const std::string& file);
     /**
      * Some data, such as lat/long do not have a time component are only 2 data. This allows loading those data.
      * @param var
@@ -97,9 +198,17 @@ public:
     double get_var2D(std::string var, size_t x, size_t y);
 
     netCDF::NcFile& get_ncfile();
+
+    /**
+     * The netCDF library is not thread safe, even across different files. Everything in this class that calls into the
+     * library holds this lock, which allows the forcing to be read on a background thread.
+     * @return
+     */
+    static std::recursive_mutex& lib_mutex();
 private:
 
     netCDF::NcFile _data; // main netcdf file
+    std::string _file; // path of _data, for error messages
     std::string _datetime_field; // name of the datetime field, the unlimited dimension
     std::string _lat, _lon; //name of lat and long fields
     size_t xgrid, ygrid;
@@ -115,8 +224,14 @@ private:
 
     bool _is_open;
 
+    bool _staging; // 1D writes go to _staged instead of _data
+    std::map<std::string, std::vector<double>> _staged;
+
 
     //if we are creating variables
     std::vector<netCDF::NcDim> _dimVector; //we need this dimension var to create new variables
 
+    int _deflate_level; // compression of created variables, 0 = none
+    size_t _chunk_size; // chunking of created variables, 0 = library default
+
 };
\ No newline at end of file
@@ -0,0 +1,389 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+#include "timeseries_writer.hpp"
+#include "timeseries/netcdf.hpp"
+#include "logger.hpp"
+#include "exception.hpp"
+
+#include <boost/exception/errinfo_errno.hpp>
+#include <boost/exception/errinfo_file_name.hpp>
+
+#include <cerrno>
+#include <sstream>
+
+bool timeseries_writer::format_from_string(const std::string& name, format& f)
+{
+    if (name == "csv")
+        f = format::csv;
+    else if (name == "netcdf")
+        f = format::netcdf;
+    else
+        return false;
+
+    return true;
+}
+
+timeseries_writer::timeseries_writer(triangulation& domain,
+                                     const std::set<std::string>& variables,
+                                     std::vector<point> points,
+                                     size_t batch_size,
+                                     size_t queue_depth)
+    : _domain(domain), _variables(variables.begin(), variables.end()), _points(std::move(points)),
+      _batch_size(std::max<size_t>(batch_size, 1)), _queue_depth(queue_depth), _allocated(0), _stop(false),
+      _closed(false)
+{
+    // resolve the variables and the points' rows once, record only does indexed loads
+    for (auto& v : _variables)
+        _handles.push_back(_domain.face_variables().handle(v));
+
+    for (auto& p : _points)
+        _storage_ids.push_back(p.face->storage_id);
+
+    for (size_t p = 0; p < _points.size(); ++p)
+    {
+        _sinks.emplace_back(new sink());
+        open(p);
+    }
+
+    _current = std::make_shared<batch>();
+    _current->time.resize(_batch_size);
+    _current->values.resize(_points.size() * _batch_size * _variables.size());
+
+    if (_queue_depth > 0)
+        _thread = std::thread(&timeseries_writer::run, this);
+}
+
+timeseries_writer::~timeseries_writer()
+{
+    try
+    {
+        finish();
+    }
+    catch (...)
+    {
+        // already reported by the writer thread, and a destructor can't throw
+    }
+}
+
+void timeseries_writer::open(size_t p)
+{
+    auto& pt = _points[p];
+    auto& s = *_sinks[p];
+
+    if (pt.fmt == format::csv)
+    {
+        s.csv.open(pt.file.c_str());
+        if (!s.csv.is_open())
+            BOOST_THROW_EXCEPTION(file_write_error() << boost::errinfo_errno(errno)
+                                                     << boost::errinfo_file_name(pt.file));
+
+        s.csv << "datetime";
+        for (auto& v : _variables)
+            s.csv << "," << v;
+        s.csv << std::endl;
+        return;
+    }
+
+    std::lock_guard<std::recursive_mutex> lock(netcdf::lib_mutex());
+
+    s.nc.open(pt.file.c_str(), netCDF::NcFile::replace);
+    s.nc.putAtt("name", pt.name);
+    s.nc.putAtt("longitude", netCDF::ncDouble, pt.longitude);
+    s.nc.putAtt("latitude", netCDF::ncDouble, pt.latitude);
+
+    // unlimited, so each batch is appended
+    auto time = s.nc.addDim("time");
+
+    s.nc_time = s.nc.addVar("time", netCDF::ncInt64, time);
+    s.nc_time.putAtt("units", "seconds since 1970-01-01 00:00:00");
+    s.nc_time.putAtt("calendar", "standard");
+
+    for (auto& v : _variables)
+    {
+        auto var = s.nc.addVar(v, netCDF::ncDouble, time);
+        var.putAtt("_FillValue", netCDF::ncDouble, -9999.0);
+        s.nc_vars.push_back(var);
+    }
+}
+
+void timeseries_writer::record(const boost::posix_time::ptime& time)
+{
+    rethrow();
+
+    auto& b = *_current;
+    const size_t nvar = _variables.size();
+    const size_t row = b.rows;
+    auto& fv = _domain.face_variables();
+
+    b.time[row] = time;
+    for (size_t p = 0; p < _points.size(); ++p)
+    {
+        double* values = &b.values[(p * _batch_size + row) * nvar];
+        for (size_t k = 0; k < nvar; ++k)
+            values[k] = fv(_handles[k], _storage_ids[p]);
+    }
+
+    if (++b.rows == _batch_size)
+        submit();
+}
+
+void timeseries_writer::submit()
+{
+    if (_queue_depth == 0)
+    {
+        try
+        {
+            write(*_current);
+        }
+        catch (...)
+        {
+            // sticky, as for the writer thread, so later calls fail instead of overrunning the batch
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+        }
+        _current->rows = 0;
+        rethrow();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+
+    _queue.push_back(_current);
+    _current = nullptr;
+    _queued.notify_one();
+
+    // back-pressure: wait for a buffer once queue_depth batches are in flight
+    if (_pool.empty() && _allocated >= _queue_depth)
+    {
+        LOG_DEBUG << "Timeseries output queue is full, waiting for the writer";
+        _released.wait(lock, [this] { return !_pool.empty() || _error; });
+    }
+
+    if (_error)
+    {
+        lock.unlock();
+        rethrow();
+    }
+
+    if (!_pool.empty())
+    {
+        _current = _pool.back();
+        _pool.pop_back();
+    }
+    else
+    {
+        _current = std::make_shared<batch>();
+        _current->time.resize(_batch_size);
+        _current->values.resize(_points.size() * _batch_size * _variables.size());
+        ++_allocated;
+    }
+}
+
+void timeseries_writer::finish()
+{
+    if (_closed)
+    {
+        rethrow();
+        return;
+    }
+    _closed = true;
+
+    bool failed = false;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        failed = static_cast<bool>(_error);
+    }
+
+    // the partial last batch
+    if (!failed && _current && _current->rows > 0)
+    {
+        if (_queue_depth == 0)
+        {
+            try
+            {
+                write(*_current);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _error = std::current_exception();
+            }
+        }
+        else
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _queue.push_back(_current);
+        }
+        _current = nullptr;
+    }
+
+    if (_thread.joinable())
+    {
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _stop = true;
+        }
+        _queued.notify_one();
+        _thread.join();
+    }
+
+    close();
+    rethrow();
+}
+
+void timeseries_writer::run()
+{
+    while (true)
+    {
+        std::shared_ptr<batch> b;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _queued.wait(lock, [this] { return _stop || !_queue.empty(); });
+
+            // drain the queue before stopping so no output is lost
+            if (_queue.empty())
+                return;
+
+            b = _queue.front();
+            _queue.pop_front();
+        }
+
+        try
+        {
+            write(*b);
+        }
+        catch (...)
+        {
+            LOG_ERROR << "Writing the timeseries output failed";
+            std::lock_guard<std::mutex> lock(_mutex);
+            _error = std::current_exception();
+            _queue.clear();
+            _released.notify_all();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            b->rows = 0;
+            _pool.push_back(b);
+        }
+        _released.notify_one();
+    }
+}
+
+void timeseries_writer::write(const batch& b)
+{
+    for (size_t p = 0; p < _points.size(); ++p)
+    {
+        if (_points[p].fmt == format::csv)
+            write_csv(p, b);
+        else
+            write_netcdf(p, b);
+    }
+}
+
+void timeseries_writer::write_csv(size_t p, const batch& b)
+{
+    const size_t nvar = _variables.size();
+
+    // build the whole batch first so the file sees one write
+    std::ostringstream ss;
+    for (size_t r = 0; r < b.rows; ++r)
+    {
+        ss << boost::posix_time::to_iso_string(b.time[r]);
+        const double* values = &b.values[(p * _batch_size + r) * nvar];
+        for (size_t k = 0; k < nvar; ++k)
+            ss << "," << values[k];
+        ss << "\n";
+    }
+
+    auto& s = *_sinks[p];
+    s.csv << ss.str();
+    s.csv.flush();
+
+    if (!s.csv)
+        BOOST_THROW_EXCEPTION(file_write_error() << boost::errinfo_errno(errno)
+                                                 << boost::errinfo_file_name(_points[p].file));
+    s.records += b.rows;
+}
+
+void timeseries_writer::write_netcdf(size_t p, const batch& b)
+{
+    const size_t nvar = _variables.size();
+    auto& s = *_sinks[p];
+
+    static const boost::posix_time::ptime epoch(boost::gregorian::date(1970, 1, 1));
+    std::vector<long long> time(b.rows);
+    for (size_t r = 0; r < b.rows; ++r)
+        time[r] = (b.time[r] - epoch).total_seconds();
+
+    std::vector<size_t> start{s.records};
+    std::vector<size_t> count{b.rows};
+    std::vector<double> column(b.rows);
+
+    std::lock_guard<std::recursive_mutex> lock(netcdf::lib_mutex());
+
+    s.nc_time.putVar(start, count, time.data());
+    for (size_t k = 0; k < nvar; ++k)
+    {
+        for (size_t r = 0; r < b.rows; ++r)
+            column[r] = b.values[(p * _batch_size + r) * nvar + k];
+        s.nc_vars[k].putVar(start, count, column.data());
+    }
+
+    // so a failed run can still be read up to here
+    s.nc.sync();
+    s.records += b.rows;
+}
+
+void timeseries_writer::close()
+{
+    for (size_t p = 0; p < _points.size(); ++p)
+    {
+        auto& s = *_sinks[p];
+        if (_points[p].fmt == format::csv)
+        {
+            s.csv.close();
+        }
+        else
+        {
+            std::lock_guard<std::recursive_mutex> lock(netcdf::lib_mutex());
+            s.nc.close();
+        }
+    }
+}
+
+void timeseries_writer::rethrow()
+{
+    // the error is kept, the writer thread has stopped so every later record has to fail too
+    std::exception_ptr error;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        error = _error;
+    }
+
+    if (error)
+        std::rethrow_exception(error);
+}
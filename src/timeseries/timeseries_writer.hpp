@@ -0,0 +1,161 @@
+//
+// Canadian Hydrological Model - The Canadian Hydrological Model (CHM) is a novel
+// modular unstructured mesh based approach for hydrological modelling
+// Copyright (C) 2018 Christopher Marsh
+//
+// This file is part of Canadian Hydrological Model.
+//
+// Canadian Hydrological Model is free software: you can redistribute it and/or
+// modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// Canadian Hydrological Model is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Canadian Hydrological Model.  If not, see
+// <http://www.gnu.org/licenses/>.
+//
+
+
+
+#pragma once
+
+#include "triangulation.hpp"
+
+#include <boost/date_time/posix_time/posix_time.hpp>
+#include <netcdf>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Streams the point timeseries outputs to file while the model runs.
+ *
+ * Every timestep, record() copies each output variable at each output point into the current batch, reading the face
+ * variable columns through handles resolved once at construction. Once batch_size timesteps are recorded the batch is
+ * handed to a dedicated thread that appends it to each point's file, so memory use does not grow with the length of
+ * the run and a failed run keeps everything up to the last written batch. At most queue_depth full batches wait to be
+ * written; record() blocks once they are all queued. With a queue depth of 0 the batches are written by the calling
+ * thread.
+ *
+ * Each point is written either as csv, a datetime column then one column per variable, or as NetCDF with an unlimited
+ * time dimension that is appended to.
+ */
+class timeseries_writer
+{
+  public:
+    enum class format
+    {
+        csv,
+        netcdf
+    };
+
+    /**
+     * Parses a format name (csv, netcdf)
+     * @param name
+     * @param f Set to the format if the name is known
+     * @return false if the name is not a known format
+     */
+    static bool format_from_string(const std::string& name, format& f);
+
+    struct point
+    {
+        std::string name;
+        std::string file;
+        format fmt;
+        mesh_elem face;
+        double longitude;
+        double latitude;
+    };
+
+    /**
+     * Creates every point's file and writes its header
+     * @param domain
+     * @param variables Face variables to write, in this column order
+     * @param points
+     * @param batch_size # of timesteps buffered before they are written
+     * @param queue_depth # of full batches that may wait to be written. 0 writes synchronously
+     */
+    timeseries_writer(triangulation& domain,
+                      const std::set<std::string>& variables,
+                      std::vector<point> points,
+                      size_t batch_size,
+                      size_t queue_depth);
+    ~timeseries_writer();
+
+    /**
+     * Records the current value of every variable at every point. Call once per timestep, after the modules have run.
+     * Rethrows any exception from a previous write.
+     * @param time
+     */
+    void record(const boost::posix_time::ptime& time);
+
+    /**
+     * Writes any partially filled batch, waits for all queued writes, stops the writer thread and closes the files.
+     * Rethrows any exception from a write.
+     */
+    void finish();
+
+  private:
+    struct batch
+    {
+        size_t rows = 0;
+        std::vector<boost::posix_time::ptime> time;
+        std::vector<double> values; // point p, row r, variable k is at (p * batch_size + r) * nvariables + k
+    };
+
+    // the open file of one point
+    struct sink
+    {
+        std::ofstream csv;
+        netCDF::NcFile nc;
+        netCDF::NcVar nc_time;
+        std::vector<netCDF::NcVar> nc_vars;
+        size_t records = 0;
+    };
+
+    void open(size_t p);
+    void submit();
+    void write(const batch& b);
+    void write_csv(size_t p, const batch& b);
+    void write_netcdf(size_t p, const batch& b);
+    void close();
+    void run();
+    void rethrow();
+
+    triangulation& _domain;
+    std::vector<std::string> _variables;
+    std::vector<var_handle> _handles;
+    std::vector<point> _points;
+    std::vector<size_t> _storage_ids;
+    std::vector<std::unique_ptr<sink>> _sinks;
+    size_t _batch_size;
+    size_t _queue_depth;
+
+    std::shared_ptr<batch> _current; // being filled by record
+
+    std::mutex _mutex;
+    std::condition_variable _queued;   // a batch was queued, or stop was requested
+    std::condition_variable _released; // a batch went back to the pool
+    std::deque<std::shared_ptr<batch>> _queue;
+    std::vector<std::shared_ptr<batch>> _pool;
+    size_t _allocated;                 // batches in the pool, the queue, or being written, excluding _current
+    bool _stop;
+    bool _closed;
+    std::exception_ptr _error;
+
+    std::thread _thread;
+};